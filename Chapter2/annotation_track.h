@@ -0,0 +1,64 @@
+#ifndef ANNOTATION_TRACK_H
+#define ANNOTATION_TRACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+// one marked event of a signal, e.g. a detected R-peak
+struct SAnnotation
+{
+    // sample index in the lead's stream
+    uint64_t sample;
+    // signal value at the event
+    float value;
+    // seconds since the previous event of the same track, 0 for the first
+    float interval;
+};
+
+// Time-indexed annotations of one lead. Detectors run causally, so events
+// arrive in sample order and Add() is an append; the renderer then finds the
+// events of the visible window with two binary searches.
+class CAnnotationTrack
+{
+public:
+    void Add(const SAnnotation& a_annotation)
+    {
+        if (m_annotations.empty() || m_annotations.back().sample <= a_annotation.sample)
+        {
+            m_annotations.push_back(a_annotation);
+            return;
+        }
+        // late event (e.g. found by a search back): keep the order
+        m_annotations.insert(std::upper_bound(m_annotations.begin(), m_annotations.end(), a_annotation,
+                                              p_Earlier), a_annotation);
+    }
+
+    // events with a_begin <= sample < a_end; returns their number and points
+    // a_first at the earliest, valid until the next Add()
+    size_t Query(uint64_t a_begin, uint64_t a_end, const SAnnotation** a_first) const
+    {
+        SAnnotation l_begin = {a_begin, 0.0f, 0.0f};
+        SAnnotation l_end = {a_end, 0.0f, 0.0f};
+        std::vector<SAnnotation>::const_iterator l_first =
+            std::lower_bound(m_annotations.begin(), m_annotations.end(), l_begin, p_Earlier);
+        std::vector<SAnnotation>::const_iterator l_last =
+            std::lower_bound(l_first, m_annotations.end(), l_end, p_Earlier);
+        *a_first = l_first == m_annotations.end() ? NULL : &*l_first;
+        return l_last - l_first;
+    }
+
+    size_t Size() const { return m_annotations.size(); }
+    const SAnnotation& Last() const { return m_annotations.back(); }
+
+private:
+    std::vector<SAnnotation> m_annotations;
+
+    static bool p_Earlier(const SAnnotation& a_left, const SAnnotation& a_right)
+    {
+        return a_left.sample < a_right.sample;
+    }
+};
+
+#endif
@@ -0,0 +1,287 @@
+#ifndef BATCH_RENDERER_H
+#define BATCH_RENDERER_H
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+#include "gl_functions.h"
+
+// Batched 2-D primitive renderer. Primitives are collected on the CPU during
+// the frame, consecutive ones with the same (primitive type, point size /
+// line width) into one batch, and at the end of the frame copied into a
+// triple-buffered vertex buffer and drawn with one glDrawArrays call per
+// batch. Draws keep the order they were issued in, so overlapping primitives
+// stack like they would when drawn one by one; callers that alternate
+// between states get one draw per run of the same state.
+//
+// When the driver supports ARB_buffer_storage the vertex buffer is mapped
+// once, persistently, and each of the three regions is only rewritten after
+// the fence placed behind its last draw has signalled. Older contexts fall
+// back to orphaning the buffer every frame, and contexts without buffer
+// objects draw straight from client memory.
+//
+// TVertex is the wire format and must start with x, y, z followed by r, g, b, a
+// (the Vertex struct of the demos).
+template <typename TVertex>
+class CBatchRenderer
+{
+public:
+    static const int NUM_REGIONS = 3;
+
+    CBatchRenderer()
+        : m_numBatches(0), m_buffer(0), m_mapped(NULL), m_capacity(0), m_region(0), m_persistent(false)
+    {
+        for (int i = 0; i < NUM_REGIONS; ++i)
+            m_fences[i] = 0;
+    }
+
+    ~CBatchRenderer()
+    {
+        Release();
+    }
+
+    // needs a current context, a_capacity is the number of vertices per frame
+    void Init(size_t a_capacity)
+    {
+        LoadGLFunctions();
+        m_persistent = g_gl.hasPersistentMapping;
+        p_CreateBuffer(a_capacity);
+    }
+
+    void Release()
+    {
+        p_DestroyBuffer();
+    }
+
+    void AddPoint(const TVertex& a_vertex, GLfloat a_size)
+    {
+        p_Batch(GL_POINTS, a_size).push_back(a_vertex);
+    }
+
+    void AddLine(const TVertex& a_vertex1, const TVertex& a_vertex2, GLfloat a_width)
+    {
+        std::vector<TVertex>& l_batch = p_Batch(GL_LINES, a_width);
+        l_batch.push_back(a_vertex1);
+        l_batch.push_back(a_vertex2);
+    }
+
+    // strips are split into independent segments so that several of them
+    // can share one GL_LINES draw
+    void AddLineStrip(const TVertex* a_vertices, size_t a_count, GLfloat a_width)
+    {
+        if (a_count < 2)
+            return;
+        std::vector<TVertex>& l_batch = p_Batch(GL_LINES, a_width);
+        for (size_t i = 0; i + 1 < a_count; ++i)
+        {
+            l_batch.push_back(a_vertices[i]);
+            l_batch.push_back(a_vertices[i+1]);
+        }
+    }
+
+    void AddTriangle(const TVertex& a_vertex1, const TVertex& a_vertex2, const TVertex& a_vertex3)
+    {
+        std::vector<TVertex>& l_batch = p_Batch(GL_TRIANGLES, 1.0f);
+        l_batch.push_back(a_vertex1);
+        l_batch.push_back(a_vertex2);
+        l_batch.push_back(a_vertex3);
+    }
+
+    // upload everything collected since the last call and draw it in the
+    // order it was added
+    void Flush()
+    {
+        size_t l_total = 0;
+        for (size_t i = 0; i < m_numBatches; ++i)
+            l_total += m_batches[i].vertices.size();
+        if (l_total == 0)
+        {
+            m_numBatches = 0;
+            return;
+        }
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+
+        size_t l_offset = 0;
+        if (m_buffer)
+        {
+            if (l_total > m_capacity)
+            {
+                // grow to fit this frame, the next frames will not need it again
+                p_DestroyBuffer();
+                p_CreateBuffer(l_total * 2);
+            }
+            l_offset = p_Upload();
+        }
+
+        for (size_t i = 0; i < m_numBatches; ++i)
+        {
+            SBatch& l_batch = m_batches[i];
+            const size_t l_count = l_batch.vertices.size();
+            if (l_count == 0)
+                continue;
+
+            // with a bound buffer the pointers are byte offsets into it,
+            // without buffer objects they refer to client memory
+            const char* l_pointer = m_buffer ? (const char*)l_offset : (const char*)&l_batch.vertices[0];
+            glVertexPointer(3, GL_FLOAT, sizeof(TVertex), l_pointer + offsetof(TVertex, x));
+            glColorPointer(4, GL_FLOAT, sizeof(TVertex), l_pointer + offsetof(TVertex, r));
+
+            if (l_batch.mode == GL_POINTS)
+                glPointSize(l_batch.size);
+            else if (l_batch.mode == GL_LINES)
+                glLineWidth(l_batch.size);
+            glDrawArrays(l_batch.mode, 0, (GLsizei)l_count);
+
+            l_offset += l_count * sizeof(TVertex);
+            l_batch.vertices.clear();
+        }
+        m_numBatches = 0;
+
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        if (m_buffer)
+        {
+            if (m_persistent)
+                m_fences[m_region] = g_gl.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+            m_region = (m_region + 1) % NUM_REGIONS;
+        }
+    }
+
+private:
+    struct SBatch
+    {
+        GLenum mode;
+        GLfloat size;
+        // capacity is kept between frames so steady state frames do not allocate
+        std::vector<TVertex> vertices;
+    };
+
+    // the first m_numBatches are in use this frame, the others keep their
+    // capacity for later frames
+    std::vector<SBatch> m_batches;
+    size_t m_numBatches;
+    GLuint m_buffer;
+    char* m_mapped;
+    size_t m_capacity;
+    int m_region;
+    bool m_persistent;
+    GLsync m_fences[NUM_REGIONS];
+
+    // the last batch if it has the same state, so the order is kept
+    std::vector<TVertex>& p_Batch(GLenum a_mode, GLfloat a_size)
+    {
+        if (m_numBatches > 0)
+        {
+            SBatch& l_last = m_batches[m_numBatches - 1];
+            if (l_last.mode == a_mode && l_last.size == a_size)
+                return l_last.vertices;
+        }
+        if (m_numBatches == m_batches.size())
+            m_batches.push_back(SBatch());
+        SBatch& l_batch = m_batches[m_numBatches++];
+        l_batch.mode = a_mode;
+        l_batch.size = a_size;
+        l_batch.vertices.clear();
+        return l_batch.vertices;
+    }
+
+    void p_CreateBuffer(size_t a_capacity)
+    {
+        if (!g_gl.hasBuffers)
+            return;
+        m_capacity = a_capacity;
+        const GLsizeiptr l_bytes = NUM_REGIONS * m_capacity * sizeof(TVertex);
+        g_gl.GenBuffers(1, &m_buffer);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        if (m_persistent)
+        {
+            const GLbitfield l_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            g_gl.BufferStorage(GL_ARRAY_BUFFER, l_bytes, NULL, l_flags);
+            m_mapped = (char*)g_gl.MapBufferRange(GL_ARRAY_BUFFER, 0, l_bytes, l_flags);
+            if (!m_mapped)
+            {
+                // storage is immutable, start over with a plain buffer
+                m_persistent = false;
+                g_gl.DeleteBuffers(1, &m_buffer);
+                g_gl.GenBuffers(1, &m_buffer);
+                g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            }
+        }
+        if (!m_persistent)
+            g_gl.BufferData(GL_ARRAY_BUFFER, l_bytes, NULL, GL_STREAM_DRAW);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void p_DestroyBuffer()
+    {
+        if (!m_buffer)
+            return;
+        for (int i = 0; i < NUM_REGIONS; ++i)
+        {
+            if (m_fences[i])
+            {
+                g_gl.DeleteSync(m_fences[i]);
+                m_fences[i] = 0;
+            }
+        }
+        if (m_mapped)
+        {
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            g_gl.UnmapBuffer(GL_ARRAY_BUFFER);
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+            m_mapped = NULL;
+        }
+        g_gl.DeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+
+    // copies all batches back to back into the current region, leaves the
+    // buffer bound and returns the byte offset of the region
+    size_t p_Upload()
+    {
+        const size_t l_regionOffset = m_region * m_capacity * sizeof(TVertex);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        if (m_persistent)
+        {
+            // the GPU may still be reading this region from three frames ago
+            if (m_fences[m_region])
+            {
+                while (g_gl.ClientWaitSync(m_fences[m_region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+                {
+                }
+                g_gl.DeleteSync(m_fences[m_region]);
+                m_fences[m_region] = 0;
+            }
+            char* l_dst = m_mapped + l_regionOffset;
+            for (size_t i = 0; i < m_numBatches; ++i)
+            {
+                const size_t l_bytes = m_batches[i].vertices.size() * sizeof(TVertex);
+                if (l_bytes)
+                    memcpy(l_dst, &m_batches[i].vertices[0], l_bytes);
+                l_dst += l_bytes;
+            }
+        }
+        else
+        {
+            // orphan the storage on the first region so the driver can hand
+            // out fresh memory instead of synchronizing with the GPU
+            if (m_region == 0)
+                g_gl.BufferData(GL_ARRAY_BUFFER, NUM_REGIONS * m_capacity * sizeof(TVertex), NULL, GL_STREAM_DRAW);
+            size_t l_offset = l_regionOffset;
+            for (size_t i = 0; i < m_numBatches; ++i)
+            {
+                const size_t l_bytes = m_batches[i].vertices.size() * sizeof(TVertex);
+                if (l_bytes)
+                    g_gl.BufferSubData(GL_ARRAY_BUFFER, l_offset, l_bytes, &m_batches[i].vertices[0]);
+                l_offset += l_bytes;
+            }
+        }
+        return l_regionOffset;
+    }
+};
+
+#endif
@@ -0,0 +1,8 @@
+#!/bin/bash
+# builds the benchmarks, each one prints its usage at the top of its source
+g++ -O2 -Wall -std=c++11 -o bench_decimation bench_decimation.cpp
+g++ -O2 -Wall -std=c++11 -o bench_vmath bench_vmath.cpp
+g++ -O2 -Wall -std=c++11 -pthread -o bench_filter bench_filter.cpp
+g++ -O2 -Wall -std=c++11 -o bench_qrs bench_qrs.cpp
+g++ -O2 -Wall -std=c++11 `pkg-config --cflags glfw3` -o bench_spectrogram bench_spectrogram.cpp `pkg-config --static --libs glfw3` -framework OpenGL
+g++ -O2 -Wall -std=c++11 -o bench_spatial_index bench_spatial_index.cpp
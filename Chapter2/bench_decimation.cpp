@@ -0,0 +1,145 @@
+// Benchmark of the per-frame cost of plotting one ECG lead as the recording
+// grows from 10^3 to 10^8 samples (see decimation.h and minmax_pyramid.h).
+//
+//   g++ -O2 -std=c++11 -o bench_decimation bench_decimation.cpp
+//   ./bench_decimation [max samples] [viewport width]
+//
+// For every size the whole recording is shown in a viewport of the given
+// width (1920 by default), as PlotECGData does, and three ways of building
+// the line strip are timed:
+//   raw      one vertex per sample, what PlotECGData drew before decimation
+//   m4       M4 decimation of the samples, at most 4 vertices per column
+//   pyramid  the min/max pyramid of the history view, 2 per column
+// The vertex count is what the GPU has to draw each frame: capped for m4 and
+// the pyramid, linear for raw. m4 still scans every sample on the CPU; the
+// pyramid answers the same view in O(columns), so its frame time is flat.
+
+#include "decimation.h"
+#include "minmax_pyramid.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+struct SPoint
+{
+    float x, y;
+};
+
+struct SVertex
+{
+    float x, y, z;
+    float r, g, b, a;
+};
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// repeats a_frame until at least 0.2 s have passed, returns ms per call
+template <typename F>
+static double MillisecondsPerFrame(F a_frame)
+{
+    int l_frames = 0;
+    const double l_start = Seconds();
+    double l_elapsed = 0.0;
+    do
+    {
+        a_frame();
+        ++l_frames;
+        l_elapsed = Seconds() - l_start;
+    } while (l_elapsed < 0.2);
+    return l_elapsed * 1000.0 / l_frames;
+}
+
+// a synthetic ECG-like signal: 300 Hz, a beat every 0.8 s plus noise
+static void GenerateSignal(std::vector<float>& a_samples, size_t a_count)
+{
+    a_samples.resize(a_count);
+    uint32_t l_seed = 12345;
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        l_seed = l_seed * 1664525u + 1013904223u;
+        const float l_noise = ((l_seed >> 8) / 16777216.0f - 0.5f) * 0.05f;
+        const float l_phase = fmodf((float)i, 240.0f);
+        a_samples[i] = expf(-(l_phase - 120.0f) * (l_phase - 120.0f) / 8.0f) + l_noise;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const size_t l_maxSamples = argc > 1 ? (size_t)atof(argv[1]) : (size_t)100000000;
+    const int l_columns = argc > 2 ? atoi(argv[2]) : 1920;
+
+    std::vector<float> l_samples;
+    GenerateSignal(l_samples, l_maxSamples);
+    std::vector<SPoint> l_decimated;
+    std::vector<SVertex> l_strip;
+    std::vector<float> l_min(l_columns), l_max(l_columns);
+    volatile float l_sink = 0.0f;
+
+    printf("%12s %12s %10s %12s %10s %12s %10s\n", "samples", "raw verts", "raw ms", "m4 verts", "m4 ms",
+           "pyr verts", "pyr ms");
+    for (size_t l_count = 1000; l_count <= l_maxSamples; l_count *= 10)
+    {
+        const float l_space = 2.0f / l_count;
+
+        // raw: every sample becomes a vertex
+        size_t l_rawVertices = l_count;
+        double l_rawMs = 0.0;
+        // above 10^7 vertices a frame is already far too slow; skip it
+        if (l_count <= 10000000)
+        {
+            l_rawMs = MillisecondsPerFrame([&]() {
+                l_strip.resize(l_count);
+                for (size_t i = 0; i < l_count; ++i)
+                {
+                    SVertex v = {-1.0f + i * l_space, l_samples[i], 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+                    l_strip[i] = v;
+                }
+                l_sink = l_sink + l_strip[l_count / 2].y;
+            });
+        }
+
+        // m4: decimate every sample of the window each frame
+        size_t l_m4Vertices = 0;
+        const double l_m4Ms = MillisecondsPerFrame([&]() {
+            l_decimated.resize(4 * (size_t)l_columns > l_count ? 4 * (size_t)l_columns : l_count);
+            l_m4Vertices = DecimateM4Samples(&l_samples[0], l_count, l_columns, &l_decimated[0]);
+            l_strip.resize(l_m4Vertices);
+            for (size_t i = 0; i < l_m4Vertices; ++i)
+            {
+                SVertex v = {-1.0f + l_decimated[i].x * l_space, l_decimated[i].y, 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+                l_strip[i] = v;
+            }
+            l_sink = l_sink + l_strip[0].y;
+        });
+
+        // pyramid: built as the samples arrive, queried each frame
+        CMinMaxPyramid l_pyramid;
+        l_pyramid.Append(&l_samples[0], l_count);
+        int l_pyramidColumns = 0;
+        const double l_pyramidMs = MillisecondsPerFrame([&]() {
+            l_pyramidColumns = l_pyramid.Query(0, l_count, l_columns, &l_min[0], &l_max[0]);
+            l_strip.resize(2 * (size_t)l_pyramidColumns);
+            for (int i = 0; i < l_pyramidColumns; ++i)
+            {
+                SVertex l_low = {-1.0f + 2.0f * i / l_columns, l_min[i], 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+                SVertex l_high = {-1.0f + 2.0f * i / l_columns, l_max[i], 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+                l_strip[2 * i] = l_low;
+                l_strip[2 * i + 1] = l_high;
+            }
+            l_sink = l_sink + l_strip[0].y;
+        });
+
+        if (l_rawMs > 0.0)
+            printf("%12zu %12zu %10.3f ", l_count, l_rawVertices, l_rawMs);
+        else
+            printf("%12zu %12zu %10s ", l_count, l_rawVertices, "-");
+        printf("%12zu %10.3f %12d %10.3f\n", l_m4Vertices, l_m4Ms, 2 * l_pyramidColumns, l_pyramidMs);
+    }
+    return 0;
+}
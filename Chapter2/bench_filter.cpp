@@ -0,0 +1,134 @@
+// Benchmark of the live ECG filter chain of ecg_filter.h in channel-samples
+// per second, the unit CECGFilterStage reports at exit.
+//
+//   g++ -O2 -std=c++11 -pthread -o bench_filter bench_filter.cpp
+//   ./bench_filter [seconds of signal] [sample rate]
+//
+// The chain is the one main.cpp starts: 0.5 Hz high pass, 50 Hz notch and a
+// 61 tap linear phase low pass FIR, at 300 Hz by default. For a growing
+// number of leads the signal is filtered in the 256 sample blocks of the
+// filter stage, with and without the FIR, and compared with the same
+// biquads run one lead at a time without the SIMD lanes. The last column
+// is how many leads one core keeps up with in real time.
+
+#include "ecg_filter.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// a synthetic ECG-like signal with baseline wander and mains hum
+static void GenerateSignal(std::vector<float>& a_samples, size_t a_count, float a_sampleRate, int a_lead)
+{
+    a_samples.resize(a_count);
+    uint32_t l_seed = 12345 + a_lead;
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        l_seed = l_seed * 1664525u + 1013904223u;
+        const float l_t = i / a_sampleRate;
+        const float l_phase = fmodf(l_t, 0.8f) - 0.4f;
+        a_samples[i] = expf(-l_phase * l_phase / 0.0002f) + 0.3f * sinf(2.0f * (float)M_PI * 0.2f * l_t) +
+                       0.1f * sinf(2.0f * (float)M_PI * 50.0f * l_t) + ((l_seed >> 8) / 16777216.0f - 0.5f) * 0.02f;
+    }
+}
+
+// the biquads of the bank, one lead and one section at a time
+static void ScalarBiquads(const std::vector<SBiquad>& a_sections, std::vector<float>& a_state, float* a_samples,
+                          size_t a_count)
+{
+    for (size_t s = 0; s < a_sections.size(); ++s)
+    {
+        const SBiquad& l_biquad = a_sections[s];
+        float l_z1 = a_state[2 * s];
+        float l_z2 = a_state[2 * s + 1];
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const float l_x = a_samples[i];
+            const float l_y = l_biquad.b0 * l_x + l_z1;
+            l_z1 = l_biquad.b1 * l_x - l_biquad.a1 * l_y + l_z2;
+            l_z2 = l_biquad.b2 * l_x - l_biquad.a2 * l_y;
+            a_samples[i] = l_y;
+        }
+        a_state[2 * s] = l_z1;
+        a_state[2 * s + 1] = l_z2;
+    }
+}
+
+// filters every lead in a_blockSize pieces, returns channel-samples per second
+static double FilterBank(const std::vector<std::vector<float> >& a_signal, const std::vector<SBiquad>& a_sections,
+                         const std::vector<float>& a_fir, size_t a_blockSize)
+{
+    const int l_numLeads = (int)a_signal.size();
+    const size_t l_count = a_signal[0].size();
+    std::vector<std::vector<float> > l_leads = a_signal;
+    std::vector<float*> l_pointers(l_numLeads);
+    CECGFilterBank l_bank;
+    l_bank.Init(l_numLeads, a_sections, a_fir);
+
+    const double l_start = Seconds();
+    for (size_t i = 0; i < l_count; i += a_blockSize)
+    {
+        const size_t l_block = l_count - i < a_blockSize ? l_count - i : a_blockSize;
+        for (int l = 0; l < l_numLeads; ++l)
+            l_pointers[l] = &l_leads[l][i];
+        l_bank.Process(&l_pointers[0], l_block);
+    }
+    return l_numLeads * (double)l_count / (Seconds() - l_start);
+}
+
+static double FilterScalar(const std::vector<std::vector<float> >& a_signal, const std::vector<SBiquad>& a_sections,
+                           size_t a_blockSize)
+{
+    const int l_numLeads = (int)a_signal.size();
+    const size_t l_count = a_signal[0].size();
+    std::vector<std::vector<float> > l_leads = a_signal;
+    std::vector<std::vector<float> > l_states(l_numLeads, std::vector<float>(2 * a_sections.size(), 0.0f));
+
+    const double l_start = Seconds();
+    for (size_t i = 0; i < l_count; i += a_blockSize)
+    {
+        const size_t l_block = l_count - i < a_blockSize ? l_count - i : a_blockSize;
+        for (int l = 0; l < l_numLeads; ++l)
+            ScalarBiquads(a_sections, l_states[l], &l_leads[l][i], l_block);
+    }
+    return l_numLeads * (double)l_count / (Seconds() - l_start);
+}
+
+int main(int argc, char** argv)
+{
+    const double l_seconds = argc > 1 ? atof(argv[1]) : 600.0;
+    const float l_sampleRate = argc > 2 ? (float)atof(argv[2]) : 300.0f;
+    const size_t l_count = (size_t)(l_seconds * l_sampleRate);
+    const size_t l_blockSize = CECGFilterStage::BLOCK_SIZE;
+
+    std::vector<SBiquad> l_sections;
+    l_sections.push_back(DesignHighpass(0.5f, l_sampleRate));
+    l_sections.push_back(DesignNotch(50.0f, l_sampleRate));
+    const std::vector<float> l_fir = DesignLowpassFIR(40.0f, l_sampleRate, 61);
+    const std::vector<float> l_noFir;
+
+    printf("%.0f s at %.0f Hz per lead, blocks of %zu samples, Msamples/s summed over the leads\n", l_seconds,
+           l_sampleRate, l_blockSize);
+    printf("%6s %14s %14s %14s %16s\n", "leads", "scalar biquad", "bank biquad", "bank + FIR", "real-time leads");
+    const int l_leadCounts[] = {1, 3, 4, 8, 16, 64};
+    for (size_t n = 0; n < sizeof(l_leadCounts) / sizeof(l_leadCounts[0]); ++n)
+    {
+        const int l_numLeads = l_leadCounts[n];
+        std::vector<std::vector<float> > l_signal(l_numLeads);
+        for (int l = 0; l < l_numLeads; ++l)
+            GenerateSignal(l_signal[l], l_count, l_sampleRate, l);
+
+        const double l_scalar = FilterScalar(l_signal, l_sections, l_blockSize);
+        const double l_biquads = FilterBank(l_signal, l_sections, l_noFir, l_blockSize);
+        const double l_full = FilterBank(l_signal, l_sections, l_fir, l_blockSize);
+        printf("%6d %14.1f %14.1f %14.1f %16.0f\n", l_numLeads, l_scalar / 1.0e6, l_biquads / 1.0e6,
+               l_full / 1.0e6, l_full / l_sampleRate);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Benchmark of the QRS detector of qrs_detector.h over a long recording.
+//
+//   g++ -O2 -std=c++11 -o bench_qrs bench_qrs.cpp
+//   ./ecg_convert --from-header holter.ecg 3 24
+//   ./bench_qrs holter.ecg
+//
+// Every lead of the recording goes through its own detector, the way main.cpp
+// runs one per live lead, in blocks of the filter stage's size. The detector
+// reads the mapped file in place, so the first run also measures the page
+// cache filling up; the time spent reading alone is printed first for
+// comparison. For each lead the beats found, the average rate and the
+// throughput in samples/s and as a multiple of real time are printed.
+
+#include "ecg_recording.h"
+#include "qrs_detector.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#define BENCH_QRS_BLOCK_SIZE  256
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// copies samples [a_begin, a_begin + a_count) of a lead into a_block
+static void ReadBlock(const CECGRecording& a_recording, uint32_t a_lead, uint64_t a_begin, size_t a_count,
+                      float* a_block)
+{
+    const float* l_lead = a_recording.Lead(a_lead);
+    const size_t l_stride = a_recording.Stride();
+    for (size_t i = 0; i < a_count; ++i)
+        a_block[i] = l_lead[(a_begin + i) * l_stride];
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s recording.ecg\n"
+               "  a long recording is made with: ./ecg_convert --from-header holter.ecg 3 24\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    CECGRecording l_recording;
+    if (!l_recording.Open(argv[1]))
+        return EXIT_FAILURE;
+
+    const uint64_t l_numSamples = l_recording.NumSamples();
+    const float l_sampleRate = l_recording.SampleRate();
+    const double l_duration = l_numSamples / l_sampleRate;
+    printf("%s: %u leads, %llu samples per lead at %.0f Hz, %.2f hours\n", argv[1], l_recording.NumLeads(),
+           (unsigned long long)l_numSamples, l_sampleRate, l_duration / 3600.0);
+
+    float l_block[BENCH_QRS_BLOCK_SIZE];
+    volatile float l_sink = 0.0f;
+    double l_start = Seconds();
+    for (uint32_t l = 0; l < l_recording.NumLeads(); ++l)
+    {
+        for (uint64_t i = 0; i < l_numSamples; i += BENCH_QRS_BLOCK_SIZE)
+        {
+            const size_t l_count = l_numSamples - i < BENCH_QRS_BLOCK_SIZE ? (size_t)(l_numSamples - i)
+                                                                            : BENCH_QRS_BLOCK_SIZE;
+            ReadBlock(l_recording, l, i, l_count, l_block);
+            l_sink = l_sink + l_block[0];
+        }
+    }
+    printf("reading every lead alone: %.3f s\n\n", Seconds() - l_start);
+
+    printf("%6s %10s %10s %12s %14s %12s\n", "lead", "beats", "mean bpm", "seconds", "Msamples/s", "x real time");
+    for (uint32_t l = 0; l < l_recording.NumLeads(); ++l)
+    {
+        CQRSDetector l_detector(l_sampleRate);
+        l_start = Seconds();
+        for (uint64_t i = 0; i < l_numSamples; i += BENCH_QRS_BLOCK_SIZE)
+        {
+            const size_t l_count = l_numSamples - i < BENCH_QRS_BLOCK_SIZE ? (size_t)(l_numSamples - i)
+                                                                            : BENCH_QRS_BLOCK_SIZE;
+            ReadBlock(l_recording, l, i, l_count, l_block);
+            l_detector.Process(l_block, l_count);
+        }
+        const double l_elapsed = Seconds() - l_start;
+        const size_t l_beats = l_detector.Annotations().Size();
+        printf("%6u %10zu %10.1f %12.3f %14.1f %12.0f\n", l, l_beats, l_beats * 60.0 / l_duration, l_elapsed,
+               l_numSamples / l_elapsed / 1.0e6, l_duration / l_elapsed);
+    }
+    return EXIT_SUCCESS;
+}
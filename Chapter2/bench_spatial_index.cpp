@@ -0,0 +1,168 @@
+// Benchmark of the point picking indices CUniformGridIndex and CKdTree of
+// spatial_index.h, for the "microseconds for millions of points" of its
+// header comment.
+//
+//   g++ -O2 -std=c++11 -o bench_spatial_index bench_spatial_index.cpp
+//   ./bench_spatial_index [max points]
+//
+// Up to 10M points by default, in two layouts:
+//   uniform    spread evenly over the unit square
+//   clustered  most points in a few tight Gaussian clusters, some far outliers
+// The points are appended in blocks of 1000 as a stream would deliver them,
+// then random cursor positions are looked up with a search radius of 1% of
+// the square. The time per appended point, the time per Nearest() and the
+// share of queries that found a point are printed. The grid only runs on
+// the uniform layout: clustered points crowd into a few of its cells, which
+// is what the tree is for. A few queries of every run are checked against a
+// linear scan; the exit code is 1 when a result differs.
+
+#include "spatial_index.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#define BENCH_INDEX_BLOCK_SIZE  1000
+#define BENCH_INDEX_QUERIES  100000
+#define BENCH_INDEX_CHECKS  20
+#define BENCH_INDEX_RADIUS  0.01f
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t g_seed = 12345;
+
+// uniform in [0, 1)
+static float Random()
+{
+    g_seed = g_seed * 1664525u + 1013904223u;
+    return (g_seed >> 8) / 16777216.0f;
+}
+
+static void GeneratePoints(std::vector<float>& a_x, std::vector<float>& a_y, size_t a_count, bool a_clustered)
+{
+    a_x.resize(a_count);
+    a_y.resize(a_count);
+    const float l_centers[4][2] = {{0.2f, 0.3f}, {0.7f, 0.8f}, {0.75f, 0.25f}, {0.4f, 0.6f}};
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        if (!a_clustered)
+        {
+            a_x[i] = Random();
+            a_y[i] = Random();
+            continue;
+        }
+        if (i % 1000 == 0)
+        {
+            // an outlier far off the square
+            a_x[i] = (Random() - 0.5f) * 100.0f;
+            a_y[i] = (Random() - 0.5f) * 100.0f;
+            continue;
+        }
+        // Box-Muller around one of the centers
+        const float l_radius = sqrtf(-2.0f * logf(Random() + 1e-7f)) * 0.02f;
+        const float l_angle = 2.0f * (float)M_PI * Random();
+        const float* l_center = l_centers[i % 4];
+        a_x[i] = l_center[0] + l_radius * cosf(l_angle);
+        a_y[i] = l_center[1] + l_radius * sinf(l_angle);
+    }
+}
+
+// the same answer as Nearest() by looking at every point
+static bool ScanNearest(const std::vector<float>& a_x, const std::vector<float>& a_y, float a_qx, float a_qy,
+                        float a_maxDistance, float* a_distance)
+{
+    float l_best = a_maxDistance * a_maxDistance;
+    bool l_found = false;
+    for (size_t i = 0; i < a_x.size(); ++i)
+    {
+        const float l_dx = a_x[i] - a_qx;
+        const float l_dy = a_y[i] - a_qy;
+        const float l_distance = l_dx * l_dx + l_dy * l_dy;
+        if (l_distance <= l_best)
+        {
+            l_best = l_distance;
+            l_found = true;
+        }
+    }
+    *a_distance = sqrtf(l_best);
+    return l_found;
+}
+
+// appends a_x, a_y to a TIndex, times the queries and prints one row;
+// false when a checked query differs from the linear scan
+template <typename TIndex>
+static bool Run(const char* a_name, const char* a_layout, const std::vector<float>& a_x,
+                const std::vector<float>& a_y, const std::vector<float>& a_qx, const std::vector<float>& a_qy)
+{
+    const size_t l_count = a_x.size();
+    TIndex l_index;
+    double l_start = Seconds();
+    for (size_t i = 0; i < l_count; i += BENCH_INDEX_BLOCK_SIZE)
+        l_index.Append(&a_x[i], &a_y[i], BENCH_INDEX_BLOCK_SIZE);
+    const double l_appendSeconds = Seconds() - l_start;
+
+    size_t l_found = 0;
+    l_start = Seconds();
+    for (size_t q = 0; q < BENCH_INDEX_QUERIES; ++q)
+    {
+        uint32_t l_id;
+        if (l_index.Nearest(a_qx[q], a_qy[q], BENCH_INDEX_RADIUS, &l_id))
+            ++l_found;
+    }
+    const double l_querySeconds = Seconds() - l_start;
+
+    bool l_checked = true;
+    for (size_t q = 0; q < BENCH_INDEX_CHECKS; ++q)
+    {
+        uint32_t l_id = 0;
+        float l_distance = 0.0f, l_scanDistance = 0.0f;
+        const bool l_hit = l_index.Nearest(a_qx[q], a_qy[q], BENCH_INDEX_RADIUS, &l_id, &l_distance);
+        const bool l_scanHit = ScanNearest(a_x, a_y, a_qx[q], a_qy[q], BENCH_INDEX_RADIUS, &l_scanDistance);
+        // ties may pick another point at the same distance
+        if (l_hit != l_scanHit || (l_hit && l_distance != l_scanDistance))
+            l_checked = false;
+    }
+    printf("%-6s %-10s %10zu %14.1f %12.3f %9.1f%% %8s\n", a_name, a_layout, l_count,
+           l_appendSeconds * 1.0e9 / l_count, l_querySeconds * 1.0e6 / BENCH_INDEX_QUERIES,
+           100.0 * l_found / BENCH_INDEX_QUERIES, l_checked ? "ok" : "FAILED");
+    return l_checked;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t l_maxPoints = argc > 1 ? (size_t)atof(argv[1]) : 10000000;
+    if (l_maxPoints < BENCH_INDEX_BLOCK_SIZE)
+    {
+        printf("usage: %s [max points >= %d]\n", argv[0], BENCH_INDEX_BLOCK_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> l_x, l_y;
+    std::vector<float> l_qx(BENCH_INDEX_QUERIES), l_qy(BENCH_INDEX_QUERIES);
+    for (size_t q = 0; q < BENCH_INDEX_QUERIES; ++q)
+    {
+        l_qx[q] = Random();
+        l_qy[q] = Random();
+    }
+
+    bool l_ok = true;
+    printf("%-6s %-10s %10s %14s %12s %10s %8s\n", "index", "layout", "points", "append ns/pt", "query us",
+           "found", "check");
+    const size_t l_counts[] = {10000, 100000, 1000000, 10000000};
+    for (int l_clustered = 0; l_clustered < 2; ++l_clustered)
+    {
+        const char* l_layout = l_clustered ? "clustered" : "uniform";
+        for (size_t n = 0; n < sizeof(l_counts) / sizeof(l_counts[0]) && l_counts[n] <= l_maxPoints; ++n)
+        {
+            GeneratePoints(l_x, l_y, l_counts[n], l_clustered != 0);
+            if (!l_clustered)
+                l_ok = Run<CUniformGridIndex>("grid", l_layout, l_x, l_y, l_qx, l_qy) && l_ok;
+            l_ok = Run<CKdTree>("kdtree", l_layout, l_x, l_y, l_qx, l_qy) && l_ok;
+        }
+    }
+    return l_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
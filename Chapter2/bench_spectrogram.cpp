@@ -0,0 +1,123 @@
+// Benchmark of the live spectrogram of spectrogram.h at monitor rates.
+//
+//   g++ -O2 -std=c++11 `pkg-config --cflags glfw3` -o bench_spectrogram
+//       bench_spectrogram.cpp `pkg-config --static --libs glfw3` -framework OpenGL
+//   ./bench_spectrogram [channels] [sample rate] [seconds]
+//
+// 64 channels at 1 kHz by default, with the FFT size, hop and history of
+// main.cpp. The signal is fed the way the render loop does it: each 60 Hz
+// frame pushes the samples that arrived since the last frame into
+// Process() for every channel, then Upload() sends the new columns to the
+// textures of a hidden window. Both are timed separately and reported per
+// frame and as the fraction of one core the spectrogram needs in real time.
+
+#define GLFW_INCLUDE_GLEXT
+#include <GLFW/glfw3.h>
+
+#include "spectrogram.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#define BENCH_SPECTROGRAM_FFT_SIZE  256
+#define BENCH_SPECTROGRAM_HOP  32
+#define BENCH_SPECTROGRAM_COLUMNS  512
+#define BENCH_SPECTROGRAM_FRAME_RATE  60.0
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// a chirp over the band plus noise, different for every channel
+static void GenerateSignal(std::vector<float>& a_samples, size_t a_count, float a_sampleRate, int a_channel)
+{
+    a_samples.resize(a_count);
+    uint32_t l_seed = 12345 + a_channel;
+    double l_phase = 0.0;
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        l_seed = l_seed * 1664525u + 1013904223u;
+        const double l_frequency = (0.05 + 0.4 * fmod(i / (double)a_sampleRate + a_channel, 10.0) / 10.0) * a_sampleRate;
+        l_phase += 2.0 * M_PI * l_frequency / a_sampleRate;
+        a_samples[i] = (float)sin(l_phase) + ((l_seed >> 8) / 16777216.0f - 0.5f) * 0.1f;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const int l_numChannels = argc > 1 ? atoi(argv[1]) : 64;
+    const float l_sampleRate = argc > 2 ? (float)atof(argv[2]) : 1000.0f;
+    const double l_seconds = argc > 3 ? atof(argv[3]) : 30.0;
+    if (l_numChannels <= 0 || l_sampleRate <= 0.0f || l_seconds <= 0.0)
+    {
+        printf("usage: %s [channels] [sample rate] [seconds]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (!glfwInit())
+    {
+        printf("Failed to initialize GLFW.\n");
+        return EXIT_FAILURE;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow* l_window = glfwCreateWindow(64, 64, "bench_spectrogram", NULL, NULL);
+    if (!l_window)
+    {
+        printf("Failed to create an OpenGL context.\n");
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+    glfwMakeContextCurrent(l_window);
+
+    const size_t l_numSamples = (size_t)(l_seconds * l_sampleRate);
+    std::vector<std::vector<float> > l_signal(l_numChannels);
+    for (int c = 0; c < l_numChannels; ++c)
+        GenerateSignal(l_signal[c], l_numSamples, l_sampleRate, c);
+
+    CSpectrogram l_spectrogram;
+    l_spectrogram.Init(l_numChannels, BENCH_SPECTROGRAM_FFT_SIZE, BENCH_SPECTROGRAM_HOP, BENCH_SPECTROGRAM_COLUMNS);
+
+    // frames of the render loop; 1000 / 60 samples per frame rounds to 16 or 17
+    double l_processSeconds = 0.0;
+    double l_uploadSeconds = 0.0;
+    double l_worstFrame = 0.0;
+    size_t l_sent = 0;
+    int l_frames = 0;
+    while (l_sent < l_numSamples)
+    {
+        ++l_frames;
+        size_t l_until = (size_t)(l_frames * l_sampleRate / BENCH_SPECTROGRAM_FRAME_RATE);
+        if (l_until > l_numSamples)
+            l_until = l_numSamples;
+        const double l_start = Seconds();
+        for (int c = 0; c < l_numChannels; ++c)
+            l_spectrogram.Process(c, &l_signal[c][l_sent], l_until - l_sent);
+        const double l_processed = Seconds();
+        l_spectrogram.Upload();
+        glFinish();
+        const double l_end = Seconds();
+        l_processSeconds += l_processed - l_start;
+        l_uploadSeconds += l_end - l_processed;
+        if (l_end - l_start > l_worstFrame)
+            l_worstFrame = l_end - l_start;
+        l_sent = l_until;
+    }
+
+    const double l_columns = (double)l_numChannels * (l_numSamples / BENCH_SPECTROGRAM_HOP);
+    printf("%d channels at %.0f Hz, %.0f s of signal in %d frames, FFT %d, hop %d\n", l_numChannels, l_sampleRate,
+           l_seconds, l_frames, BENCH_SPECTROGRAM_FFT_SIZE, BENCH_SPECTROGRAM_HOP);
+    printf("process: %8.3f ms per frame, %6.2f us per column, %.1f Msamples/s\n",
+           l_processSeconds * 1000.0 / l_frames, l_processSeconds * 1.0e6 / l_columns,
+           l_numChannels * (double)l_numSamples / l_processSeconds / 1.0e6);
+    printf("upload:  %8.3f ms per frame\n", l_uploadSeconds * 1000.0 / l_frames);
+    printf("worst frame %.3f ms, %.2f%% of one core in real time\n", l_worstFrame * 1000.0,
+           100.0 * (l_processSeconds + l_uploadSeconds) / l_seconds);
+
+    l_spectrogram.Release();
+    glfwDestroyWindow(l_window);
+    glfwTerminate();
+    return EXIT_SUCCESS;
+}
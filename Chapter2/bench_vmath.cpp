@@ -0,0 +1,229 @@
+// Accuracy test and throughput benchmark of the vectorized cos/exp/log kernels
+// of vmath.h (the same file as Chapter3/vmath.h).
+//
+//   g++ -O2 -std=c++11 -o bench_vmath bench_vmath.cpp
+//   ./bench_vmath [elements]
+//
+// Every kernel set the CPU supports (scalar, SSE2, AVX2) is compared against
+// libm evaluated in double precision and rounded to float:
+//   exp  max error in ulp over [-103.9, 88.7], denormal results included
+//   log  max error in ulp over every positive float exponent
+//   cos  max absolute error over [-8192, 8192]
+// plus the edge cases of the header comment (overflow, underflow, 0, inf,
+// NaN). The exit code is 1 when any of them is out of tolerance.
+// The throughput of each kernel is then measured over an array of 1M
+// elements by default, next to the libm loop it replaces.
+
+#include "vmath.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// tolerances of the checks
+static const double MAX_EXP_ULP = 2.0;
+static const double MAX_LOG_ULP = 2.0;
+static const double MAX_COS_ERROR = 1.0e-6;
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// repeats a_frame until at least 0.2 s have passed, returns ms per call
+template <typename F>
+static double MillisecondsPerFrame(F a_frame)
+{
+    int l_frames = 0;
+    const double l_start = Seconds();
+    double l_elapsed = 0.0;
+    do
+    {
+        a_frame();
+        ++l_frames;
+        l_elapsed = Seconds() - l_start;
+    } while (l_elapsed < 0.2);
+    return l_elapsed * 1000.0 / l_frames;
+}
+
+// floats mapped to integers that are ordered like the floats, so the
+// distance between two of them is their distance in ulp
+static int64_t OrderedBits(float a_x)
+{
+    int32_t l_bits;
+    memcpy(&l_bits, &a_x, sizeof(l_bits));
+    return l_bits < 0 ? (int64_t)INT32_MIN - l_bits : l_bits;
+}
+
+static double UlpDistance(float a_x, float a_reference)
+{
+    if (a_x != a_x || a_reference != a_reference)
+        return (a_x != a_x) == (a_reference != a_reference) ? 0.0 : HUGE_VAL;
+    return fabs((double)(OrderedBits(a_x) - OrderedBits(a_reference)));
+}
+
+struct SKernelSet
+{
+    SVecMathKernels kernels;
+    bool supported;
+};
+
+static std::vector<SKernelSet> KernelSets()
+{
+    std::vector<SKernelSet> l_sets;
+    SKernelSet l_scalar = {{p_ScalarCosArray, p_ScalarExpArray, p_ScalarLogArray, "scalar"}, true};
+    l_sets.push_back(l_scalar);
+#ifdef VMATH_X86
+    __builtin_cpu_init();
+    SKernelSet l_sse = {{p_SSECosArray, p_SSEExpArray, p_SSELogArray, "SSE2"}, true};
+    SKernelSet l_avx2 = {{p_AVX2CosArray, p_AVX2ExpArray, p_AVX2LogArray, "AVX2"},
+                         __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")};
+    l_sets.push_back(l_sse);
+    l_sets.push_back(l_avx2);
+#endif
+    return l_sets;
+}
+
+static bool CheckEdgeCase(const char* a_name, VecFunction a_function, float a_in, float a_expected, double a_maxUlp)
+{
+    float l_out;
+    a_function(&a_in, &l_out, 1);
+    const double l_ulp = UlpDistance(l_out, a_expected);
+    if (l_ulp <= a_maxUlp)
+        return true;
+    printf("    FAIL %s(%g) = %g, expected %g\n", a_name, a_in, l_out, a_expected);
+    return false;
+}
+
+// returns false when a kernel is out of tolerance
+static bool CheckAccuracy(const SVecMathKernels& a_kernels)
+{
+    const size_t l_count = 1 << 22;
+    std::vector<float> l_in(l_count), l_out(l_count);
+    bool l_ok = true;
+
+    // exp over its whole finite range, overflow and underflow included
+    for (size_t i = 0; i < l_count; ++i)
+        l_in[i] = -103.9f + (88.7f + 103.9f) * i / (l_count - 1);
+    a_kernels.exp(&l_in[0], &l_out[0], l_count);
+    double l_expUlp = 0.0;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        const double l_ulp = UlpDistance(l_out[i], (float)exp((double)l_in[i]));
+        l_expUlp = l_ulp > l_expUlp ? l_ulp : l_expUlp;
+    }
+
+    // log of mantissas spread over every exponent, denormals included
+    uint32_t l_seed = 12345;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        l_seed = l_seed * 1664525u + 1013904223u;
+        const int l_exponent = (int)(i % 277) - 149;
+        l_in[i] = ldexpf(1.0f + (l_seed >> 8) / 16777216.0f, l_exponent);
+    }
+    a_kernels.log(&l_in[0], &l_out[0], l_count);
+    double l_logUlp = 0.0;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        const double l_ulp = UlpDistance(l_out[i], (float)log((double)l_in[i]));
+        l_logUlp = l_ulp > l_logUlp ? l_ulp : l_logUlp;
+    }
+
+    // cos over the documented range
+    for (size_t i = 0; i < l_count; ++i)
+        l_in[i] = -8192.0f + 16384.0f * i / (l_count - 1);
+    a_kernels.cos(&l_in[0], &l_out[0], l_count);
+    double l_cosError = 0.0;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        const double l_error = fabs(l_out[i] - cos((double)l_in[i]));
+        l_cosError = l_error > l_cosError ? l_error : l_cosError;
+    }
+
+    printf("  exp %.1f ulp, log %.1f ulp, cos %.2e abs\n", l_expUlp, l_logUlp, l_cosError);
+    l_ok = l_ok && l_expUlp <= MAX_EXP_ULP && l_logUlp <= MAX_LOG_ULP && l_cosError <= MAX_COS_ERROR;
+
+    // edge cases of the header comment
+    const float l_inf = HUGE_VALF;
+    const float l_nan = nanf("");
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, 88.5f, (float)exp(88.5), MAX_EXP_ULP) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, 88.8f, l_inf, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, 1000.0f, l_inf, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, l_inf, l_inf, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, -88.0f, (float)exp(-88.0), MAX_EXP_ULP) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, -100.0f, (float)exp(-100.0), MAX_EXP_ULP) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, -104.0f, 0.0f, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, -l_inf, 0.0f, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("exp", a_kernels.exp, l_nan, l_nan, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("log", a_kernels.log, 0.0f, -l_inf, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("log", a_kernels.log, -1.0f, l_nan, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("log", a_kernels.log, l_inf, l_inf, 0.0) && l_ok;
+    l_ok = CheckEdgeCase("log", a_kernels.log, FLT_MAX, (float)log((double)FLT_MAX), MAX_LOG_ULP) && l_ok;
+    l_ok = CheckEdgeCase("log", a_kernels.log, l_nan, l_nan, 0.0) && l_ok;
+    return l_ok;
+}
+
+static void LibmCos(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = cosf(a_in[i]);
+}
+
+static void LibmExp(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = expf(a_in[i]);
+}
+
+static void LibmLog(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = logf(a_in[i]);
+}
+
+// millions of elements per second over arguments typical of the demos
+static void PrintThroughput(const SVecMathKernels& a_kernels, size_t a_count)
+{
+    std::vector<float> l_angles(a_count), l_exponents(a_count), l_positives(a_count), l_out(a_count);
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        l_angles[i] = 0.001f * i;
+        l_exponents[i] = -20.0f + 40.0f * i / a_count;
+        l_positives[i] = 1.0e-3f + 0.01f * i;
+    }
+    const double l_cosMs = MillisecondsPerFrame([&]() { a_kernels.cos(&l_angles[0], &l_out[0], a_count); });
+    const double l_expMs = MillisecondsPerFrame([&]() { a_kernels.exp(&l_exponents[0], &l_out[0], a_count); });
+    const double l_logMs = MillisecondsPerFrame([&]() { a_kernels.log(&l_positives[0], &l_out[0], a_count); });
+    printf("%-8s %12.1f %12.1f %12.1f\n", a_kernels.name, a_count / l_cosMs / 1000.0, a_count / l_expMs / 1000.0,
+           a_count / l_logMs / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+    const size_t l_count = argc > 1 ? (size_t)atof(argv[1]) : (size_t)1000000;
+    const std::vector<SKernelSet> l_sets = KernelSets();
+
+    bool l_ok = true;
+    printf("accuracy against libm\n");
+    for (size_t i = 0; i < l_sets.size(); ++i)
+    {
+        if (!l_sets[i].supported)
+            continue;
+        printf("%s\n", l_sets[i].kernels.name);
+        l_ok = CheckAccuracy(l_sets[i].kernels) && l_ok;
+    }
+
+    printf("\nthroughput in Melem/s over %zu elements\n", l_count);
+    printf("%-8s %12s %12s %12s\n", "kernels", "cos", "exp", "log");
+    SVecMathKernels l_libm = {LibmCos, LibmExp, LibmLog, "libm"};
+    PrintThroughput(l_libm, l_count);
+    for (size_t i = 0; i < l_sets.size(); ++i)
+    {
+        if (l_sets[i].supported)
+            PrintThroughput(l_sets[i].kernels, l_count);
+    }
+    printf("\ndispatched: %s, %s\n", VecMathKernels().name, l_ok ? "all checks passed" : "CHECKS FAILED");
+    return l_ok ? 0 : 1;
+}
@@ -1,2 +1,5 @@
 #!/bin/bash
-g++ -Wall `pkg-config --cflags glfw3` -o main main.cpp `pkg-config --static --libs glfw3` -framework OpenGL
+g++ -Wall -std=c++11 -o ecg_convert ecg_convert.cpp
+# the demo replays a recording, create it from data_ecg.h on the first build
+[ -f data_ecg.ecg ] || ./ecg_convert --from-header data_ecg.ecg
+g++ -Wall -std=c++11 -pthread `pkg-config --cflags glfw3` -o main main.cpp `pkg-config --static --libs glfw3` -framework OpenGL
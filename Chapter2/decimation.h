@@ -0,0 +1,130 @@
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include <stddef.h>
+
+// M4 decimation: for every pixel column keep the first, last, minimum and
+// maximum sample that falls into it. A line strip through the kept samples
+// rasterizes to the same pixels as the full data set, while the number of
+// vertices is capped at 4x the number of columns.
+
+// Appends the kept samples of one column to a_out in data order, skipping
+// indices that were already written. Returns the new output size.
+template <typename T>
+size_t EmitM4Column(const T* a_points, size_t a_first, size_t a_min, size_t a_max, size_t a_last,
+                    T* a_out, size_t a_outSize)
+{
+    size_t l_order[4] = {a_first, a_min, a_max, a_last};
+    // min and max are emitted in the order they occur in the data
+    if (a_max < a_min)
+    {
+        l_order[1] = a_max;
+        l_order[2] = a_min;
+    }
+    size_t l_previous = (size_t)-1;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (l_order[i] != l_previous)
+        {
+            a_out[a_outSize++] = a_points[l_order[i]];
+            l_previous = l_order[i];
+        }
+    }
+    return a_outSize;
+}
+
+// Decimates points sorted by x that span [a_xMin, a_xMax] into a_columns
+// pixel columns. a_out must hold at least 4 * a_columns points. Returns the
+// number of points written; data that is already sparse is copied through.
+template <typename T>
+size_t DecimateM4(const T* a_points, size_t a_numPoints, float a_xMin, float a_xMax, int a_columns, T* a_out)
+{
+    if (a_columns <= 0 || a_numPoints <= 4 * (size_t)a_columns || a_xMax <= a_xMin)
+    {
+        for (size_t i = 0; i < a_numPoints; ++i)
+            a_out[i] = a_points[i];
+        return a_numPoints;
+    }
+
+    const float l_scale = a_columns / (a_xMax - a_xMin);
+    size_t l_outSize = 0;
+    int l_column = -1;
+    size_t l_first = 0, l_min = 0, l_max = 0, l_last = 0;
+    for (size_t i = 0; i < a_numPoints; ++i)
+    {
+        int l_c = (int)((a_points[i].x - a_xMin) * l_scale);
+        if (l_c >= a_columns)
+            l_c = a_columns - 1;
+        if (l_c != l_column)
+        {
+            if (l_column >= 0)
+                l_outSize = EmitM4Column(a_points, l_first, l_min, l_max, l_last, a_out, l_outSize);
+            l_column = l_c;
+            l_first = l_min = l_max = i;
+        }
+        if (a_points[i].y < a_points[l_min].y)
+            l_min = i;
+        if (a_points[i].y > a_points[l_max].y)
+            l_max = i;
+        l_last = i;
+    }
+    if (l_column >= 0)
+        l_outSize = EmitM4Column(a_points, l_first, l_min, l_max, l_last, a_out, l_outSize);
+    return l_outSize;
+}
+
+// Same reduction for uniformly spaced samples (e.g. one ECG lead), where the
+// column of a sample follows from its index. Output points carry the sample
+// index in x and the sample value in y. Sample i is read from
+// a_samples[i * a_stride], so one lead of an interleaved recording can be
+// decimated in place.
+template <typename T>
+size_t DecimateM4Samples(const float* a_samples, size_t a_numSamples, int a_columns, T* a_out,
+                         size_t a_stride = 1)
+{
+    size_t l_outSize = 0;
+    if (a_columns <= 0 || a_numSamples <= 4 * (size_t)a_columns)
+    {
+        for (size_t i = 0; i < a_numSamples; ++i, ++l_outSize)
+        {
+            a_out[l_outSize].x = (float)i;
+            a_out[l_outSize].y = a_samples[i * a_stride];
+        }
+        return l_outSize;
+    }
+
+    for (int c = 0; c < a_columns; ++c)
+    {
+        const size_t l_begin = (size_t)c * a_numSamples / a_columns;
+        const size_t l_end = (size_t)(c + 1) * a_numSamples / a_columns;
+        if (l_begin == l_end)
+            continue;
+        size_t l_min = l_begin, l_max = l_begin;
+        for (size_t i = l_begin + 1; i < l_end; ++i)
+        {
+            if (a_samples[i * a_stride] < a_samples[l_min * a_stride])
+                l_min = i;
+            if (a_samples[i * a_stride] > a_samples[l_max * a_stride])
+                l_max = i;
+        }
+        size_t l_order[4] = {l_begin, l_min, l_max, l_end - 1};
+        if (l_max < l_min)
+        {
+            l_order[1] = l_max;
+            l_order[2] = l_min;
+        }
+        size_t l_previous = (size_t)-1;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (l_order[i] == l_previous)
+                continue;
+            a_out[l_outSize].x = (float)l_order[i];
+            a_out[l_outSize].y = a_samples[l_order[i] * a_stride];
+            ++l_outSize;
+            l_previous = l_order[i];
+        }
+    }
+    return l_outSize;
+}
+
+#endif
@@ -0,0 +1,163 @@
+// Converts ECG data into the binary recording format read by main.cpp
+// (see ecg_recording.h for the layout).
+//
+//   ecg_convert --from-header out.ecg [leads] [hours]
+//       writes the signal compiled into data_ecg.h; as in the original demo
+//       the extra leads replay it from a different offset. With a duration
+//       the signal is repeated to last that long, which gives multi-hour
+//       recordings for bench_qrs.cpp and the history view
+//   ecg_convert in.csv out.ecg [--rate Hz] [--interleaved]
+//       one row per sample, one column per lead, separated by commas,
+//       semicolons or white space; a header row is skipped
+//
+// Recordings are planar by default, so every lead is contiguous on disk and
+// the decimation reads it without striding over the other leads.
+
+#include "data_ecg.h"
+#include "ecg_recording.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define ECG_HEADER_SAMPLE_RATE  300.0f
+#define ECG_HEADER_LEAD_OFFSET  1024
+// ECG_WINDOW_SIZE of main.cpp: the viewer needs at least one window
+#define ECG_MIN_SAMPLES  600
+
+// a_hours <= 0 writes the signal once
+bool ConvertHeader(const char* a_outPath, int a_numLeads, double a_hours)
+{
+    const size_t l_signalSize = sizeof(data_ecg) / sizeof(data_ecg[0]);
+    const size_t l_size = a_hours > 0.0 ? (size_t)(a_hours * 3600.0 * ECG_HEADER_SAMPLE_RATE) : l_signalSize;
+    std::vector<std::vector<float> > l_leads(a_numLeads, std::vector<float>(l_size));
+    std::vector<const float*> l_pointers(a_numLeads);
+    for (int l = 0; l < a_numLeads; ++l)
+    {
+        for (size_t i = 0; i < l_size; ++i)
+            l_leads[l][i] = data_ecg[(i + l * ECG_HEADER_LEAD_OFFSET) % l_signalSize];
+        l_pointers[l] = &l_leads[l][0];
+    }
+    return WriteECGRecording(a_outPath, &l_pointers[0], a_numLeads, l_size, ECG_HEADER_SAMPLE_RATE,
+                             ECG_LAYOUT_PLANAR);
+}
+
+bool ConvertCSV(const char* a_inPath, const char* a_outPath, float a_sampleRate, EECGLayout a_layout)
+{
+    FILE* l_file = fopen(a_inPath, "r");
+    if (!l_file)
+    {
+        printf("Failed to open \"%s\".\n", a_inPath);
+        return false;
+    }
+
+    std::vector<std::vector<float> > l_leads;
+    char l_line[4096];
+    size_t l_row = 0;
+    while (fgets(l_line, sizeof(l_line), l_file))
+    {
+        ++l_row;
+        std::vector<float> l_values;
+        char* l_cursor = l_line;
+        bool l_numeric = true;
+        while (*l_cursor)
+        {
+            while (*l_cursor == ',' || *l_cursor == ';' || *l_cursor == ' ' || *l_cursor == '\t' ||
+                   *l_cursor == '\r' || *l_cursor == '\n')
+                ++l_cursor;
+            if (!*l_cursor)
+                break;
+            char* l_end;
+            const float l_value = strtof(l_cursor, &l_end);
+            if (l_end == l_cursor)
+            {
+                l_numeric = false;
+                break;
+            }
+            l_values.push_back(l_value);
+            l_cursor = l_end;
+        }
+        if (l_values.empty() || !l_numeric)
+        {
+            // header row or blank line
+            if (!l_numeric && !l_leads.empty())
+                printf("Skipping line %zu of \"%s\".\n", l_row, a_inPath);
+            continue;
+        }
+        if (l_leads.empty())
+            l_leads.resize(l_values.size());
+        if (l_values.size() != l_leads.size())
+        {
+            printf("Line %zu of \"%s\" has %zu columns instead of %zu.\n", l_row, a_inPath,
+                   l_values.size(), l_leads.size());
+            fclose(l_file);
+            return false;
+        }
+        for (size_t l = 0; l < l_values.size(); ++l)
+            l_leads[l].push_back(l_values[l]);
+    }
+    fclose(l_file);
+
+    if (l_leads.empty() || l_leads[0].empty())
+    {
+        printf("\"%s\" contains no samples.\n", a_inPath);
+        return false;
+    }
+    if (l_leads[0].size() < ECG_MIN_SAMPLES)
+    {
+        printf("\"%s\" has %zu samples, at least %d are needed.\n", a_inPath, l_leads[0].size(),
+               ECG_MIN_SAMPLES);
+        return false;
+    }
+    std::vector<const float*> l_pointers(l_leads.size());
+    for (size_t l = 0; l < l_leads.size(); ++l)
+        l_pointers[l] = &l_leads[l][0];
+    return WriteECGRecording(a_outPath, &l_pointers[0], (uint32_t)l_leads.size(), l_leads[0].size(),
+                             a_sampleRate, a_layout);
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc >= 3 && strcmp(argv[1], "--from-header") == 0)
+    {
+        const int l_numLeads = argc >= 4 ? atoi(argv[3]) : 3;
+        if (l_numLeads <= 0)
+        {
+            printf("Invalid number of leads \"%s\".\n", argv[3]);
+            exit(EXIT_FAILURE);
+        }
+        const double l_hours = argc >= 5 ? atof(argv[4]) : 0.0;
+        if (argc >= 5 && l_hours <= 0.0)
+        {
+            printf("Invalid duration \"%s\".\n", argv[4]);
+            exit(EXIT_FAILURE);
+        }
+        exit(ConvertHeader(argv[2], l_numLeads, l_hours) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    if (argc >= 3)
+    {
+        float l_sampleRate = ECG_HEADER_SAMPLE_RATE;
+        EECGLayout l_layout = ECG_LAYOUT_PLANAR;
+        for (int i = 3; i < argc; ++i)
+        {
+            if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+            {
+                l_sampleRate = (float)atof(argv[++i]);
+                if (!(l_sampleRate > 0.0f))
+                {
+                    printf("Invalid sample rate \"%s\".\n", argv[i]);
+                    exit(EXIT_FAILURE);
+                }
+            }
+            else if (strcmp(argv[i], "--interleaved") == 0)
+                l_layout = ECG_LAYOUT_INTERLEAVED;
+        }
+        exit(ConvertCSV(argv[1], argv[2], l_sampleRate, l_layout) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
+    printf("usage: %s --from-header out.ecg [leads] [hours]\n"
+           "       %s in.csv out.ecg [--rate Hz] [--interleaved]\n", argv[0], argv[0]);
+    exit(EXIT_FAILURE);
+}
@@ -0,0 +1,392 @@
+#ifndef ECG_FILTER_H
+#define ECG_FILTER_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "ecg_stream.h"
+
+#if defined(__SSE2__)
+#define ECG_FILTER_SSE
+#include <emmintrin.h>
+#endif
+
+// Streaming filters for live ECG: biquad cascades (bandpass, mains notch,
+// baseline wander removal) followed by an optional FIR. State is kept
+// between blocks, so a signal can be filtered in arbitrarily sized pieces.
+// Leads are processed four at a time, one lead per SIMD lane.
+
+// one second order section, transposed direct form II, a0 normalized to 1
+struct SBiquad
+{
+    float b0, b1, b2, a1, a2;
+};
+
+// Butterworth for the default q; coefficients after the RBJ audio EQ cookbook
+inline SBiquad DesignLowpass(float a_cutoff, float a_sampleRate, float a_q = 0.70710678f)
+{
+    const double l_w = 2.0 * M_PI * a_cutoff / a_sampleRate;
+    const double l_alpha = sin(l_w) / (2.0 * a_q);
+    const double l_cos = cos(l_w);
+    const double l_a0 = 1.0 + l_alpha;
+    SBiquad l_biquad;
+    l_biquad.b0 = (float)((1.0 - l_cos) / 2.0 / l_a0);
+    l_biquad.b1 = (float)((1.0 - l_cos) / l_a0);
+    l_biquad.b2 = l_biquad.b0;
+    l_biquad.a1 = (float)(-2.0 * l_cos / l_a0);
+    l_biquad.a2 = (float)((1.0 - l_alpha) / l_a0);
+    return l_biquad;
+}
+
+// a high pass at about 0.5 Hz removes baseline wander (breathing, electrode drift)
+inline SBiquad DesignHighpass(float a_cutoff, float a_sampleRate, float a_q = 0.70710678f)
+{
+    const double l_w = 2.0 * M_PI * a_cutoff / a_sampleRate;
+    const double l_alpha = sin(l_w) / (2.0 * a_q);
+    const double l_cos = cos(l_w);
+    const double l_a0 = 1.0 + l_alpha;
+    SBiquad l_biquad;
+    l_biquad.b0 = (float)((1.0 + l_cos) / 2.0 / l_a0);
+    l_biquad.b1 = (float)(-(1.0 + l_cos) / l_a0);
+    l_biquad.b2 = l_biquad.b0;
+    l_biquad.a1 = (float)(-2.0 * l_cos / l_a0);
+    l_biquad.a2 = (float)((1.0 - l_alpha) / l_a0);
+    return l_biquad;
+}
+
+// narrow band stop for 50/60 Hz mains interference
+inline SBiquad DesignNotch(float a_frequency, float a_sampleRate, float a_q = 30.0f)
+{
+    const double l_w = 2.0 * M_PI * a_frequency / a_sampleRate;
+    const double l_alpha = sin(l_w) / (2.0 * a_q);
+    const double l_cos = cos(l_w);
+    const double l_a0 = 1.0 + l_alpha;
+    SBiquad l_biquad;
+    l_biquad.b0 = (float)(1.0 / l_a0);
+    l_biquad.b1 = (float)(-2.0 * l_cos / l_a0);
+    l_biquad.b2 = l_biquad.b0;
+    l_biquad.a1 = l_biquad.b1;
+    l_biquad.a2 = (float)((1.0 - l_alpha) / l_a0);
+    return l_biquad;
+}
+
+// linear phase low pass (Hamming windowed sinc) with unit gain at DC;
+// unlike the biquads it does not distort the shape of the QRS complex
+inline std::vector<float> DesignLowpassFIR(float a_cutoff, float a_sampleRate, int a_numTaps)
+{
+    std::vector<float> l_taps(a_numTaps);
+    const double l_fc = a_cutoff / a_sampleRate;
+    const double l_center = (a_numTaps - 1) / 2.0;
+    double l_sum = 0.0;
+    for (int i = 0; i < a_numTaps; ++i)
+    {
+        const double l_t = i - l_center;
+        const double l_sinc = l_t == 0.0 ? 2.0 * l_fc : sin(2.0 * M_PI * l_fc * l_t) / (M_PI * l_t);
+        const double l_window = a_numTaps > 1 ? 0.54 - 0.46 * cos(2.0 * M_PI * i / (a_numTaps - 1)) : 1.0;
+        l_taps[i] = (float)(l_sinc * l_window);
+        l_sum += l_taps[i];
+    }
+    for (int i = 0; i < a_numTaps; ++i)
+        l_taps[i] = (float)(l_taps[i] / l_sum);
+    return l_taps;
+}
+
+// Filter state for a fixed number of leads. Process() filters a block of
+// every lead in place.
+class CECGFilterBank
+{
+public:
+    static const int LANES = 4;
+
+    CECGFilterBank()
+        : m_numLeads(0), m_numGroups(0)
+    {
+    }
+
+    // the sections run in order, then the FIR (skipped when a_fir is empty)
+    void Init(int a_numLeads, const std::vector<SBiquad>& a_sections, const std::vector<float>& a_fir)
+    {
+        m_numLeads = a_numLeads;
+        m_numGroups = (a_numLeads + LANES - 1) / LANES;
+        m_sections = a_sections;
+        m_fir = a_fir;
+        Reset();
+    }
+
+    // forget the signal seen so far
+    void Reset()
+    {
+        m_biquadState.assign(m_numGroups * m_sections.size() * 2 * LANES, 0.0f);
+        m_firHistory.assign(m_numGroups * p_FIRHistory() * LANES, 0.0f);
+    }
+
+    int NumLeads() const { return m_numLeads; }
+
+    // a_leads holds one pointer per lead to a_count samples each
+    void Process(float* const* a_leads, size_t a_count)
+    {
+        if (a_count == 0)
+            return;
+        const size_t l_history = p_FIRHistory();
+        // the FIR reads the previous block's tail right in front of the new samples
+        m_frames.resize((l_history + a_count) * LANES);
+        m_output.resize(a_count * LANES);
+        for (int g = 0; g < m_numGroups; ++g)
+        {
+            float* l_frames = &m_frames[l_history * LANES];
+            // interleave four leads, one lead per lane; missing leads stay zero
+            for (int k = 0; k < LANES; ++k)
+            {
+                const int l_lead = g * LANES + k;
+                for (size_t i = 0; i < a_count; ++i)
+                    l_frames[i * LANES + k] = l_lead < m_numLeads ? a_leads[l_lead][i] : 0.0f;
+            }
+
+            for (size_t s = 0; s < m_sections.size(); ++s)
+                p_Biquad(m_sections[s], &m_biquadState[(g * m_sections.size() + s) * 2 * LANES], l_frames, a_count);
+
+            const float* l_result = l_frames;
+            if (!m_fir.empty())
+            {
+                float* l_groupHistory = &m_firHistory[g * l_history * LANES];
+                for (size_t i = 0; i < l_history * LANES; ++i)
+                    m_frames[i] = l_groupHistory[i];
+                p_FIR(&m_frames[0], a_count, &m_output[0]);
+                // keep the newest frames for the next block
+                for (size_t i = 0; i < l_history * LANES; ++i)
+                    l_groupHistory[i] = m_frames[a_count * LANES + i];
+                l_result = &m_output[0];
+            }
+
+            for (int k = 0; k < LANES; ++k)
+            {
+                const int l_lead = g * LANES + k;
+                if (l_lead >= m_numLeads)
+                    break;
+                for (size_t i = 0; i < a_count; ++i)
+                    a_leads[l_lead][i] = l_result[i * LANES + k];
+            }
+        }
+    }
+
+private:
+    int m_numLeads;
+    int m_numGroups;
+    std::vector<SBiquad> m_sections;
+    std::vector<float> m_fir;
+    // per group and section: z1 and z2 of every lane
+    std::vector<float> m_biquadState;
+    // per group: the last (taps - 1) input frames of the FIR
+    std::vector<float> m_firHistory;
+    std::vector<float> m_frames;
+    std::vector<float> m_output;
+
+    size_t p_FIRHistory() const
+    {
+        return m_fir.empty() ? 0 : m_fir.size() - 1;
+    }
+
+    // filters a_count interleaved frames in place; the state is held in
+    // registers for the whole block
+    static void p_Biquad(const SBiquad& a_biquad, float* a_state, float* a_frames, size_t a_count)
+    {
+#ifdef ECG_FILTER_SSE
+        const __m128 l_b0 = _mm_set1_ps(a_biquad.b0);
+        const __m128 l_b1 = _mm_set1_ps(a_biquad.b1);
+        const __m128 l_b2 = _mm_set1_ps(a_biquad.b2);
+        const __m128 l_a1 = _mm_set1_ps(a_biquad.a1);
+        const __m128 l_a2 = _mm_set1_ps(a_biquad.a2);
+        __m128 l_z1 = _mm_loadu_ps(a_state);
+        __m128 l_z2 = _mm_loadu_ps(a_state + LANES);
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const __m128 l_x = _mm_loadu_ps(a_frames + i * LANES);
+            const __m128 l_y = _mm_add_ps(_mm_mul_ps(l_b0, l_x), l_z1);
+            l_z1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(l_b1, l_x), _mm_mul_ps(l_a1, l_y)), l_z2);
+            l_z2 = _mm_sub_ps(_mm_mul_ps(l_b2, l_x), _mm_mul_ps(l_a2, l_y));
+            _mm_storeu_ps(a_frames + i * LANES, l_y);
+        }
+        _mm_storeu_ps(a_state, l_z1);
+        _mm_storeu_ps(a_state + LANES, l_z2);
+#else
+        float l_z1[LANES], l_z2[LANES];
+        for (int k = 0; k < LANES; ++k)
+        {
+            l_z1[k] = a_state[k];
+            l_z2[k] = a_state[LANES + k];
+        }
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            float* l_frame = a_frames + i * LANES;
+            for (int k = 0; k < LANES; ++k)
+            {
+                const float l_x = l_frame[k];
+                const float l_y = a_biquad.b0 * l_x + l_z1[k];
+                l_z1[k] = a_biquad.b1 * l_x - a_biquad.a1 * l_y + l_z2[k];
+                l_z2[k] = a_biquad.b2 * l_x - a_biquad.a2 * l_y;
+                l_frame[k] = l_y;
+            }
+        }
+        for (int k = 0; k < LANES; ++k)
+        {
+            a_state[k] = l_z1[k];
+            a_state[LANES + k] = l_z2[k];
+        }
+#endif
+    }
+
+    // a_frames starts with the history, output frame i ends at input frame
+    // i + taps - 1
+    void p_FIR(const float* a_frames, size_t a_count, float* a_out) const
+    {
+        const size_t l_numTaps = m_fir.size();
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            const float* l_newest = a_frames + (i + l_numTaps - 1) * LANES;
+#ifdef ECG_FILTER_SSE
+            __m128 l_sum = _mm_setzero_ps();
+            for (size_t t = 0; t < l_numTaps; ++t)
+                l_sum = _mm_add_ps(l_sum, _mm_mul_ps(_mm_set1_ps(m_fir[t]), _mm_loadu_ps(l_newest - t * LANES)));
+            _mm_storeu_ps(a_out + i * LANES, l_sum);
+#else
+            for (int k = 0; k < LANES; ++k)
+            {
+                float l_sum = 0.0f;
+                for (size_t t = 0; t < l_numTaps; ++t)
+                    l_sum += m_fir[t] * l_newest[k - (ptrdiff_t)(t * LANES)];
+                a_out[i * LANES + k] = l_sum;
+            }
+#endif
+        }
+    }
+};
+
+// Filter stage between the acquisition and the displayed leads. The
+// acquisition writes into Input() rings; a worker thread filters whatever
+// arrived on all leads in blocks and forwards it to the output rings, so the
+// render loop never spends time on DSP.
+class CECGFilterStage
+{
+public:
+    static const size_t BLOCK_SIZE = 256;
+
+    CECGFilterStage()
+        : m_running(false), m_bypass(false), m_processed(0), m_busyNanoseconds(0)
+    {
+    }
+
+    ~CECGFilterStage()
+    {
+        Stop();
+        p_FreeInputs();
+    }
+
+    // one input ring of a_ringCapacity samples is created per output ring
+    void Start(const std::vector<CSampleRingBuffer*>& a_outputs, const std::vector<SBiquad>& a_sections,
+               const std::vector<float>& a_fir, size_t a_ringCapacity)
+    {
+        Stop();
+        m_outputs = a_outputs;
+        p_FreeInputs();
+        for (size_t l = 0; l < a_outputs.size(); ++l)
+            m_inputs.push_back(new CSampleRingBuffer(a_ringCapacity));
+        m_bank.Init((int)a_outputs.size(), a_sections, a_fir);
+        m_running.store(true);
+        m_thread = std::thread(&CECGFilterStage::p_Run, this);
+    }
+
+    void Stop()
+    {
+        m_running.store(false);
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    // the rings the acquisition writes the raw samples into
+    std::vector<CSampleRingBuffer*> Inputs() const { return m_inputs; }
+
+    // pass the raw signal through, to compare it with the filtered one; the
+    // filters start again from rest when the bypass is turned off
+    void SetBypass(bool a_bypass) { m_bypass.store(a_bypass); }
+    bool Bypass() const { return m_bypass.load(); }
+
+    // samples filtered so far, summed over all leads
+    uint64_t ChannelSamples() const { return m_processed.load(std::memory_order_relaxed); }
+
+    // filtered channel-samples per second of worker time spent filtering
+    double Throughput() const
+    {
+        const uint64_t l_busy = m_busyNanoseconds.load(std::memory_order_relaxed);
+        return l_busy ? ChannelSamples() * 1.0e9 / l_busy : 0.0;
+    }
+
+private:
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_bypass;
+    std::atomic<uint64_t> m_processed;
+    std::atomic<uint64_t> m_busyNanoseconds;
+    std::thread m_thread;
+    std::vector<CSampleRingBuffer*> m_inputs;
+    std::vector<CSampleRingBuffer*> m_outputs;
+    CECGFilterBank m_bank;
+
+    void p_FreeInputs()
+    {
+        for (size_t l = 0; l < m_inputs.size(); ++l)
+            delete m_inputs[l];
+        m_inputs.clear();
+    }
+
+    void p_Run()
+    {
+        const size_t l_numLeads = m_inputs.size();
+        std::vector<std::vector<float> > l_blocks(l_numLeads, std::vector<float>(BLOCK_SIZE));
+        std::vector<float*> l_pointers(l_numLeads);
+        for (size_t l = 0; l < l_numLeads; ++l)
+            l_pointers[l] = &l_blocks[l][0];
+        bool l_bypassed = false;
+
+        while (m_running.load())
+        {
+            // the leads are filtered in lockstep: take what every lead has
+            size_t l_count = BLOCK_SIZE;
+            for (size_t l = 0; l < l_numLeads; ++l)
+            {
+                const size_t l_available = m_inputs[l]->Available();
+                if (l_available < l_count)
+                    l_count = l_available;
+            }
+            if (l_count == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+
+            for (size_t l = 0; l < l_numLeads; ++l)
+                m_inputs[l]->Pop(l_pointers[l], l_count);
+            const std::chrono::steady_clock::time_point l_start = std::chrono::steady_clock::now();
+            const bool l_bypass = m_bypass.load(std::memory_order_relaxed);
+            // the state from before the bypass belongs to another part of the
+            // signal and would ring into the new samples
+            if (l_bypassed && !l_bypass)
+                m_bank.Reset();
+            l_bypassed = l_bypass;
+            if (!l_bypass)
+            {
+                m_bank.Process(&l_pointers[0], l_count);
+                m_processed.fetch_add(l_count * l_numLeads, std::memory_order_relaxed);
+                m_busyNanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - l_start).count(), std::memory_order_relaxed);
+            }
+            for (size_t l = 0; l < l_numLeads; ++l)
+                m_outputs[l]->Push(l_pointers[l], l_count);
+        }
+    }
+};
+
+#endif
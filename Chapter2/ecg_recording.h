@@ -0,0 +1,288 @@
+#ifndef ECG_RECORDING_H
+#define ECG_RECORDING_H
+
+#include <fcntl.h>
+#include <float.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Binary multi-lead recording (.ecg), opened through mmap so that opening a
+// multi-GB file costs nothing and sample windows are read in place.
+//
+// All values are little-endian.
+//
+//   offset  size  field
+//   0       8     magic "ECGREC01"
+//   8       4     uint32 version (1)
+//   12      4     uint32 header size in bytes (64)
+//   16      4     uint32 number of leads N
+//   20      4     uint32 layout: 0 = interleaved (s0l0 s0l1 .. s1l0 ..),
+//                                1 = planar (all of lead 0, then lead 1, ..)
+//   24      4     float32 sample rate in Hz
+//   28      4     uint32 index stride: samples per seek index block
+//   32      8     uint64 samples per lead
+//   40      8     uint64 byte offset of the sample data
+//   48      8     uint64 byte offset of the seek index
+//   56      8     uint64 number of seek index entries
+//
+// The sample data are float32. The sparse seek index has one entry per block
+// of `index stride` samples:
+//
+//   uint64 first sample of the block
+//   uint64 byte offset of that sample (lead 0) in the file
+//   float32 min[N], float32 max[N] of every lead over the block
+//
+// so a viewer can jump to a time and draw overviews of the whole recording
+// without touching the sample data.
+
+#define ECG_RECORDING_MAGIC "ECGREC01"
+#define ECG_RECORDING_VERSION 1
+// keeps the sizes derived from the number of leads far from overflowing
+#define ECG_RECORDING_MAX_LEADS 65536
+
+enum EECGLayout
+{
+    ECG_LAYOUT_INTERLEAVED = 0,
+    ECG_LAYOUT_PLANAR = 1
+};
+
+struct SECGRecordingHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t numLeads;
+    uint32_t layout;
+    float sampleRate;
+    uint32_t indexStride;
+    uint64_t numSamples;
+    uint64_t dataOffset;
+    uint64_t indexOffset;
+    uint64_t indexEntries;
+};
+
+// a_leads holds one pointer per lead to a_numSamples samples each; returns
+// false if the file could not be written
+bool WriteECGRecording(const char* a_path, const float* const* a_leads, uint32_t a_numLeads,
+                       uint64_t a_numSamples, float a_sampleRate, EECGLayout a_layout,
+                       uint32_t a_indexStride = 1024)
+{
+    FILE* l_file = fopen(a_path, "wb");
+    if (!l_file)
+    {
+        printf("Failed to open \"%s\" for writing.\n", a_path);
+        return false;
+    }
+
+    SECGRecordingHeader l_header;
+    memset(&l_header, 0, sizeof(l_header));
+    memcpy(l_header.magic, ECG_RECORDING_MAGIC, 8);
+    l_header.version = ECG_RECORDING_VERSION;
+    l_header.headerSize = sizeof(SECGRecordingHeader);
+    l_header.numLeads = a_numLeads;
+    l_header.layout = a_layout;
+    l_header.sampleRate = a_sampleRate;
+    l_header.indexStride = a_indexStride;
+    l_header.numSamples = a_numSamples;
+    l_header.dataOffset = sizeof(SECGRecordingHeader);
+    l_header.indexOffset = l_header.dataOffset + a_numSamples * a_numLeads * sizeof(float);
+    l_header.indexEntries = (a_numSamples + a_indexStride - 1) / a_indexStride;
+
+    bool l_ok = fwrite(&l_header, sizeof(l_header), 1, l_file) == 1;
+    if (a_layout == ECG_LAYOUT_PLANAR)
+    {
+        for (uint32_t l = 0; l < a_numLeads && l_ok; ++l)
+            l_ok = fwrite(a_leads[l], sizeof(float), a_numSamples, l_file) == a_numSamples;
+    }
+    else
+    {
+        std::vector<float> l_frame(a_numLeads);
+        for (uint64_t i = 0; i < a_numSamples && l_ok; ++i)
+        {
+            for (uint32_t l = 0; l < a_numLeads; ++l)
+                l_frame[l] = a_leads[l][i];
+            l_ok = fwrite(&l_frame[0], sizeof(float), a_numLeads, l_file) == a_numLeads;
+        }
+    }
+
+    // seek index: byte offset and per-lead min/max of every block
+    std::vector<float> l_range(2 * a_numLeads);
+    for (uint64_t b = 0; b < l_header.indexEntries && l_ok; ++b)
+    {
+        const uint64_t l_first = b * a_indexStride;
+        uint64_t l_end = l_first + a_indexStride;
+        if (l_end > a_numSamples)
+            l_end = a_numSamples;
+        const uint64_t l_offset = l_header.dataOffset + l_first * sizeof(float) *
+                                  (a_layout == ECG_LAYOUT_PLANAR ? 1 : a_numLeads);
+        for (uint32_t l = 0; l < a_numLeads; ++l)
+        {
+            l_range[l] = a_leads[l][l_first];
+            l_range[a_numLeads + l] = a_leads[l][l_first];
+            for (uint64_t i = l_first; i < l_end; ++i)
+            {
+                if (a_leads[l][i] < l_range[l])
+                    l_range[l] = a_leads[l][i];
+                if (a_leads[l][i] > l_range[a_numLeads + l])
+                    l_range[a_numLeads + l] = a_leads[l][i];
+            }
+        }
+        l_ok = fwrite(&l_first, sizeof(l_first), 1, l_file) == 1 &&
+               fwrite(&l_offset, sizeof(l_offset), 1, l_file) == 1 &&
+               fwrite(&l_range[0], sizeof(float), l_range.size(), l_file) == l_range.size();
+    }
+
+    fclose(l_file);
+    if (!l_ok)
+        printf("Failed to write \"%s\".\n", a_path);
+    return l_ok;
+}
+
+// Read-only view of a recording. Samples are never copied: Lead() points
+// straight into the mapping, consecutive samples of a lead are Stride()
+// floats apart (1 for planar files, N for interleaved ones).
+class CECGRecording
+{
+public:
+    CECGRecording()
+        : m_mapping(NULL), m_size(0), m_header(NULL)
+    {
+    }
+
+    ~CECGRecording()
+    {
+        Close();
+    }
+
+    bool Open(const char* a_path)
+    {
+        Close();
+        int l_fd = open(a_path, O_RDONLY);
+        if (l_fd < 0)
+        {
+            printf("Failed to open \"%s\".\n", a_path);
+            return false;
+        }
+        struct stat l_stat;
+        if (fstat(l_fd, &l_stat) != 0 || (size_t)l_stat.st_size < sizeof(SECGRecordingHeader))
+        {
+            printf("\"%s\" is not an ECG recording.\n", a_path);
+            close(l_fd);
+            return false;
+        }
+        m_size = l_stat.st_size;
+        void* l_mapping = mmap(NULL, m_size, PROT_READ, MAP_SHARED, l_fd, 0);
+        // the mapping keeps the file alive
+        close(l_fd);
+        if (l_mapping == MAP_FAILED)
+        {
+            printf("Failed to map \"%s\".\n", a_path);
+            return false;
+        }
+        m_mapping = (const char*)l_mapping;
+        m_header = (const SECGRecordingHeader*)m_mapping;
+
+        if (!p_Valid())
+        {
+            printf("\"%s\" is not a valid ECG recording.\n", a_path);
+            Close();
+            return false;
+        }
+        // samples are read from the start of the file onwards, tell the kernel
+        madvise(l_mapping, m_size, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void Close()
+    {
+        if (m_mapping)
+            munmap((void*)m_mapping, m_size);
+        m_mapping = NULL;
+        m_header = NULL;
+        m_size = 0;
+    }
+
+    bool IsOpen() const { return m_mapping != NULL; }
+    uint32_t NumLeads() const { return m_header->numLeads; }
+    uint64_t NumSamples() const { return m_header->numSamples; }
+    float SampleRate() const { return m_header->sampleRate; }
+    uint32_t IndexStride() const { return m_header->indexStride; }
+    uint64_t NumIndexEntries() const { return m_header->indexEntries; }
+
+    size_t Stride() const
+    {
+        return m_header->layout == ECG_LAYOUT_PLANAR ? 1 : m_header->numLeads;
+    }
+
+    // first sample of a lead; sample i is at Lead(l)[i * Stride()]
+    const float* Lead(uint32_t a_lead) const
+    {
+        const float* l_data = (const float*)(m_mapping + m_header->dataOffset);
+        if (m_header->layout == ECG_LAYOUT_PLANAR)
+            return l_data + a_lead * m_header->numSamples;
+        return l_data + a_lead;
+    }
+
+    // min/max of a lead over seek index block a_entry
+    float IndexMin(uint64_t a_entry, uint32_t a_lead) const
+    {
+        return p_IndexRange(a_entry)[a_lead];
+    }
+
+    float IndexMax(uint64_t a_entry, uint32_t a_lead) const
+    {
+        return p_IndexRange(a_entry)[m_header->numLeads + a_lead];
+    }
+
+private:
+    const char* m_mapping;
+    size_t m_size;
+    const SECGRecordingHeader* m_header;
+
+    // every field of the header against the size of the mapping; the
+    // sizes are divided rather than multiplied so that no product overflows
+    bool p_Valid() const
+    {
+        const SECGRecordingHeader& l_header = *m_header;
+        if (memcmp(l_header.magic, ECG_RECORDING_MAGIC, 8) != 0 || l_header.version != ECG_RECORDING_VERSION)
+            return false;
+        if (l_header.headerSize < sizeof(SECGRecordingHeader) || l_header.headerSize > m_size)
+            return false;
+        if (l_header.numLeads == 0 || l_header.numLeads > ECG_RECORDING_MAX_LEADS ||
+            l_header.layout > ECG_LAYOUT_PLANAR)
+            return false;
+        // also false for NaN
+        if (!(l_header.sampleRate > 0.0f && l_header.sampleRate <= FLT_MAX))
+            return false;
+        if (l_header.indexStride == 0 || l_header.numSamples == 0)
+            return false;
+        if (l_header.dataOffset < l_header.headerSize || l_header.dataOffset % sizeof(float) != 0 ||
+            l_header.dataOffset > m_size ||
+            l_header.numSamples > (m_size - l_header.dataOffset) / (l_header.numLeads * sizeof(float)))
+            return false;
+        if (l_header.indexEntries != (l_header.numSamples - 1) / l_header.indexStride + 1)
+            return false;
+        return l_header.indexOffset >= l_header.headerSize && l_header.indexOffset % sizeof(float) == 0 &&
+               l_header.indexOffset <= m_size &&
+               l_header.indexEntries <= (m_size - l_header.indexOffset) / p_IndexEntrySize();
+    }
+
+    size_t p_IndexEntrySize() const
+    {
+        return 2 * sizeof(uint64_t) + 2 * m_header->numLeads * sizeof(float);
+    }
+
+    const float* p_IndexRange(uint64_t a_entry) const
+    {
+        return (const float*)(m_mapping + m_header->indexOffset + a_entry * p_IndexEntrySize() +
+                              2 * sizeof(uint64_t));
+    }
+};
+
+#endif
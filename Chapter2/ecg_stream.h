@@ -0,0 +1,231 @@
+#ifndef ECG_STREAM_H
+#define ECG_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "minmax_pyramid.h"
+
+// Single-producer/single-consumer lock-free ring buffer for one ECG lead.
+// The acquisition thread is the only writer and the render loop the only
+// reader, so the two indices can be advanced without taking any locks.
+// When the ring is full the producer never blocks: the samples that do not
+// fit are dropped and reported through the overrun counter.
+class CSampleRingBuffer
+{
+public:
+    CSampleRingBuffer(size_t a_capacity)
+        : m_head(0), m_tail(0), m_overruns(0)
+    {
+        // round up to a power of two so the index wrap is a single mask
+        size_t l_capacity = 1;
+        while (l_capacity < a_capacity)
+            l_capacity <<= 1;
+        m_buffer.resize(l_capacity);
+        m_mask = l_capacity - 1;
+    }
+
+    // producer side: returns the number of samples actually stored
+    size_t Push(const float* a_samples, size_t a_count)
+    {
+        const size_t l_head = m_head.load(std::memory_order_relaxed);
+        const size_t l_tail = m_tail.load(std::memory_order_acquire);
+        const size_t l_free = m_buffer.size() - (l_head - l_tail);
+        size_t l_count = a_count;
+        if (l_count > l_free)
+        {
+            m_overruns.fetch_add(l_count - l_free, std::memory_order_relaxed);
+            l_count = l_free;
+        }
+        for (size_t i = 0; i < l_count; ++i)
+            m_buffer[(l_head + i) & m_mask] = a_samples[i];
+        m_head.store(l_head + l_count, std::memory_order_release);
+        return l_count;
+    }
+
+    // consumer side: returns the number of samples copied into a_samples
+    size_t Pop(float* a_samples, size_t a_maxCount)
+    {
+        const size_t l_tail = m_tail.load(std::memory_order_relaxed);
+        const size_t l_head = m_head.load(std::memory_order_acquire);
+        size_t l_count = l_head - l_tail;
+        if (l_count > a_maxCount)
+            l_count = a_maxCount;
+        for (size_t i = 0; i < l_count; ++i)
+            a_samples[i] = m_buffer[(l_tail + i) & m_mask];
+        m_tail.store(l_tail + l_count, std::memory_order_release);
+        return l_count;
+    }
+
+    // consumer side: samples ready to be popped
+    size_t Available() const
+    {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_relaxed);
+    }
+
+    size_t Capacity() const { return m_buffer.size(); }
+    uint64_t Overruns() const { return m_overruns.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<float> m_buffer;
+    size_t m_mask;
+    // keep the producer and consumer indices on separate cache lines
+    char m_pad0[64];
+    std::atomic<size_t> m_head;
+    char m_pad1[64];
+    std::atomic<size_t> m_tail;
+    char m_pad2[64];
+    std::atomic<uint64_t> m_overruns;
+};
+
+// Consumer-side view of one lead: drains the ring buffer once per frame and
+// keeps the most recent a_windowSize samples contiguous in memory so that
+// PlotECGData can read a consistent window without touching the ring again.
+class CECGLead
+{
+public:
+    CECGLead(size_t a_windowSize, size_t a_ringCapacity)
+        : m_ring(a_ringCapacity), m_windowSize(a_windowSize), m_write(0),
+          m_window(a_windowSize * 2, 0.0f), m_scratch(a_ringCapacity), m_newSamples(0), m_totalSamples(0),
+          m_underruns(0), m_history(NULL)
+    {
+    }
+
+    CSampleRingBuffer& Ring() { return m_ring; }
+
+    // optionally keep every sample in a pyramid for zoomed out views
+    void SetHistory(CMinMaxPyramid* a_history) { m_history = a_history; }
+
+    // called by the render loop; returns the number of new samples
+    size_t Update()
+    {
+        const size_t l_count = m_ring.Pop(&m_scratch[0], m_scratch.size());
+        if (l_count == 0)
+        {
+            // the frame found no new data: the trace is frozen, not faked
+            m_underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (size_t i = 0; i < l_count; ++i)
+        {
+            // mirror every sample so the window never wraps
+            m_window[m_write] = m_scratch[i];
+            m_window[m_write + m_windowSize] = m_scratch[i];
+            if (++m_write == m_windowSize)
+                m_write = 0;
+        }
+        if (m_history && l_count > 0)
+            m_history->Append(&m_scratch[0], l_count);
+        m_newSamples = l_count;
+        m_totalSamples += l_count;
+        return l_count;
+    }
+
+    // the samples the last Update() received, e.g. for a detector that has to
+    // see the same stream as the plot
+    const float* NewSamples() const { return &m_scratch[0]; }
+    size_t NumNewSamples() const { return m_newSamples; }
+    // samples received since the start; the newest one has index TotalSamples() - 1
+    uint64_t TotalSamples() const { return m_totalSamples; }
+
+    // the latest a_windowSize samples, oldest first
+    const float* Window() const { return &m_window[m_write]; }
+    size_t WindowSize() const { return m_windowSize; }
+
+    uint64_t Overruns() const { return m_ring.Overruns(); }
+    uint64_t Underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+
+private:
+    CSampleRingBuffer m_ring;
+    size_t m_windowSize;
+    size_t m_write;
+    std::vector<float> m_window;
+    std::vector<float> m_scratch;
+    size_t m_newSamples;
+    uint64_t m_totalSamples;
+    std::atomic<uint64_t> m_underruns;
+    CMinMaxPyramid* m_history;
+};
+
+// Stand-in for the acquisition hardware: replays a recorded signal into one
+// ring buffer per lead from its own thread at a fixed sample rate.
+class CECGAcquisition
+{
+public:
+    CECGAcquisition()
+        : m_running(false), m_stride(1), m_sourceSize(0), m_sampleRate(0.0f)
+    {
+    }
+
+    ~CECGAcquisition()
+    {
+        Stop();
+    }
+
+    // a_sources gives the first sample of each lead, consecutive samples of a
+    // lead are a_stride floats apart (e.g. one lead of a mapped recording)
+    void Start(const std::vector<CSampleRingBuffer*>& a_rings, const std::vector<const float*>& a_sources,
+               size_t a_stride, size_t a_sourceSize, float a_sampleRate)
+    {
+        Stop();
+        m_rings = a_rings;
+        m_sources = a_sources;
+        m_positions.assign(a_rings.size(), 0);
+        m_stride = a_stride;
+        m_sourceSize = a_sourceSize;
+        m_sampleRate = a_sampleRate;
+        m_running.store(true);
+        m_thread = std::thread(&CECGAcquisition::p_Run, this);
+    }
+
+    void Stop()
+    {
+        m_running.store(false);
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+private:
+    std::atomic<bool> m_running;
+    std::thread m_thread;
+    std::vector<CSampleRingBuffer*> m_rings;
+    std::vector<const float*> m_sources;
+    std::vector<size_t> m_positions;
+    size_t m_stride;
+    size_t m_sourceSize;
+    float m_sampleRate;
+
+    void p_Run()
+    {
+        // deliver samples in ~4 ms blocks, paced against the wall clock
+        const std::chrono::microseconds l_period(4000);
+        std::vector<float> l_block;
+        std::chrono::steady_clock::time_point l_next = std::chrono::steady_clock::now();
+        double l_pending = 0.0;
+        while (m_running.load())
+        {
+            l_pending += m_sampleRate * 0.004;
+            const size_t l_count = (size_t)l_pending;
+            l_pending -= l_count;
+            l_block.resize(l_count);
+            for (size_t l = 0; l < m_rings.size(); ++l)
+            {
+                for (size_t i = 0; i < l_count; ++i)
+                {
+                    l_block[i] = m_sources[l][m_positions[l] * m_stride];
+                    if (++m_positions[l] == m_sourceSize)
+                        m_positions[l] = 0;
+                }
+                if (l_count > 0)
+                    m_rings[l]->Push(&l_block[0], l_count);
+            }
+            l_next += l_period;
+            std::this_thread::sleep_until(l_next);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+// Per-frame linear (bump) allocator for temporary buffers. Allocations are
+// never freed individually, the whole arena is released at once by Reset()
+// right after glfwSwapBuffers. Memory is only requested from the heap when a
+// frame needs more than the arena holds: the extra blocks live until the end
+// of that frame and the arena is then grown to the peak, so steady state
+// frames do not touch the heap at all.
+//
+// Build with -DFRAME_ARENA_DEBUG to poison memory on Reset(), which makes
+// pointers kept across frames show up as garbage right away.
+class CFrameArena
+{
+public:
+    static const size_t ALIGNMENT = 16;
+    static const unsigned char POISON = 0xDD;
+
+    CFrameArena(size_t a_capacity)
+        : m_capacity(a_capacity), m_used(0), m_overflowUsed(0), m_peak(0), m_overflows(0)
+    {
+        m_memory = (char*)malloc(m_capacity);
+    }
+
+    ~CFrameArena()
+    {
+        p_FreeOverflow();
+        free(m_memory);
+    }
+
+    // uninitialized storage for a_count objects of type T, valid until Reset()
+    template <typename T>
+    T* Allocate(size_t a_count)
+    {
+        return (T*)AllocateBytes(a_count * sizeof(T));
+    }
+
+    void* AllocateBytes(size_t a_bytes)
+    {
+        const size_t l_offset = (m_used + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        if (l_offset + a_bytes <= m_capacity)
+        {
+            m_used = l_offset + a_bytes;
+            return m_memory + l_offset;
+        }
+
+        // does not fit this frame, hand out a separate block and remember
+        // to grow the arena at the next reset
+        ++m_overflows;
+        m_overflowUsed += a_bytes;
+        void* l_block = malloc(a_bytes);
+        m_overflow.push_back(l_block);
+        return l_block;
+    }
+
+    // end of frame: everything allocated since the last reset becomes invalid
+    void Reset()
+    {
+        const size_t l_frameUsage = m_used + m_overflowUsed;
+        if (l_frameUsage > m_peak)
+            m_peak = l_frameUsage;
+
+#ifdef FRAME_ARENA_DEBUG
+        memset(m_memory, POISON, m_used);
+#endif
+        if (!m_overflow.empty())
+        {
+            p_FreeOverflow();
+            // some headroom for alignment padding and frame to frame jitter
+            m_capacity = m_peak + m_peak / 4;
+            free(m_memory);
+            m_memory = (char*)malloc(m_capacity);
+        }
+        m_used = 0;
+        m_overflowUsed = 0;
+    }
+
+    size_t Used() const { return m_used + m_overflowUsed; }
+    size_t Capacity() const { return m_capacity; }
+    // largest amount of memory used by a single frame so far
+    size_t Peak() const { return m_peak; }
+    // number of allocations that did not fit into the arena
+    size_t Overflows() const { return m_overflows; }
+
+private:
+    char* m_memory;
+    size_t m_capacity;
+    size_t m_used;
+    size_t m_overflowUsed;
+    size_t m_peak;
+    size_t m_overflows;
+    std::vector<void*> m_overflow;
+
+    void p_FreeOverflow()
+    {
+        for (size_t i = 0; i < m_overflow.size(); ++i)
+            free(m_overflow[i]);
+        m_overflow.clear();
+    }
+};
+
+#endif
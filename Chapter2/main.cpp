@@ -1,14 +1,66 @@
 
-#include "data_ecg.h"
+#include "ecg_recording.h"
+#include "ecg_stream.h"
+#include "ecg_filter.h"
+#include "qrs_detector.h"
+#include "decimation.h"
+#include "batch_renderer.h"
+#include "static_geometry.h"
+#include "scatter_plot.h"
+#include "strip_chart.h"
+#include "spectrogram.h"
+#include "frame_arena.h"
+#include "spatial_index.h"
+#include "vmath.h"
 
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
 #include <iostream>
 
 #define ECG_DATA_BUFFER_SIZE  1024
+// leads drawn, recordings with more leads only show the first ones
+#define ECG_NUM_LEADS  3
+// samples per second delivered by the acquisition thread
+#define ECG_SAMPLE_RATE  300.0f
+// live window of every lead: 2 seconds of samples
+#define ECG_WINDOW_SIZE  600
+// longest overview the history pyramid can be zoomed out to: 24 hours
+#define ECG_MAX_VIEW_SIZE  (24.0 * 3600.0 * ECG_SAMPLE_RATE)
+// recording replayed when none is given on the command line, written by
+// compile.sh with ecg_convert from data_ecg.h
+#define ECG_DEFAULT_RECORDING  "data_ecg.ecg"
+// channels of the strip chart mode, emulated by replaying the recorded leads
+// at different positions
+#define ECG_STRIP_CHANNELS  256
+#define ECG_STRIP_CHANNEL_SHIFT  97
+// pass band of the live filter stage and the mains frequency to notch out
+#define ECG_HIGHPASS_CUTOFF  0.5f
+#define ECG_LOWPASS_CUTOFF  40.0f
+#define ECG_LOWPASS_TAPS  61
+#define ECG_MAINS_FREQUENCY  50.0f
+// spectrogram of every live lead: 256 point FFT every 32 samples, 512 columns of history
+#define ECG_SPECTROGRAM_FFT_SIZE  256
+#define ECG_SPECTROGRAM_HOP  32
+#define ECG_SPECTROGRAM_COLUMNS  512
+// the hover index keeps beat positions as floats counted from an origin near
+// the live edge, moved on once it is this many samples behind (2^22, well
+// inside the 2^24 a float holds exactly)
+#define ECG_BEAT_ORIGIN_SPAN  4194304
 float g_ratio;
+// framebuffer width in pixels, used to decimate dense data per pixel column
+int g_viewportWidth;
+int g_viewportHeight;
+// number of samples covered by the ECG view, changed with the scroll wheel
+double g_viewSize = ECG_WINDOW_SIZE;
+// toggled with S: show every channel stacked instead of the three lead view
+bool g_stripChartMode = false;
+// toggled with P: show the spectrogram of every live lead instead of its trace
+bool g_spectrogramMode = false;
+// toggled with L: show the line and scatter plot demo instead of the leads
+bool g_linePlotMode = false;
 
 typedef struct
 {
@@ -21,13 +73,48 @@ typedef struct
     GLfloat x, y, z;
 } Data;
 
+// collects every primitive of a frame and draws them with one call per type
+CBatchRenderer<Vertex> g_renderer;
+// chart furniture that is only rebuilt when its parameters change
+CStaticGeometry<Vertex> g_grid;
+CStaticGeometry<Vertex> g_axes;
+// instanced point renderer for scatter plots
+CScatterPlot g_scatter;
+// the points of the scatter plot for the hover readout, rebuilt with them
+CUniformGridIndex g_scatterIndex;
+// all channels of the strip chart mode in one buffer and one draw call
+CStripChart g_stripChart;
+// number of leads the strip chart channels were laid out for, 0 until the
+// first strip chart frame
+int g_stripChartLeads = 0;
+// filters the live leads on its own thread, F switches it off and on
+CECGFilterStage g_filterStage;
+// scrolling short-time spectrum of the live leads
+CSpectrogram g_spectrogram;
+// scratch memory for data generated during a frame (decimated traces,
+// envelopes, vertex strips), released at buffer swap
+CFrameArena g_frameArena(1 << 20);
+// R-peaks of the live leads for the hover readout, indexed where their
+// markers are drawn: x in samples after g_beatOrigin, y in view units
+typedef struct
+{
+    int lead;
+    SAnnotation beat;
+} IndexedBeat;
+CKdTree g_beatIndex;
+std::vector<IndexedBeat> g_indexedBeats;
+uint64_t g_beatOrigin = 0;
+// beats of every lead in the index, and the sample of the last one
+size_t g_numIndexed[ECG_NUM_LEADS];
+uint64_t g_lastIndexed[ECG_NUM_LEADS];
+// cursor in view units, and what is under it
+float g_cursorX = 0.0f;
+float g_cursorY = 0.0f;
+char g_hoverText[96] = "";
+
 void DrawPoint(Vertex a_vertex, GLfloat a_size)
 {
-    glPointSize(a_size);
-    glBegin(GL_POINTS);
-    glColor4f(a_vertex.r, a_vertex.g, a_vertex.b, a_vertex.a);
-    glVertex3f(a_vertex.x, a_vertex.y, a_vertex.z);
-    glEnd();
+    g_renderer.AddPoint(a_vertex, a_size);
 }
 
 void DrawPoints(int width, int height)
@@ -42,44 +129,45 @@ void DrawPoints(int width, int height)
 
 void DrawLineSegment(Vertex a_vertex1, Vertex a_vertex2, GLfloat a_width = 1.0f)
 {
-    glLineWidth(a_width);
-    glBegin(GL_LINES);
-    glColor4f(a_vertex1.r, a_vertex1.g, a_vertex1.b, a_vertex1.a);
-    glVertex3f(a_vertex1.x, a_vertex1.y, a_vertex1.z);
-    glColor4f(a_vertex2.r, a_vertex2.g, a_vertex2.b, a_vertex2.a);
-    glVertex3f(a_vertex2.x, a_vertex2.y, a_vertex2.z);
-    glEnd();
+    g_renderer.AddLine(a_vertex1, a_vertex2, a_width);
 }
 
 void DrawGrid(GLfloat a_width, GLfloat a_height, GLfloat a_gridWidth)
 {
-    // Horizontal lines
-    for (float i = -a_height; i < a_height; i += a_gridWidth)
-    {
-        Vertex l_vertex1 = {-a_width, i, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-        Vertex l_vertex2 = {a_width, i, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-        DrawLineSegment(l_vertex1, l_vertex2);
-    }
+    // the grid always reaches the edges of the viewport
+    if (a_width < g_ratio)
+        a_width = g_ratio;
 
-    // Vertical lines
-    for (float i = -a_width; i < a_width; i += a_gridWidth)
+    // only regenerate the lines when spacing, extent or viewport changed
+    const float l_params[] = {a_width, a_height, a_gridWidth, (float)g_viewportWidth, g_ratio};
+    if (g_grid.Update(l_params, sizeof(l_params) / sizeof(l_params[0])))
     {
-        Vertex l_vertex1 = {i, -a_height, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-        Vertex l_vertex2 = {i, a_height, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-        DrawLineSegment(l_vertex1, l_vertex2);
+        std::vector<Vertex> l_lines;
+        // Horizontal lines
+        for (float i = -a_height; i < a_height; i += a_gridWidth)
+        {
+            Vertex l_vertex1 = {-a_width, i, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            Vertex l_vertex2 = {a_width, i, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            l_lines.push_back(l_vertex1);
+            l_lines.push_back(l_vertex2);
+        }
+
+        // Vertical lines
+        for (float i = -a_width; i < a_width; i += a_gridWidth)
+        {
+            Vertex l_vertex1 = {i, -a_height, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            Vertex l_vertex2 = {i, a_height, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            l_lines.push_back(l_vertex1);
+            l_lines.push_back(l_vertex2);
+        }
+        g_grid.Upload(GL_LINES, 1.0f, l_lines);
     }
+    g_grid.Draw();
 }
 
 void DrawTriangle(Vertex a_vertex1, Vertex a_vertex2, Vertex a_vertex3)
 {
-    glBegin(GL_TRIANGLES);
-    glColor4f(a_vertex1.r, a_vertex1.g, a_vertex1.b, a_vertex1.a);
-    glVertex3f(a_vertex1.x, a_vertex1.y, a_vertex1.z);
-    glColor4f(a_vertex2.r, a_vertex2.g, a_vertex2.b, a_vertex2.a);
-    glVertex3f(a_vertex2.x, a_vertex2.y, a_vertex2.z);
-    glColor4f(a_vertex3.r, a_vertex3.g, a_vertex3.b, a_vertex3.a);
-    glVertex3f(a_vertex3.x, a_vertex3.y, a_vertex3.z);
-    glEnd();
+    g_renderer.AddTriangle(a_vertex1, a_vertex2, a_vertex3);
 }
 
 void DrawTriangleDemo()
@@ -90,85 +178,432 @@ void DrawTriangleDemo()
     DrawTriangle(v1, v2, v3);
 }
 
-void Draw2DScatterPlot(const Data* a_dataPoints, size_t a_numPoints)
+// the scatter point within 8 pixels of the cursor, highlighted and read out
+void HoverScatter(const Data* a_dataPoints)
 {
-    // Draw x & y axis
-    Vertex vx1 = {-10.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-    Vertex vx2 = {10.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-    DrawLineSegment(vx1, vx2);
+    g_hoverText[0] = 0;
+    // both axes are in view units, which the projection keeps square
+    const float l_pixelsPerUnit = g_viewportHeight / 2.0f;
+    uint32_t l_id;
+    if (!g_scatterIndex.Nearest(g_cursorX, g_cursorY, 8.0f, &l_id, NULL, l_pixelsPerUnit, l_pixelsPerUnit))
+        return;
+    Vertex v = {a_dataPoints[l_id].x, a_dataPoints[l_id].y, 0.0f, 1.0f, 0.2f, 0.2f, 1.0f};
+    DrawPoint(v, 14.0f);
+    snprintf(g_hoverText, sizeof(g_hoverText), " - point %u: (%.2f, %.2f)", l_id, a_dataPoints[l_id].x,
+             a_dataPoints[l_id].y);
+}
 
-    Vertex vy1 = {0.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-    Vertex vy2 = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-    DrawLineSegment(vy1, vy2);
+void Draw2DScatterPlot(const Data* a_dataPoints, size_t a_numPoints)
+{
+    // Draw x & y axis, built once and then drawn from the cached buffer
+    if (g_axes.IsDirty())
+    {
+        std::vector<Vertex> l_lines;
+        Vertex vx1 = {-10.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+        Vertex vx2 = {10.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+        l_lines.push_back(vx1);
+        l_lines.push_back(vx2);
+
+        Vertex vy1 = {0.0f, -1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+        Vertex vy2 = {0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+        l_lines.push_back(vy1);
+        l_lines.push_back(vy2);
+        g_axes.Upload(GL_LINES, 1.0f, l_lines);
+    }
+    g_axes.Draw();
 
+    // the scatter plot and the index take columns, split the x and y of the data points
+    float* l_x = g_frameArena.Allocate<float>(a_numPoints);
+    float* l_y = g_frameArena.Allocate<float>(a_numPoints);
     for (size_t i = 0; i < a_numPoints; ++i)
     {
-        Vertex v = {a_dataPoints[i].x, a_dataPoints[i].y, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
-        DrawPoint(v, 8.0f);
+        l_x[i] = a_dataPoints[i].x;
+        l_y[i] = a_dataPoints[i].y;
     }
+    g_scatterIndex.Clear();
+    g_scatterIndex.Append(l_x, l_y, a_numPoints);
+
+    if (!g_scatter.Ready())
+    {
+        for (size_t i = 0; i < a_numPoints; ++i)
+        {
+            Vertex v = {a_dataPoints[i].x, a_dataPoints[i].y, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+            DrawPoint(v, 8.0f);
+        }
+    }
+    else
+    {
+        g_scatter.SetDefaults(8.0f, 1.0f, 1.0f, 1.0f, 1.0f, MARKER_CIRCLE);
+        g_scatter.SetData(a_numPoints, l_x, l_y, NULL, NULL, NULL);
+        g_scatter.Draw(g_viewportWidth, g_viewportHeight);
+    }
+    HoverScatter(a_dataPoints);
 }
 
 void Draw2DLineSegments(const Data* a_data, size_t a_numPoints)
 {
-    for (size_t i = 0; i < a_numPoints-1; ++i)
+    if (a_numPoints < 2)
+        return;
+
+    // reduce the data to at most 4 points per pixel column covered by the plot
+    // (the orthographic projection maps [-g_ratio, g_ratio] to the viewport)
+    const float l_xMin = a_data[0].x;
+    const float l_xMax = a_data[a_numPoints-1].x;
+    const int l_columns = (int)((l_xMax - l_xMin) / (2.0f * g_ratio) * g_viewportWidth) + 1;
+    Data* l_points = g_frameArena.Allocate<Data>(4 * (size_t)l_columns > a_numPoints ? 4 * (size_t)l_columns
+                                                                                     : a_numPoints);
+    const size_t l_numPoints = DecimateM4(a_data, a_numPoints, l_xMin, l_xMax, l_columns, l_points);
+
+    for (size_t i = 0; i < l_numPoints-1; ++i)
     {
-        GLfloat x1 = a_data[i].x;
-        GLfloat y1 = a_data[i].y;
-        GLfloat x2 = a_data[i+1].x;
-        GLfloat y2 = a_data[i+1].y;
+        GLfloat x1 = l_points[i].x;
+        GLfloat y1 = l_points[i].y;
+        GLfloat x2 = l_points[i+1].x;
+        GLfloat y2 = l_points[i+1].y;
         Vertex v1 = {x1, y1, 0.0f, 0.0f, 1.0f, 1.0f, 0.5f};
         Vertex v2 = {x2, y2, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f};
         DrawLineSegment(v1, v2, 4.0f);
     }
 }
 
+// the grid is drawn by the main loop like for every other view
 void LinePlotDemo(float a_phaseShift)
 {
-    DrawGrid(5.0f, 1.0f, 0.1f);
     GLfloat l_range = 10.0f;
     const size_t l_numPoints = 200;
-    Data* l_data = (Data*)malloc(sizeof(Data) * l_numPoints);
+    Data* l_data = g_frameArena.Allocate<Data>(l_numPoints);
+    // evaluate the cosine for all points at once with the vectorized kernel
+    float* l_phase = g_frameArena.Allocate<float>(l_numPoints);
     for (size_t i = 0; i < l_numPoints; ++i)
     {
         l_data[i].x = (((GLfloat)i / l_numPoints) * l_range) - (l_range / 2.0f);
-        l_data[i].y = 0.8f * cosf(l_data[i].x*3.14f + a_phaseShift);
+        l_phase[i] = l_data[i].x*3.14f + a_phaseShift;
+    }
+    VecCos(l_phase, l_phase, l_numPoints);
+    for (size_t i = 0; i < l_numPoints; ++i)
+    {
+        l_data[i].y = 0.8f * l_phase[i];
     }
     Draw2DScatterPlot(l_data, l_numPoints);
     Draw2DLineSegments(l_data, l_numPoints);
-    free(l_data);
 }
 
-void PlotECGData(int a_offset, int a_size, float a_offsetY, float a_scale)
+// sample i of the window is a_samples[i * a_stride]: a lead of a mapped
+// recording is plotted in place, without copying it first
+void PlotECGData(const float* a_samples, int a_size, float a_offsetY, size_t a_stride = 1)
 {
+    if (a_size < 2)
+        return;
     // space between samples
     const float l_space = 2.0f / a_size * g_ratio;
     // inital position of the first vertex to render
-    float l_pos = -a_size * l_space / 2.0f;
-    // set line width
-    glLineWidth(5.0f);
-    glBegin(GL_LINE_STRIP);
-    // set the color
-    glColor4f(0.1f, 1.0f, 0.1f, 0.8f);
-    for (size_t i = a_offset; i < a_size + a_offset; ++i)
-    {
-        const float l_data = data_ecg[i] + a_offsetY;
-        glVertex3f(l_pos, l_data, 0.0f);
+    const float l_pos = -a_size * l_space / 2.0f;
+    // the window spans the whole viewport: keep min/max/first/last per pixel column
+    Data* l_decimated = g_frameArena.Allocate<Data>(4 * g_viewportWidth > a_size ? 4 * g_viewportWidth : a_size);
+    const size_t l_numPoints = DecimateM4Samples(a_samples, a_size, g_viewportWidth, l_decimated, a_stride);
+    Vertex* l_strip = g_frameArena.Allocate<Vertex>(l_numPoints);
+    for (size_t i = 0; i < l_numPoints; ++i)
+    {
+        const float l_data = l_decimated[i].y + a_offsetY;
+        Vertex v = {l_pos + l_decimated[i].x * l_space, l_data, 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+        l_strip[i] = v;
+    }
+    g_renderer.AddLineStrip(l_strip, l_numPoints, 5.0f);
+}
+
+void PlotECGEnvelope(const float* a_min, const float* a_max, int a_columns, int a_totalColumns, float a_offsetY)
+{
+    // one column per entry, right-aligned so the newest data is at the right edge
+    const float l_space = 2.0f / a_totalColumns * g_ratio;
+    float l_pos = g_ratio - a_columns * l_space;
+    Vertex* l_strip = g_frameArena.Allocate<Vertex>(2 * a_columns);
+    for (int i = 0; i < a_columns; ++i)
+    {
+        // visit min and max of every column so the strip covers the full range
+        Vertex l_min = {l_pos, a_min[i] + a_offsetY, 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+        Vertex l_max = {l_pos, a_max[i] + a_offsetY, 0.0f, 0.1f, 1.0f, 0.1f, 0.8f};
+        l_strip[2*i] = l_min;
+        l_strip[2*i+1] = l_max;
         l_pos += l_space;
     }
-    glEnd();
+    g_renderer.AddLineStrip(l_strip, 2 * a_columns, 2.0f);
+}
+
+void PlotQRSMarkers(const CAnnotationTrack& a_beats, uint64_t a_end, float a_offsetY)
+{
+    // same right-aligned mapping as the traces: sample a_end - 1 sits one step left of the edge
+    const double l_space = 2.0 * g_ratio / g_viewSize;
+    const uint64_t l_begin = a_end > g_viewSize ? a_end - (uint64_t)g_viewSize : 0;
+    const SAnnotation* l_beats;
+    const size_t l_count = a_beats.Query(l_begin, a_end, &l_beats);
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        Vertex v = {(GLfloat)(g_ratio - (a_end - l_beats[i].sample) * l_space), l_beats[i].value + a_offsetY,
+                    0.0f, 1.0f, 0.2f, 0.2f, 0.9f};
+        DrawPoint(v, 10.0f);
+    }
+}
+
+// adds the beats detected since the last frame to the hover index, a_end is
+// the live edge. A late beat inserted before already indexed ones (search
+// back), or an origin too far behind a_end, rebuilds it from all the tracks
+void IndexBeats(CQRSDetector* const* a_detectors, int a_numLeads, const float* a_offsetY, uint64_t a_end)
+{
+    bool l_rebuild = a_end - g_beatOrigin > ECG_BEAT_ORIGIN_SPAN;
+    for (int l = 0; l < a_numLeads && !l_rebuild; ++l)
+    {
+        // a late beat moves the last indexed one up
+        const SAnnotation* l_beats;
+        a_detectors[l]->Annotations().Query(0, UINT64_MAX, &l_beats);
+        const size_t l_indexed = g_numIndexed[l];
+        l_rebuild = l_indexed > 0 && l_beats[l_indexed - 1].sample != g_lastIndexed[l];
+    }
+    if (l_rebuild)
+    {
+        g_beatIndex.Clear();
+        g_indexedBeats.clear();
+        g_beatOrigin = a_end;
+        for (int l = 0; l < a_numLeads; ++l)
+            g_numIndexed[l] = 0;
+    }
+
+    for (int l = 0; l < a_numLeads; ++l)
+    {
+        const SAnnotation* l_beats;
+        const size_t l_count = a_detectors[l]->Annotations().Query(0, UINT64_MAX, &l_beats);
+        for (size_t i = g_numIndexed[l]; i < l_count; ++i)
+        {
+            const float l_x = (float)((int64_t)l_beats[i].sample - (int64_t)g_beatOrigin);
+            const float l_y = l_beats[i].value + a_offsetY[l];
+            IndexedBeat l_indexed = {l, l_beats[i]};
+            g_indexedBeats.push_back(l_indexed);
+            g_beatIndex.Append(&l_x, &l_y, 1);
+        }
+        g_numIndexed[l] = l_count;
+        if (l_count > 0)
+            g_lastIndexed[l] = l_beats[l_count - 1].sample;
+    }
+}
+
+// the R-peak marker within 8 pixels of the cursor, a_end as in PlotQRSMarkers(),
+// a_sampleRate the one of the recording
+void HoverBeats(uint64_t a_end, float a_sampleRate)
+{
+    g_hoverText[0] = 0;
+    const double l_space = 2.0 * g_ratio / g_viewSize;
+    const float l_sample = (float)((double)(a_end - g_beatOrigin) - (g_ratio - g_cursorX) / l_space);
+    // distances in pixels: samples and view units have their own scale
+    const float l_pixelsPerSample = (float)(g_viewportWidth / g_viewSize);
+    const float l_pixelsPerUnit = g_viewportHeight / 2.0f;
+    uint32_t l_id;
+    if (!g_beatIndex.Nearest(l_sample, g_cursorY, 8.0f, &l_id, NULL, l_pixelsPerSample, l_pixelsPerUnit))
+        return;
+    const IndexedBeat& l_hit = g_indexedBeats[l_id];
+    snprintf(g_hoverText, sizeof(g_hoverText), " - lead %d R-peak at %.2f s: %.2f, RR %.2f s", l_hit.lead,
+             l_hit.beat.sample / a_sampleRate, l_hit.beat.value, l_hit.beat.interval);
+}
+
+void ECGDemo(CECGLead* const* a_leads, const CMinMaxPyramid* a_history, CQRSDetector* const* a_detectors,
+             int a_numLeads, float a_sampleRate)
+{
+    const float l_offsetY[ECG_NUM_LEADS] = {-0.5f, 0.0f, 0.5f};
+    if (a_numLeads > 0)
+        IndexBeats(a_detectors, a_numLeads, l_offsetY, a_leads[0]->TotalSamples());
+    for (int i = 0; i < a_numLeads; ++i)
+    {
+        const size_t l_windowSize = a_leads[i]->WindowSize();
+        if (g_viewSize <= l_windowSize)
+        {
+            // Each lead window is filled by the acquisition thread, we only draw the latest samples
+            const int l_size = (int)g_viewSize;
+            PlotECGData(a_leads[i]->Window() + l_windowSize - l_size, l_size, l_offsetY[i]);
+            PlotQRSMarkers(a_detectors[i]->Annotations(), a_leads[i]->TotalSamples(), l_offsetY[i]);
+            continue;
+        }
+
+        // zoomed out: reduce the history to at most one (min, max) pair per pixel column
+        const uint64_t l_end = a_history[i].NumSamples();
+        const uint64_t l_span = l_end < g_viewSize ? l_end : (uint64_t)g_viewSize;
+        const int l_totalColumns = g_viewSize < g_viewportWidth ? (int)g_viewSize : g_viewportWidth;
+        const int l_columns = (int)((double)l_totalColumns * l_span / g_viewSize + 0.5);
+        float* l_min = g_frameArena.Allocate<float>(l_totalColumns);
+        float* l_max = g_frameArena.Allocate<float>(l_totalColumns);
+        const int l_count = a_history[i].Query(l_end - l_span, l_end, l_columns, l_min, l_max);
+        PlotECGEnvelope(l_min, l_max, l_count, l_totalColumns, l_offsetY[i]);
+        PlotQRSMarkers(a_detectors[i]->Annotations(), l_end, l_offsetY[i]);
+    }
+    if (a_numLeads > 0)
+        HoverBeats(a_leads[0]->TotalSamples(), a_sampleRate);
 }
 
-void ECGDemo(int a_counter)
+void SpectrogramDemo(int a_numLeads)
 {
-    const int l_dataSize = ECG_DATA_BUFFER_SIZE;
-    // Emulate the presence of multiple ECG leads (just for demo/ display purposes)
-    PlotECGData(a_counter, l_dataSize*0.5, -0.5f, 0.1f);
-    PlotECGData(a_counter+l_dataSize, l_dataSize*0.5, 0.0f, 0.5f);
-    PlotECGData(a_counter+l_dataSize*2, l_dataSize*0.5, 0.5f, -0.25f);
+    const float l_offsetY[ECG_NUM_LEADS] = {-0.5f, 0.0f, 0.5f};
+    // only the columns computed since the last frame are sent to the GPU
+    g_spectrogram.Upload();
+    for (int i = 0; i < a_numLeads; ++i)
+    {
+        g_spectrogram.Draw(i, -g_ratio, l_offsetY[i] - 0.24f, g_ratio, l_offsetY[i] + 0.24f);
+    }
+}
+
+void ECGReviewDemo(const CECGRecording& a_recording, uint64_t a_end, int a_numLeads)
+{
+    const float l_offsetY[ECG_NUM_LEADS] = {-0.5f, 0.0f, 0.5f};
+    if (a_end > a_recording.NumSamples())
+        a_end = a_recording.NumSamples();
+    const uint64_t l_span = a_end < g_viewSize ? a_end : (uint64_t)g_viewSize;
+    const uint64_t l_begin = a_end - l_span;
+    const int l_totalColumns = g_viewSize < g_viewportWidth ? (int)g_viewSize : g_viewportWidth;
+    const uint64_t l_stride = a_recording.IndexStride();
+    for (int i = 0; i < a_numLeads; ++i)
+    {
+        if (g_viewSize / l_totalColumns < l_stride)
+        {
+            // read the window straight out of the mapped file
+            PlotECGData(a_recording.Lead(i) + l_begin * a_recording.Stride(), (int)l_span,
+                        l_offsetY[i], a_recording.Stride());
+            continue;
+        }
+
+        // a pixel column spans whole seek index blocks: draw the overview from
+        // the index without reading any samples
+        const uint64_t l_firstBlock = l_begin / l_stride;
+        const uint64_t l_numBlocks = (a_end + l_stride - 1) / l_stride - l_firstBlock;
+        const int l_columns = (int)((double)l_totalColumns * l_span / g_viewSize + 0.5);
+        float* l_min = g_frameArena.Allocate<float>(l_totalColumns);
+        float* l_max = g_frameArena.Allocate<float>(l_totalColumns);
+        int l_count = 0;
+        for (int c = 0; c < l_columns; ++c)
+        {
+            const uint64_t l_blockBegin = l_firstBlock + (uint64_t)c * l_numBlocks / l_columns;
+            const uint64_t l_blockEnd = l_firstBlock + (uint64_t)(c + 1) * l_numBlocks / l_columns;
+            if (l_blockBegin == l_blockEnd)
+                continue;
+            l_min[l_count] = a_recording.IndexMin(l_blockBegin, i);
+            l_max[l_count] = a_recording.IndexMax(l_blockBegin, i);
+            for (uint64_t b = l_blockBegin + 1; b < l_blockEnd; ++b)
+            {
+                if (a_recording.IndexMin(b, i) < l_min[l_count])
+                    l_min[l_count] = a_recording.IndexMin(b, i);
+                if (a_recording.IndexMax(b, i) > l_max[l_count])
+                    l_max[l_count] = a_recording.IndexMax(b, i);
+            }
+            ++l_count;
+        }
+        PlotECGEnvelope(l_min, l_max, l_count, l_totalColumns, l_offsetY[i]);
+    }
+}
+
+void StripChartDemo(const CECGRecording& a_recording, uint64_t a_end, int a_numLeads)
+{
+    const int l_numChannels = g_stripChart.NumChannels();
+    const uint64_t l_numSamples = a_recording.NumSamples();
+    if (l_numChannels == 0 || l_numSamples < ECG_WINDOW_SIZE)
+        return;
+
+    // the layout only depends on the lead count; setting it re-uploads the
+    // whole channel uniform buffer, so it is not done every frame
+    if (g_stripChartLeads != a_numLeads)
+    {
+        const float l_color[ECG_NUM_LEADS][3] = {{0.1f, 1.0f, 0.1f}, {1.0f, 0.8f, 0.1f}, {0.2f, 0.6f, 1.0f}};
+        const float l_rowHeight = 2.0f / l_numChannels;
+        for (int c = 0; c < l_numChannels; ++c)
+        {
+            const int l_lead = c % a_numLeads;
+            // one row per channel, top to bottom; the traces peak at about 1
+            g_stripChart.SetChannel(c, 1.0f - (c + 0.5f) * l_rowHeight, l_rowHeight,
+                                    l_color[l_lead][0], l_color[l_lead][1], l_color[l_lead][2], 0.8f);
+        }
+        g_stripChartLeads = a_numLeads;
+    }
+    for (int c = 0; c < l_numChannels; ++c)
+    {
+        const int l_lead = c % a_numLeads;
+        const uint64_t l_begin = (a_end + (uint64_t)c * ECG_STRIP_CHANNEL_SHIFT) % (l_numSamples - ECG_WINDOW_SIZE + 1);
+        g_stripChart.SetData(c, a_recording.Lead(l_lead) + l_begin * a_recording.Stride(), ECG_WINDOW_SIZE,
+                             g_viewportWidth, a_recording.Stride());
+    }
+    g_stripChart.Draw();
+}
+
+void KeyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_action, int a_mods)
+{
+    if (a_action != GLFW_PRESS)
+        return;
+
+    switch (a_key)
+    {
+        case GLFW_KEY_ESCAPE:
+            glfwSetWindowShouldClose(a_window, GL_TRUE);
+            break;
+        case GLFW_KEY_HOME:
+            // back to the live 2 second view
+            g_viewSize = ECG_WINDOW_SIZE;
+            break;
+        case GLFW_KEY_END:
+            g_viewSize = ECG_MAX_VIEW_SIZE;
+            break;
+        case GLFW_KEY_S:
+            g_stripChartMode = !g_stripChartMode;
+            break;
+        case GLFW_KEY_P:
+            g_spectrogramMode = !g_spectrogramMode;
+            break;
+        case GLFW_KEY_L:
+            g_linePlotMode = !g_linePlotMode;
+            break;
+        case GLFW_KEY_F:
+            g_filterStage.SetBypass(!g_filterStage.Bypass());
+            break;
+        default:
+            break;
+    }
+}
+
+void ScrollCallback(GLFWwindow* a_window, double a_x, double a_y)
+{
+    // every wheel step zooms by 25%, between the live window and 24 hours
+    g_viewSize *= pow(1.25, -a_y);
+    if (g_viewSize < ECG_WINDOW_SIZE)
+        g_viewSize = ECG_WINDOW_SIZE;
+    if (g_viewSize > ECG_MAX_VIEW_SIZE)
+        g_viewSize = ECG_MAX_VIEW_SIZE;
+}
+
+void CursorPositionCallback(GLFWwindow* a_window, double a_x, double a_y)
+{
+    // same mapping as the orthographic projection of the view
+    int l_width, l_height;
+    glfwGetWindowSize(a_window, &l_width, &l_height);
+    if (l_width <= 0 || l_height <= 0)
+        return;
+    g_cursorX = (float)((2.0 * a_x / l_width - 1.0) * g_ratio);
+    g_cursorY = (float)(1.0 - 2.0 * a_y / l_height);
 }
 
 int main(int argc, char const *argv[])
 {
+    // usage: main [recording.ecg] [--review]
+    // without --review the recording is streamed through the acquisition
+    // thread like a live device, with it the view plays back the file directly
+    const char* l_recordingPath = ECG_DEFAULT_RECORDING;
+    bool l_review = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--review") == 0)
+            l_review = true;
+        else
+            l_recordingPath = argv[i];
+    }
+    CECGRecording l_recording;
+    if (!l_recording.Open(l_recordingPath))
+    {
+        printf("Create one with: ./ecg_convert --from-header %s\n", ECG_DEFAULT_RECORDING);
+        exit(EXIT_FAILURE);
+    }
+    const int l_numLeads = l_recording.NumLeads() < ECG_NUM_LEADS ? (int)l_recording.NumLeads() : ECG_NUM_LEADS;
+
     GLFWwindow* l_window;
     if (!glfwInit())
     {
@@ -188,13 +623,66 @@ int main(int argc, char const *argv[])
     // Make sure window is on the current calling thread
     glfwMakeContextCurrent(l_window);
 
+    // scroll to zoom the ECG view in and out
+    glfwSetKeyCallback(l_window, KeyCallback);
+    glfwSetScrollCallback(l_window, ScrollCallback);
+    // hover over an R-peak marker to read it in the title bar
+    glfwSetCursorPosCallback(l_window, CursorPositionCallback);
+
     // Enable anti-aliasing and smoothing
     glEnable(GL_POINT_SMOOTH);
     glHint(GL_POINT_SMOOTH_HINT, GL_NICEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    float l_counter = 0;
+    // vertex buffers for the batched primitives, grown on demand
+    g_renderer.Init(65536);
+    // falls back to one point per DrawPoint when instancing is not available
+    g_scatter.Init("scatter.vert", "scatter.frag");
+    // draws one call per channel when uniform buffers are not available
+    g_stripChart.Init(ECG_STRIP_CHANNELS, ECG_WINDOW_SIZE, "strip.vert", "strip.frag");
+    g_spectrogram.Init(l_numLeads, ECG_SPECTROGRAM_FFT_SIZE, ECG_SPECTROGRAM_HOP, ECG_SPECTROGRAM_COLUMNS);
+
+    // every lead of the recording feeds one ring buffer, read in place from the mapping
+    CECGLead* l_leads[ECG_NUM_LEADS];
+    CMinMaxPyramid l_history[ECG_NUM_LEADS];
+    // R-peak detection on the same (filtered) samples that are plotted
+    CQRSDetector* l_detectors[ECG_NUM_LEADS];
+    std::vector<CSampleRingBuffer*> l_leadRings;
+    std::vector<const float*> l_leadSources;
+    for (int i = 0; i < l_numLeads; ++i)
+    {
+        l_leads[i] = new CECGLead(ECG_WINDOW_SIZE, ECG_DATA_BUFFER_SIZE * 4);
+        // the history only has to cover the widest overview
+        l_history[i].SetRetention((uint64_t)ECG_MAX_VIEW_SIZE);
+        l_leads[i]->SetHistory(&l_history[i]);
+        l_detectors[i] = new CQRSDetector(l_recording.SampleRate());
+        l_leadRings.push_back(&l_leads[i]->Ring());
+        l_leadSources.push_back(l_recording.Lead(i));
+    }
+    CECGAcquisition l_acquisition;
+    if (!l_review)
+    {
+        // acquisition -> band pass and notch filter -> displayed leads
+        const float l_sampleRate = l_recording.SampleRate();
+        std::vector<SBiquad> l_sections;
+        l_sections.push_back(DesignHighpass(ECG_HIGHPASS_CUTOFF, l_sampleRate));
+        l_sections.push_back(DesignNotch(ECG_MAINS_FREQUENCY, l_sampleRate));
+        g_filterStage.Start(l_leadRings, l_sections,
+                            DesignLowpassFIR(ECG_LOWPASS_CUTOFF, l_sampleRate, ECG_LOWPASS_TAPS),
+                            ECG_DATA_BUFFER_SIZE * 4);
+        l_acquisition.Start(g_filterStage.Inputs(), l_leadSources, l_recording.Stride(),
+                            l_recording.NumSamples(), l_sampleRate);
+    }
+    // review and strip chart mode: position of the right edge of the view in the
+    // recording, which may be shorter than a window
+    const double l_playbackStart = l_recording.NumSamples() < ECG_WINDOW_SIZE ?
+                                   (double)l_recording.NumSamples() : ECG_WINDOW_SIZE;
+    double l_playback = l_playbackStart;
+    double l_lastTime = glfwGetTime();
+    double l_lastTitleUpdate = 0.0;
+    char l_shownHover[sizeof(g_hoverText)] = "";
+
     while (!glfwWindowShouldClose(l_window))
     {
         // Set up the viewport (using the width and height of the window) and clear the screen color buffer:
@@ -202,6 +690,8 @@ int main(int argc, char const *argv[])
 
         glfwGetFramebufferSize(l_window, &l_width, &l_height);
         g_ratio = (float)l_width / (float)l_height;
+        g_viewportWidth = l_width;
+        g_viewportHeight = l_height;
 
         glViewport(0, 0, l_width, l_height);
         glClear(GL_COLOR_BUFFER_BIT);
@@ -219,23 +709,106 @@ int main(int argc, char const *argv[])
 
         // Draw
         DrawGrid(5.0f, 1.0f, 0.1f);
-        if(l_counter > 5000)
+        // play the recording back in real time and start over at its end
+        const double l_time = glfwGetTime();
+        l_playback += (l_time - l_lastTime) * l_recording.SampleRate();
+        l_lastTime = l_time;
+        if (l_playback > l_recording.NumSamples())
+            l_playback = l_playbackStart;
+        if (!l_review)
+        {
+            // pull whatever the acquisition thread delivered since the last frame
+            for (int i = 0; i < l_numLeads; ++i)
+            {
+                l_leads[i]->Update();
+                l_detectors[i]->Process(l_leads[i]->NewSamples(), l_leads[i]->NumNewSamples());
+                g_spectrogram.Process(i, l_leads[i]->NewSamples(), l_leads[i]->NumNewSamples());
+            }
+        }
+        // heart rate of every live lead in the title bar, once per second,
+        // and the R-peak or point under the cursor as soon as it changes
+        if (l_time - l_lastTitleUpdate >= 1.0 || strcmp(l_shownHover, g_hoverText) != 0)
+        {
+            char l_title[256];
+            int l_length = snprintf(l_title, sizeof(l_title), "Chapter 2");
+            if (!l_review)
+            {
+                l_length += snprintf(l_title + l_length, sizeof(l_title) - l_length, " - HR");
+                for (int i = 0; i < l_numLeads && l_length < (int)sizeof(l_title); ++i)
+                    l_length += snprintf(l_title + l_length, sizeof(l_title) - l_length, " %.0f",
+                                         l_detectors[i]->HeartRate());
+                if (l_length < (int)sizeof(l_title))
+                    l_length += snprintf(l_title + l_length, sizeof(l_title) - l_length, " bpm");
+            }
+            if (l_length < (int)sizeof(l_title))
+                snprintf(l_title + l_length, sizeof(l_title) - l_length, "%s", g_hoverText);
+            glfwSetWindowTitle(l_window, l_title);
+            strcpy(l_shownHover, g_hoverText);
+            l_lastTitleUpdate = l_time;
+        }
+        // only the live view and the line plot have a hover readout
+        g_hoverText[0] = 0;
+        if (g_linePlotMode)
+        {
+            LinePlotDemo((float)l_time);
+        }
+        else if (g_stripChartMode)
+        {
+            StripChartDemo(l_recording, (uint64_t)l_playback, l_numLeads);
+        }
+        else if (g_spectrogramMode && !l_review)
         {
-          l_counter = 0;
+            SpectrogramDemo(l_numLeads);
         }
-        l_counter += 5;
-        // run the demo visualizer
-        ECGDemo(l_counter);
+        else if (l_review)
+        {
+            ECGReviewDemo(l_recording, (uint64_t)l_playback, l_numLeads);
+        }
+        else
+        {
+            // run the demo visualizer
+            ECGDemo(l_leads, l_history, l_detectors, l_numLeads, l_recording.SampleRate());
+        }
+
+        // draw everything that was queued this frame
+        g_renderer.Flush();
 
 
         // Swap the front and back buffers (GLFW uses double buffering) to update the screen
         glfwSwapBuffers(l_window);
+        g_frameArena.Reset();
 
         // process the event queue (such as keyboard inputs) to avoid lock-up:
         glfwPollEvents();
     }
 
+    l_acquisition.Stop();
+    g_filterStage.Stop();
+    printf("Filter stage: %llu channel-samples, %.3g channel-samples/s\n",
+           (unsigned long long)g_filterStage.ChannelSamples(), g_filterStage.Throughput());
+    printf("Frame arena: peak %zu of %zu bytes, %zu overflows\n",
+           g_frameArena.Peak(), g_frameArena.Capacity(), g_frameArena.Overflows());
+    // the acquisition writes into the filter inputs, the filter into the leads;
+    // review mode has no filter stage
+    const std::vector<CSampleRingBuffer*> l_filterInputs = g_filterStage.Inputs();
+    for (int i = 0; i < l_numLeads; ++i)
+    {
+        if (i < (int)l_filterInputs.size())
+            printf("Lead %d: %llu filter input overruns\n", i, (unsigned long long)l_filterInputs[i]->Overruns());
+        printf("Lead %d: %llu overruns, %llu underruns\n", i,
+               (unsigned long long)l_leads[i]->Overruns(), (unsigned long long)l_leads[i]->Underruns());
+        printf("Lead %d: %zu beats detected\n", i, l_detectors[i]->Annotations().Size());
+        delete l_leads[i];
+        delete l_detectors[i];
+    }
+
     // Release the memory and terminate the GLFW library.
+    g_renderer.Release();
+    g_grid.Release();
+    g_axes.Release();
+    g_scatter.Release();
+    g_stripChart.Release();
+    g_spectrogram.Release();
     glfwDestroyWindow(l_window);
     glfwTerminate();
 
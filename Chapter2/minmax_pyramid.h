@@ -0,0 +1,237 @@
+#ifndef MINMAX_PYRAMID_H
+#define MINMAX_PYRAMID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <deque>
+#include <vector>
+
+// Array of the latest values in fixed-size chunks. Growing it never moves
+// the values already stored, unlike a std::vector, whose reallocation would
+// copy a 24 h lead (about 100 MB) on the render thread in the middle of a
+// frame. With a retention the chunks form a bounded ring: once more than
+// that many values are stored, whole chunks are dropped from the front and
+// their memory is reused for the next ones. Indices stay absolute, the
+// values before First() are gone.
+class CChunkedArray
+{
+public:
+    // 64k floats, 256 KB per chunk
+    static const size_t CHUNK_BITS = 16;
+    static const size_t CHUNK_SIZE = (size_t)1 << CHUNK_BITS;
+
+    CChunkedArray()
+        : m_size(0), m_firstChunk(0), m_retention(0)
+    {
+    }
+
+    // keep at least the last a_values values, 0 keeps all of them
+    void SetRetention(uint64_t a_values) { m_retention = a_values; }
+
+    void push_back(float a_value)
+    {
+        if ((m_size & (CHUNK_SIZE - 1)) == 0)
+            p_NewChunk();
+        m_chunks.back().push_back(a_value);
+        ++m_size;
+    }
+
+    uint64_t size() const { return m_size; }
+    // oldest index still stored
+    uint64_t First() const { return m_firstChunk << CHUNK_BITS; }
+
+    float operator[](uint64_t a_index) const
+    {
+        return m_chunks[(size_t)((a_index >> CHUNK_BITS) - m_firstChunk)][(size_t)(a_index & (CHUNK_SIZE - 1))];
+    }
+
+private:
+    std::deque<std::vector<float> > m_chunks;
+    uint64_t m_size;
+    uint64_t m_firstChunk;
+    uint64_t m_retention;
+
+    void p_NewChunk()
+    {
+        // the full chunks after the first one still cover the retention
+        if (m_retention > 0 && m_chunks.size() > 1 && (m_chunks.size() - 1) * CHUNK_SIZE >= m_retention)
+        {
+            std::vector<float> l_chunk;
+            l_chunk.swap(m_chunks.front());
+            m_chunks.pop_front();
+            ++m_firstChunk;
+            l_chunk.clear();
+            m_chunks.push_back(std::vector<float>());
+            m_chunks.back().swap(l_chunk);
+            return;
+        }
+        // the inner vectors are moved, not copied, when m_chunks grows
+        m_chunks.push_back(std::vector<float>());
+        m_chunks.back().reserve(CHUNK_SIZE);
+    }
+};
+
+// Multi-resolution min/max pyramid over one signal, the 1-D analogue of a
+// mipmap chain. Level 0 holds the raw samples; every entry of level k holds
+// the min and max of two entries of level k-1, i.e. of 2^k samples. Levels
+// are extended as samples arrive, so appending costs O(1) amortized, and a
+// query for any zoom level only visits a few entries per output column.
+// With a retention every level only keeps what covers the latest samples,
+// so a monitor that runs for days needs bounded memory.
+class CMinMaxPyramid
+{
+public:
+    CMinMaxPyramid()
+        : m_levels(1), m_retention(0)
+    {
+        // a level per bit of the sample count, never moved once added
+        m_levels.reserve(64);
+    }
+
+    // keep at least the last a_samples samples, 0 keeps all of them; set it
+    // before the first Append()
+    void SetRetention(uint64_t a_samples)
+    {
+        m_retention = a_samples;
+        for (size_t l = 0; l < m_levels.size(); ++l)
+            p_SetRetention(l);
+    }
+
+    void Append(const float* a_samples, size_t a_count)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            m_levels[0].min.push_back(a_samples[i]);
+            p_Propagate();
+        }
+    }
+
+    uint64_t NumSamples() const { return m_levels[0].min.size(); }
+
+    // oldest sample every level still covers
+    uint64_t FirstSample() const
+    {
+        uint64_t l_first = 0;
+        for (size_t l = 0; l < m_levels.size(); ++l)
+        {
+            const uint64_t l_levelFirst = m_levels[l].min.First() << l;
+            if (l_levelFirst > l_first)
+                l_first = l_levelFirst;
+        }
+        return l_first;
+    }
+
+    // Reduces the samples in [a_begin, a_end) to a_columns (min, max) pairs.
+    // When the range holds fewer samples than columns each sample gets its own
+    // column; samples before FirstSample() are left out. Returns the number
+    // of columns written to a_min / a_max.
+    int Query(uint64_t a_begin, uint64_t a_end, int a_columns, float* a_min, float* a_max) const
+    {
+        if (a_end > NumSamples())
+            a_end = NumSamples();
+        if (a_begin < FirstSample())
+            a_begin = FirstSample();
+        if (a_begin >= a_end || a_columns <= 0)
+            return 0;
+
+        const uint64_t l_span = a_end - a_begin;
+        if (l_span <= (uint64_t)a_columns)
+        {
+            for (uint64_t i = 0; i < l_span; ++i)
+                a_min[i] = a_max[i] = m_levels[0].min[a_begin + i];
+            return (int)l_span;
+        }
+
+        // pick the level whose blocks are at most half a column wide
+        size_t l_level = 0;
+        while (l_level + 1 < m_levels.size() && ((uint64_t)4 << l_level) * a_columns <= l_span)
+            ++l_level;
+
+        for (int c = 0; c < a_columns; ++c)
+        {
+            const uint64_t l_first = a_begin + l_span * c / a_columns;
+            const uint64_t l_last = a_begin + l_span * (c + 1) / a_columns;
+            a_min[c] = m_levels[0].min[l_first];
+            a_max[c] = a_min[c];
+            // blocks overlapping the column, widened to block boundaries
+            p_RangeMinMax(l_level, l_first >> l_level, ((l_last - 1) >> l_level) + 1, &a_min[c], &a_max[c]);
+        }
+        return a_columns;
+    }
+
+private:
+    struct SLevel
+    {
+        // level 0 only uses min (a raw sample is its own min and max)
+        CChunkedArray min;
+        CChunkedArray max;
+    };
+    std::vector<SLevel> m_levels;
+    uint64_t m_retention;
+
+    // entries of level k cover 2^k samples; one more for the pair that is
+    // still being filled
+    void p_SetRetention(size_t a_level)
+    {
+        const uint64_t l_entries = m_retention > 0 ? (m_retention >> a_level) + 2 : 0;
+        m_levels[a_level].min.SetRetention(l_entries);
+        m_levels[a_level].max.SetRetention(l_entries);
+    }
+
+    float p_Min(size_t a_level, uint64_t a_index) const
+    {
+        return m_levels[a_level].min[a_index];
+    }
+
+    float p_Max(size_t a_level, uint64_t a_index) const
+    {
+        return a_level == 0 ? m_levels[0].min[a_index] : m_levels[a_level].max[a_index];
+    }
+
+    // fold every completed pair at the end of a level into the level above
+    void p_Propagate()
+    {
+        size_t l_level = 0;
+        while (m_levels[l_level].min.size() % 2 == 0)
+        {
+            const uint64_t l_child = m_levels[l_level].min.size() - 2;
+            float l_min = p_Min(l_level, l_child);
+            float l_max = p_Max(l_level, l_child);
+            if (p_Min(l_level, l_child + 1) < l_min)
+                l_min = p_Min(l_level, l_child + 1);
+            if (p_Max(l_level, l_child + 1) > l_max)
+                l_max = p_Max(l_level, l_child + 1);
+
+            if (l_level + 1 == m_levels.size())
+            {
+                m_levels.push_back(SLevel());
+                p_SetRetention(l_level + 1);
+            }
+            ++l_level;
+            m_levels[l_level].min.push_back(l_min);
+            m_levels[l_level].max.push_back(l_max);
+        }
+    }
+
+    // min/max over blocks [a_first, a_end) of a level; blocks at the tail that
+    // are not complete yet are resolved from the level below
+    void p_RangeMinMax(size_t a_level, uint64_t a_first, uint64_t a_end, float* a_min, float* a_max) const
+    {
+        const uint64_t l_size = m_levels[a_level].min.size();
+        const uint64_t l_complete = a_end < l_size ? a_end : l_size;
+        for (uint64_t i = a_first; i < l_complete; ++i)
+        {
+            if (p_Min(a_level, i) < *a_min)
+                *a_min = p_Min(a_level, i);
+            if (p_Max(a_level, i) > *a_max)
+                *a_max = p_Max(a_level, i);
+        }
+        if (a_end > l_size && a_level > 0)
+        {
+            const uint64_t l_first = (a_first > l_size ? a_first : l_size) * 2;
+            p_RangeMinMax(a_level - 1, l_first, a_end * 2, a_min, a_max);
+        }
+    }
+};
+
+#endif
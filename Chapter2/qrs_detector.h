@@ -0,0 +1,272 @@
+#ifndef QRS_DETECTOR_H
+#define QRS_DETECTOR_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "annotation_track.h"
+#include "ecg_filter.h"
+
+// Incremental Pan-Tompkins style R-peak detector. Every sample goes through
+// a 5-15 Hz band pass, the five point derivative, squaring and a 150 ms
+// moving window integration; peaks of the integrated signal are classified
+// as QRS or noise against adaptive thresholds, with a 200 ms refractory
+// period and a search back when a beat seems to have been missed. All state
+// is a handful of fixed size rings, so each sample costs O(1) and a detector
+// can run for every bed of a ward.
+//
+// Detected beats are added to Annotations() at the R-peak: the highest raw
+// sample up to 100 ms before the largest band passed deflection (which
+// trails the R wave through the filter delay and the S wave). The scan runs
+// once per beat over a bounded window, so it stays O(1) per sample on average.
+class CQRSDetector
+{
+public:
+    CQRSDetector(float a_sampleRate)
+        : m_sampleRate(a_sampleRate),
+          m_integrationSize((size_t)(0.150f * a_sampleRate + 0.5f)),
+          m_searchSize((size_t)(0.250f * a_sampleRate + 0.5f)),
+          m_rawSize(m_searchSize + (size_t)(0.100f * a_sampleRate + 0.5f)),
+          m_refractory((uint64_t)(0.200f * a_sampleRate)),
+          m_learning((uint64_t)(2.0f * a_sampleRate)),
+          m_integration(m_integrationSize, 0.0f), m_raw(m_rawSize, 0.0f),
+          m_maxIndex(m_searchSize + 1), m_maxValue(m_searchSize + 1),
+          m_rr(RR_AVERAGE, 0)
+    {
+        m_highpass = DesignHighpass(5.0f, a_sampleRate);
+        m_lowpass = DesignLowpass(15.0f, a_sampleRate);
+        Reset();
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < 2; ++i)
+            m_highpassState[i] = m_lowpassState[i] = 0.0f;
+        for (int i = 0; i < 4; ++i)
+            m_derivative[i] = 0.0f;
+        std::fill(m_integration.begin(), m_integration.end(), 0.0f);
+        std::fill(m_raw.begin(), m_raw.end(), 0.0f);
+        m_integrationSum = 0.0;
+        m_maxHead = m_maxTail = 0;
+        m_previous = m_previous2 = 0.0f;
+        m_sample = 0;
+        m_learningMax = 0.0f;
+        m_learningSum = 0.0;
+        m_learningPeaks = 0;
+        m_signalLevel = m_noiseLevel = 0.0f;
+        m_lastBeat = 0;
+        m_hasBeat = false;
+        m_missedValue = 0.0f;
+        m_missedSample = 0;
+        m_missedAmplitude = 0.0f;
+        m_rrCount = 0;
+        m_rrSum = 0;
+    }
+
+    void Process(const float* a_samples, size_t a_count)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+            p_Step(a_samples[i]);
+    }
+
+    const CAnnotationTrack& Annotations() const { return m_annotations; }
+
+    // beats per minute over the last RR_AVERAGE intervals, 0 until known
+    float HeartRate() const
+    {
+        if (m_rrCount == 0)
+            return 0.0f;
+        const size_t l_count = m_rrCount < RR_AVERAGE ? m_rrCount : RR_AVERAGE;
+        return 60.0f * m_sampleRate * l_count / m_rrSum;
+    }
+
+private:
+    static const size_t RR_AVERAGE = 8;
+
+    float m_sampleRate;
+    size_t m_integrationSize;
+    // window in which the integrated peak looks for the largest deflection
+    size_t m_searchSize;
+    // raw samples kept to locate the R-peak, 100 ms more than the search window
+    size_t m_rawSize;
+    uint64_t m_refractory;
+    uint64_t m_learning;
+
+    SBiquad m_highpass;
+    SBiquad m_lowpass;
+    float m_highpassState[2];
+    float m_lowpassState[2];
+    float m_derivative[4];
+    std::vector<float> m_integration;
+    double m_integrationSum;
+    std::vector<float> m_raw;
+    // monotonic queue: position of the largest |band pass| over m_searchSize samples
+    std::vector<uint64_t> m_maxIndex;
+    std::vector<float> m_maxValue;
+    size_t m_maxHead;
+    size_t m_maxTail;
+
+    float m_previous;
+    float m_previous2;
+    uint64_t m_sample;
+    float m_learningMax;
+    double m_learningSum;
+    uint64_t m_learningPeaks;
+    // running estimates of QRS and noise peak heights (SPKI, NPKI)
+    float m_signalLevel;
+    float m_noiseLevel;
+    uint64_t m_lastBeat;
+    bool m_hasBeat;
+    // largest rejected peak since the last beat, for the search back
+    float m_missedValue;
+    uint64_t m_missedSample;
+    float m_missedAmplitude;
+    std::vector<uint64_t> m_rr;
+    size_t m_rrCount;
+    uint64_t m_rrSum;
+    CAnnotationTrack m_annotations;
+
+    static float p_Biquad(const SBiquad& a_biquad, float* a_state, float a_x)
+    {
+        const float l_y = a_biquad.b0 * a_x + a_state[0];
+        a_state[0] = a_biquad.b1 * a_x - a_biquad.a1 * l_y + a_state[1];
+        a_state[1] = a_biquad.b2 * a_x - a_biquad.a2 * l_y;
+        return l_y;
+    }
+
+    float p_Threshold() const
+    {
+        return m_noiseLevel + 0.25f * (m_signalLevel - m_noiseLevel);
+    }
+
+    void p_Step(float a_x)
+    {
+        const uint64_t l_n = m_sample++;
+        m_raw[l_n % m_rawSize] = a_x;
+
+        const float l_band = p_Biquad(m_lowpass, m_lowpassState, p_Biquad(m_highpass, m_highpassState, a_x));
+
+        // sliding maximum of |band pass|: drop smaller values from the back,
+        // expired positions from the front
+        const float l_magnitude = fabsf(l_band);
+        const size_t l_capacity = m_maxIndex.size();
+        while (m_maxHead != m_maxTail && m_maxValue[(m_maxTail + l_capacity - 1) % l_capacity] <= l_magnitude)
+            m_maxTail = (m_maxTail + l_capacity - 1) % l_capacity;
+        m_maxIndex[m_maxTail] = l_n;
+        m_maxValue[m_maxTail] = l_magnitude;
+        m_maxTail = (m_maxTail + 1) % l_capacity;
+        if (m_maxIndex[m_maxHead] + m_searchSize <= l_n)
+            m_maxHead = (m_maxHead + 1) % l_capacity;
+
+        // derivative (2x[n] + x[n-1] - x[n-3] - 2x[n-4]) / 8, then squared
+        const float l_slope = (2.0f * l_band + m_derivative[0] - m_derivative[2] - 2.0f * m_derivative[3]) / 8.0f;
+        m_derivative[3] = m_derivative[2];
+        m_derivative[2] = m_derivative[1];
+        m_derivative[1] = m_derivative[0];
+        m_derivative[0] = l_band;
+        const float l_energy = l_slope * l_slope;
+
+        float& l_oldest = m_integration[l_n % m_integrationSize];
+        m_integrationSum += l_energy - l_oldest;
+        l_oldest = l_energy;
+        const float l_integrated = (float)(m_integrationSum / m_integrationSize);
+
+        // a peak of the integrated signal was at the previous sample
+        if (m_previous > l_integrated && m_previous >= m_previous2 && l_n > 0)
+            p_Peak(m_previous, l_n - 1);
+        m_previous2 = m_previous;
+        m_previous = l_integrated;
+
+        // search back: no beat for 166% of the average RR interval, take the
+        // largest peak that cleared half the threshold
+        if (m_hasBeat && m_rrCount > 0 && m_missedValue > 0.5f * p_Threshold())
+        {
+            const size_t l_count = m_rrCount < RR_AVERAGE ? m_rrCount : RR_AVERAGE;
+            if ((l_n - m_lastBeat) * l_count > 166 * m_rrSum / 100)
+            {
+                m_signalLevel = 0.25f * m_missedValue + 0.75f * m_signalLevel;
+                p_Beat(m_missedSample, m_missedAmplitude);
+            }
+        }
+    }
+
+    void p_Peak(float a_value, uint64_t a_n)
+    {
+        if (a_n < m_learning)
+        {
+            // first two seconds: only learn the signal and noise levels
+            if (a_value > m_learningMax)
+                m_learningMax = a_value;
+            m_learningSum += a_value;
+            ++m_learningPeaks;
+            return;
+        }
+        if (m_signalLevel == 0.0f)
+        {
+            m_signalLevel = m_learningMax / 3.0f;
+            // half the mean peak height
+            m_noiseLevel = m_learningPeaks ? (float)(m_learningSum / m_learningPeaks) / 2.0f : 0.0f;
+        }
+
+        const uint64_t l_peak = p_LocatePeak(m_maxIndex[m_maxHead], a_n);
+        const float l_amplitude = m_raw[l_peak % m_rawSize];
+        if (m_hasBeat && l_peak < m_lastBeat + m_refractory)
+        {
+            // T-wave or the tail of the last QRS
+            m_noiseLevel = 0.125f * a_value + 0.875f * m_noiseLevel;
+            return;
+        }
+        if (a_value > p_Threshold())
+        {
+            m_signalLevel = 0.125f * a_value + 0.875f * m_signalLevel;
+            p_Beat(l_peak, l_amplitude);
+            return;
+        }
+        m_noiseLevel = 0.125f * a_value + 0.875f * m_noiseLevel;
+        if (a_value > m_missedValue)
+        {
+            m_missedValue = a_value;
+            m_missedSample = l_peak;
+            m_missedAmplitude = l_amplitude;
+        }
+    }
+
+    // highest raw sample from 100 ms before a_deflection up to a_now
+    uint64_t p_LocatePeak(uint64_t a_deflection, uint64_t a_now) const
+    {
+        const uint64_t l_lookBack = m_rawSize - m_searchSize;
+        uint64_t l_begin = a_deflection > l_lookBack ? a_deflection - l_lookBack : 0;
+        if (l_begin + m_rawSize <= a_now)
+            l_begin = a_now - m_rawSize + 1;
+        uint64_t l_peak = l_begin;
+        for (uint64_t i = l_begin + 1; i <= a_now && i <= a_deflection + l_lookBack / 2; ++i)
+        {
+            if (m_raw[i % m_rawSize] > m_raw[l_peak % m_rawSize])
+                l_peak = i;
+        }
+        return l_peak;
+    }
+
+    void p_Beat(uint64_t a_sample, float a_amplitude)
+    {
+        if (m_hasBeat && a_sample <= m_lastBeat)
+            return;
+        SAnnotation l_beat = {a_sample, a_amplitude, 0.0f};
+        if (m_hasBeat)
+        {
+            const uint64_t l_rr = a_sample - m_lastBeat;
+            l_beat.interval = l_rr / m_sampleRate;
+            m_rrSum += l_rr - m_rr[m_rrCount % RR_AVERAGE];
+            m_rr[m_rrCount % RR_AVERAGE] = l_rr;
+            ++m_rrCount;
+        }
+        m_annotations.Add(l_beat);
+        m_lastBeat = a_sample;
+        m_hasBeat = true;
+        m_missedValue = 0.0f;
+    }
+};
+
+#endif
@@ -0,0 +1,40 @@
+#version 120
+
+varying vec2 markerCoord;
+varying vec4 markerColor;
+varying float markerShape;
+
+void main()
+{
+    // distance measure of the marker shape, the outline is at 1.0
+    float d;
+    if (markerShape < 0.5)
+    {
+        // circle
+        d = length(markerCoord);
+    }
+    else if (markerShape < 1.5)
+    {
+        // square
+        d = max(abs(markerCoord.x), abs(markerCoord.y));
+    }
+    else if (markerShape < 2.5)
+    {
+        // diamond
+        d = abs(markerCoord.x) + abs(markerCoord.y);
+    }
+    else
+    {
+        // cross with arms a quarter of the marker wide
+        d = min(abs(markerCoord.x), abs(markerCoord.y)) * 4.0;
+    }
+
+    if (d > 1.0)
+    {
+        discard;
+    }
+
+    // smooth the outline over about one pixel
+    float alpha = 1.0 - smoothstep(1.0 - fwidth(d), 1.0, d);
+    gl_FragColor = vec4(markerColor.rgb, markerColor.a * alpha);
+}
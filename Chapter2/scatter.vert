@@ -0,0 +1,27 @@
+#version 120
+
+// corner of the marker quad in [-1, 1], shared by every instance
+attribute vec2 corner;
+// per-instance columns of the data set
+attribute float pointX;
+attribute float pointY;
+attribute float pointSize;
+attribute vec4 pointColor;
+attribute float pointMarker;
+
+// 1 / viewport size in pixels
+uniform vec2 inverseViewport;
+
+varying vec2 markerCoord;
+varying vec4 markerColor;
+varying float markerShape;
+
+void main()
+{
+    vec4 center = gl_ModelViewProjectionMatrix * vec4(pointX, pointY, 0.0, 1.0);
+    // offset in clip space so a marker keeps its size in pixels at any zoom
+    gl_Position = center + vec4(corner * pointSize * inverseViewport * center.w, 0.0, 0.0);
+    markerCoord = corner;
+    markerColor = pointColor;
+    markerShape = pointMarker;
+}
@@ -0,0 +1,201 @@
+#ifndef SCATTER_PLOT_H
+#define SCATTER_PLOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "gl_functions.h"
+#include "shader.h"
+
+// marker shapes understood by scatter.frag
+enum EMarker
+{
+    MARKER_CIRCLE = 0,
+    MARKER_SQUARE = 1,
+    MARKER_DIAMOND = 2,
+    MARKER_CROSS = 3
+};
+
+// Scatter plot drawn with a single instanced call: every point is one
+// instance of a screen-aligned quad, and position, size, colour and marker
+// shape are per-instance attributes. Data is handed over as separate columns
+// (structure of arrays), each living in its own vertex buffer, so a column
+// can be replaced without touching the others.
+class CScatterPlot
+{
+public:
+    CScatterPlot()
+        : m_programId(0), m_cornerBuffer(0), m_cornerAttribute(-1), m_inverseViewportId(-1), m_count(0),
+          m_defaultSize(8.0f), m_defaultMarker(MARKER_CIRCLE)
+    {
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+        {
+            m_buffers[i] = 0;
+            m_attributes[i] = -1;
+            m_hasColumn[i] = false;
+        }
+        for (int i = 0; i < 4; ++i)
+            m_defaultColor[i] = 1.0f;
+    }
+
+    ~CScatterPlot()
+    {
+        Release();
+    }
+
+    // needs a current context, returns false when instancing is not supported
+    bool Init(const char* a_vertexShaderPath, const char* a_fragmentShaderPath)
+    {
+        if (!g_gl.hasInstancing)
+            return false;
+
+        // the quad corner is the one per-vertex array, it has to be attribute 0
+        m_programId = LoadShaders(a_vertexShaderPath, a_fragmentShaderPath, "corner");
+        if (!m_programId)
+            return false;
+
+        m_cornerAttribute = g_gl.GetAttribLocation(m_programId, "corner");
+        m_attributes[COLUMN_X] = g_gl.GetAttribLocation(m_programId, "pointX");
+        m_attributes[COLUMN_Y] = g_gl.GetAttribLocation(m_programId, "pointY");
+        m_attributes[COLUMN_SIZE] = g_gl.GetAttribLocation(m_programId, "pointSize");
+        m_attributes[COLUMN_COLOR] = g_gl.GetAttribLocation(m_programId, "pointColor");
+        m_attributes[COLUMN_MARKER] = g_gl.GetAttribLocation(m_programId, "pointMarker");
+        m_inverseViewportId = g_gl.GetUniformLocation(m_programId, "inverseViewport");
+
+        // quad drawn as a triangle strip
+        const GLfloat l_corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+        g_gl.GenBuffers(1, &m_cornerBuffer);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+        g_gl.BufferData(GL_ARRAY_BUFFER, sizeof(l_corners), l_corners, GL_STATIC_DRAW);
+        g_gl.GenBuffers(NUM_COLUMNS, m_buffers);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    bool Ready() const { return m_programId != 0; }
+
+    void Release()
+    {
+        if (!m_programId)
+            return;
+        g_gl.DeleteBuffers(NUM_COLUMNS, m_buffers);
+        g_gl.DeleteBuffers(1, &m_cornerBuffer);
+        g_gl.DeleteProgram(m_programId);
+        m_programId = 0;
+    }
+
+    // used for every column that is not provided
+    void SetDefaults(float a_size, float a_r, float a_g, float a_b, float a_a, EMarker a_marker)
+    {
+        m_defaultSize = a_size;
+        m_defaultColor[0] = a_r;
+        m_defaultColor[1] = a_g;
+        m_defaultColor[2] = a_b;
+        m_defaultColor[3] = a_a;
+        m_defaultMarker = a_marker;
+    }
+
+    // a_size (diameter in pixels), a_rgba (4 bytes per point) and a_marker
+    // (EMarker per point) may be NULL to fall back to the defaults
+    void SetData(size_t a_count, const float* a_x, const float* a_y, const float* a_size,
+                 const uint8_t* a_rgba, const uint8_t* a_marker)
+    {
+        m_count = a_count;
+        p_UploadColumn(COLUMN_X, a_x, a_count * sizeof(float));
+        p_UploadColumn(COLUMN_Y, a_y, a_count * sizeof(float));
+        p_UploadColumn(COLUMN_SIZE, a_size, a_count * sizeof(float));
+        p_UploadColumn(COLUMN_COLOR, a_rgba, a_count * 4);
+        p_UploadColumn(COLUMN_MARKER, a_marker, a_count);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    // uses the current fixed function projection and modelview matrices
+    void Draw(int a_viewportWidth, int a_viewportHeight)
+    {
+        if (!m_programId || m_count == 0 || a_viewportWidth <= 0 || a_viewportHeight <= 0)
+            return;
+
+        g_gl.UseProgram(m_programId);
+        g_gl.Uniform2f(m_inverseViewportId, 1.0f / a_viewportWidth, 1.0f / a_viewportHeight);
+
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_cornerBuffer);
+        g_gl.EnableVertexAttribArray(m_cornerAttribute);
+        g_gl.VertexAttribPointer(m_cornerAttribute, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+        p_BindColumn(COLUMN_X, 1, GL_FLOAT, GL_FALSE);
+        p_BindColumn(COLUMN_Y, 1, GL_FLOAT, GL_FALSE);
+        p_BindColumn(COLUMN_SIZE, 1, GL_FLOAT, GL_FALSE);
+        p_BindColumn(COLUMN_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE);
+        p_BindColumn(COLUMN_MARKER, 1, GL_UNSIGNED_BYTE, GL_FALSE);
+
+        // missing columns are constant attributes
+        if (!m_hasColumn[COLUMN_SIZE] && m_attributes[COLUMN_SIZE] >= 0)
+            g_gl.VertexAttrib1f(m_attributes[COLUMN_SIZE], m_defaultSize);
+        if (!m_hasColumn[COLUMN_COLOR] && m_attributes[COLUMN_COLOR] >= 0)
+            g_gl.VertexAttrib4f(m_attributes[COLUMN_COLOR], m_defaultColor[0], m_defaultColor[1],
+                                m_defaultColor[2], m_defaultColor[3]);
+        if (!m_hasColumn[COLUMN_MARKER] && m_attributes[COLUMN_MARKER] >= 0)
+            g_gl.VertexAttrib1f(m_attributes[COLUMN_MARKER], (float)m_defaultMarker);
+
+        g_gl.DrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)m_count);
+
+        // leave the attribute state as we found it
+        for (int i = 0; i < NUM_COLUMNS; ++i)
+        {
+            if (m_hasColumn[i] && m_attributes[i] >= 0)
+            {
+                g_gl.VertexAttribDivisor(m_attributes[i], 0);
+                g_gl.DisableVertexAttribArray(m_attributes[i]);
+            }
+        }
+        g_gl.DisableVertexAttribArray(m_cornerAttribute);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        g_gl.UseProgram(0);
+    }
+
+private:
+    enum
+    {
+        COLUMN_X,
+        COLUMN_Y,
+        COLUMN_SIZE,
+        COLUMN_COLOR,
+        COLUMN_MARKER,
+        NUM_COLUMNS
+    };
+
+    GLuint m_programId;
+    GLuint m_cornerBuffer;
+    GLuint m_buffers[NUM_COLUMNS];
+    GLint m_attributes[NUM_COLUMNS];
+    bool m_hasColumn[NUM_COLUMNS];
+    GLint m_cornerAttribute;
+    GLint m_inverseViewportId;
+    size_t m_count;
+    float m_defaultSize;
+    float m_defaultColor[4];
+    EMarker m_defaultMarker;
+
+    void p_UploadColumn(int a_column, const void* a_data, size_t a_bytes)
+    {
+        m_hasColumn[a_column] = a_data != NULL;
+        if (!a_data)
+            return;
+        // respecify the whole store so the driver does not wait for the GPU
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffers[a_column]);
+        g_gl.BufferData(GL_ARRAY_BUFFER, a_bytes, a_data, GL_DYNAMIC_DRAW);
+    }
+
+    void p_BindColumn(int a_column, GLint a_components, GLenum a_type, GLboolean a_normalized)
+    {
+        if (!m_hasColumn[a_column] || m_attributes[a_column] < 0)
+            return;
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffers[a_column]);
+        g_gl.EnableVertexAttribArray(m_attributes[a_column]);
+        g_gl.VertexAttribPointer(m_attributes[a_column], a_components, a_type, a_normalized, 0, (void*)0);
+        // advance once per point instead of once per quad corner
+        g_gl.VertexAttribDivisor(m_attributes[a_column], 1);
+    }
+};
+
+#endif
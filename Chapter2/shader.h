@@ -0,0 +1,121 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gl_functions.h"
+
+// Same loader as the one in the later chapters, going through the entry
+// points resolved by LoadGLFunctions().
+
+std::string ReadSourceFile(const char* a_path)
+{
+    std::string l_code;
+    std::ifstream l_fileStream(a_path, std::ios::in);
+    if (l_fileStream.is_open())
+    {
+        std::string l_line = "";
+        while(getline(l_fileStream, l_line))
+            l_code += "\n" + l_line;
+        l_fileStream.close();
+        return l_code;
+    }
+    else
+    {
+        printf("Failed to open \"%s\".\n", a_path);
+        return "";
+    }
+}
+
+bool CompileShader(const std::string& a_programCode, const GLuint a_shaderId)
+{
+    GLint l_result = GL_FALSE;
+    int l_infologLength(0);
+    char const * l_programCodePtr = a_programCode.c_str();
+    g_gl.ShaderSource(a_shaderId, 1, &l_programCodePtr, NULL);
+    g_gl.CompileShader(a_shaderId);
+
+    // check the shader for successful compile
+    g_gl.GetShaderiv(a_shaderId, GL_COMPILE_STATUS, &l_result);
+    g_gl.GetShaderiv(a_shaderId, GL_INFO_LOG_LENGTH, &l_infologLength);
+
+    if (l_result != GL_TRUE && l_infologLength > 0)
+    {
+        std::vector<char> l_errMsg(l_infologLength+1);
+        g_gl.GetShaderInfoLog(a_shaderId, l_infologLength, NULL, &l_errMsg[0]);
+        printf("Error compiling shader [%s] error: `%s`\n", a_programCode.c_str(), &l_errMsg[0]);
+        return false;
+    }
+    return l_result == GL_TRUE;
+}
+
+// a_attributeZero, when given, is bound to attribute location 0 before
+// linking: compatibility contexts only draw when attribute 0 is an enabled
+// array, and the driver would otherwise be free to put any input there
+GLuint LoadShaders(const char* a_vertexShaderPath, const char* a_fragmentShaderPath,
+                   const char* a_attributeZero = NULL)
+{
+    if (!g_gl.hasShaders)
+    {
+        return 0;
+    }
+
+    std::string l_vertexShaderCode = ReadSourceFile(a_vertexShaderPath);
+    if (l_vertexShaderCode.empty())
+    {
+        return 0;
+    }
+
+    std::string l_fragmentShaderCode = ReadSourceFile(a_fragmentShaderPath);
+    if (l_fragmentShaderCode.empty())
+    {
+        return 0;
+    }
+
+    GLuint l_vertexShaderId = g_gl.CreateShader(GL_VERTEX_SHADER);
+    GLuint l_fragmentShaderId = g_gl.CreateShader(GL_FRAGMENT_SHADER);
+
+    printf("Compiling vertex shader %s\n", a_vertexShaderPath);
+    CompileShader(l_vertexShaderCode, l_vertexShaderId);
+
+    printf("Compiling fragment shader %s\n", a_fragmentShaderPath);
+    CompileShader(l_fragmentShaderCode, l_fragmentShaderId);
+
+    GLint l_result = GL_FALSE;
+    int l_infologLength(0);
+    printf("Linking program...\n");
+
+    GLuint l_programId = g_gl.CreateProgram();
+    g_gl.AttachShader(l_programId, l_vertexShaderId);
+    g_gl.AttachShader(l_programId, l_fragmentShaderId);
+    if (a_attributeZero)
+        g_gl.BindAttribLocation(l_programId, 0, a_attributeZero);
+    g_gl.LinkProgram(l_programId);
+
+    // check for errors
+    g_gl.GetProgramiv(l_programId, GL_LINK_STATUS, &l_result);
+    g_gl.GetProgramiv(l_programId, GL_INFO_LOG_LENGTH, &l_infologLength);
+    if (l_result != GL_TRUE)
+    {
+        std::vector<char> l_errMsg(l_infologLength+1);
+        if (l_infologLength > 0)
+            g_gl.GetProgramInfoLog(l_programId, l_infologLength, NULL, &l_errMsg[0]);
+        printf("Error linking shaders error: `%s`\n", &l_errMsg[0]);
+        g_gl.DeleteProgram(l_programId);
+        l_programId = 0;
+    }
+    else
+    {
+        printf("Linked successfully\n");
+    }
+
+    // flag for delete, and will free all memories
+    // when the attached program is deleted
+    g_gl.DeleteShader(l_vertexShaderId);
+    g_gl.DeleteShader(l_fragmentShaderId);
+    return l_programId;
+}
+
+#endif
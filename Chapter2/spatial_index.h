@@ -0,0 +1,500 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+// Picking: which sample is under the cursor. One index per kind of data:
+//  - CRegularGridIndex for samples on a regular grid (heat maps, surfaces):
+//    the cell follows from the position, O(1) without any memory,
+//  - CUniformGridIndex for scatter data spread over an area: points are
+//    binned into square cells of a few points each and a query only visits
+//    the cells around the cursor,
+//  - CKdTree for arbitrary point sets, clustered or with far outliers, that
+//    would leave fixed cells mostly empty or overfull.
+// The point indices take columns like CScatterPlot and grow with Append()
+// as data streams in, without rebuilding all of it every time. Nearest()
+// answers in microseconds for millions of points (bench_spatial_index.cpp);
+// distances can be scaled per axis (e.g. to pixels) when x and y have
+// different units. Points get ids in the order they were appended (32 bit);
+// points with a NaN coordinate keep their id but are never found.
+
+// samples stored x-major like CAnalyticSurface: index = column * rows + row
+class CRegularGridIndex
+{
+public:
+    CRegularGridIndex()
+        : m_columns(0), m_rows(0), m_xFirst(0.0f), m_xLast(0.0f), m_yFirst(0.0f), m_yLast(0.0f)
+    {
+    }
+
+    // a_columns x a_rows samples, the first one at (a_xFirst, a_yFirst) and
+    // the last one at (a_xLast, a_yLast)
+    void SetGrid(int a_columns, int a_rows, float a_xFirst, float a_xLast, float a_yFirst, float a_yLast)
+    {
+        m_columns = a_columns;
+        m_rows = a_rows;
+        m_xFirst = a_xFirst;
+        m_xLast = a_xLast;
+        m_yFirst = a_yFirst;
+        m_yLast = a_yLast;
+    }
+
+    // sample nearest to (a_x, a_y); false more than half a cell off the grid
+    bool Nearest(float a_x, float a_y, int* a_column, int* a_row) const
+    {
+        return p_Nearest(a_x, m_xFirst, m_xLast, m_columns, a_column) &&
+               p_Nearest(a_y, m_yFirst, m_yLast, m_rows, a_row);
+    }
+
+    size_t Index(int a_column, int a_row) const { return (size_t)a_column * m_rows + a_row; }
+
+private:
+    int m_columns;
+    int m_rows;
+    float m_xFirst;
+    float m_xLast;
+    float m_yFirst;
+    float m_yLast;
+
+    static bool p_Nearest(float a_value, float a_first, float a_last, int a_count, int* a_index)
+    {
+        if (a_count < 1)
+            return false;
+        const float l_t = a_count > 1 && a_last != a_first ? (a_value - a_first) / (a_last - a_first) * (a_count - 1)
+                                                           : 0.0f;
+        // also false for NaN
+        if (!(l_t >= -0.5f && l_t < a_count - 0.5f))
+            return false;
+        *a_index = (int)floorf(l_t + 0.5f);
+        if (*a_index > a_count - 1)
+            *a_index = a_count - 1;
+        return true;
+    }
+};
+
+// Points are linked into per-cell lists, so appending costs O(1). The cell
+// size is chosen for about POINTS_PER_CELL points per cell when the grid is
+// built; it is rebuilt (O(n)) once the number of points doubled, or once too
+// many of them landed outside its bounds, which keeps appending amortized
+// O(1) per point. Degrades when most points crowd into a few cells; use
+// CKdTree for such data.
+class CUniformGridIndex
+{
+public:
+    static const uint32_t NONE = 0xffffffffu;
+
+    CUniformGridIndex()
+        : m_builtSize(0), m_columns(0), m_rows(0), m_xMin(0.0f), m_yMin(0.0f), m_cellSize(1.0f),
+          m_inverseCellSize(1.0f)
+    {
+    }
+
+    void Clear()
+    {
+        m_x.clear();
+        m_y.clear();
+        m_next.clear();
+        m_heads.clear();
+        m_outside.clear();
+        m_builtSize = 0;
+        m_columns = m_rows = 0;
+    }
+
+    size_t Size() const { return m_x.size(); }
+
+    // the new points get the ids Size() to Size() + a_count - 1
+    void Append(const float* a_x, const float* a_y, size_t a_count)
+    {
+        const size_t l_first = m_x.size();
+        m_x.insert(m_x.end(), a_x, a_x + a_count);
+        m_y.insert(m_y.end(), a_y, a_y + a_count);
+        m_next.resize(m_x.size(), (uint32_t)NONE);
+        if (m_x.size() >= 2 * m_builtSize)
+        {
+            p_Rebuild();
+            return;
+        }
+        for (size_t i = l_first; i < m_x.size(); ++i)
+            p_Link((uint32_t)i);
+        if (m_outside.size() > m_x.size() / 16 + 64)
+            p_Rebuild();
+    }
+
+    // nearest point within a_maxDistance of (a_x, a_y), distances measured
+    // with dx * a_scaleX and dy * a_scaleY; false when there is none
+    bool Nearest(float a_x, float a_y, float a_maxDistance, uint32_t* a_id, float* a_distance = NULL,
+                 float a_scaleX = 1.0f, float a_scaleY = 1.0f) const
+    {
+        if (a_x != a_x || a_y != a_y)
+            return false;
+        SQuery l_query = {a_x, a_y, a_scaleX, a_scaleY, a_maxDistance * a_maxDistance, NONE};
+        for (size_t i = 0; i < m_outside.size(); ++i)
+            p_Test(m_outside[i], &l_query);
+
+        if (m_columns > 0)
+        {
+            // cell of the query, which may lie off the grid
+            const int l_column = p_Cell(a_x, m_xMin);
+            const int l_row = p_Cell(a_y, m_yMin);
+            // rings from the first one that reaches the grid to the one that covers all of it
+            const int l_first = std::max(std::max(std::max(l_column - m_columns + 1, -l_column),
+                                                  std::max(l_row - m_rows + 1, -l_row)), 0);
+            const int l_last = std::max(std::max(l_column, m_columns - 1 - l_column),
+                                        std::max(l_row, m_rows - 1 - l_row));
+            // every cell of ring r is at least r - 1 cells away from the query
+            const float l_step = m_cellSize * std::min(a_scaleX, a_scaleY);
+            for (int r = l_first; r <= l_last; ++r)
+            {
+                const float l_ringDistance = (r - 1) * l_step;
+                if (r > 1 && l_ringDistance * l_ringDistance > l_query.best)
+                    break;
+                const int l_xBegin = std::max(l_column - r, 0);
+                const int l_xEnd = std::min(l_column + r, m_columns - 1);
+                for (int y = std::max(l_row - r, 0); y <= std::min(l_row + r, m_rows - 1); ++y)
+                {
+                    const uint32_t* l_heads = &m_heads[(size_t)y * m_columns];
+                    if (y == l_row - r || y == l_row + r)
+                    {
+                        // the top and bottom row of the ring are whole
+                        for (int x = l_xBegin; x <= l_xEnd; ++x)
+                            p_TestCell(l_heads[x], &l_query);
+                        continue;
+                    }
+                    // the other rows only have their two ends
+                    if (l_column - r >= 0)
+                        p_TestCell(l_heads[l_column - r], &l_query);
+                    if (r > 0 && l_column + r < m_columns)
+                        p_TestCell(l_heads[l_column + r], &l_query);
+                }
+            }
+        }
+
+        if (l_query.id == NONE)
+            return false;
+        *a_id = l_query.id;
+        if (a_distance)
+            *a_distance = sqrtf(l_query.best);
+        return true;
+    }
+
+private:
+    static const size_t POINTS_PER_CELL = 4;
+    static const size_t MAX_CELLS = 1 << 22;
+
+    struct SQuery
+    {
+        float x;
+        float y;
+        float scaleX;
+        float scaleY;
+        // squared distance of the best point so far
+        float best;
+        uint32_t id;
+    };
+
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    // next point in the same cell, NONE at the end
+    std::vector<uint32_t> m_next;
+    // first point of every cell, row by row
+    std::vector<uint32_t> m_heads;
+    // points beyond the bounds of the grid, searched linearly
+    std::vector<uint32_t> m_outside;
+    size_t m_builtSize;
+    int m_columns;
+    int m_rows;
+    float m_xMin;
+    float m_yMin;
+    float m_cellSize;
+    float m_inverseCellSize;
+
+    void p_Rebuild()
+    {
+        m_builtSize = m_x.size();
+        m_heads.clear();
+        m_outside.clear();
+        m_columns = m_rows = 0;
+
+        float l_xMin = FLT_MAX, l_xMax = -FLT_MAX, l_yMin = FLT_MAX, l_yMax = -FLT_MAX;
+        size_t l_finite = 0;
+        for (size_t i = 0; i < m_x.size(); ++i)
+        {
+            if (!p_IsFinite(m_x[i]) || !p_IsFinite(m_y[i]))
+                continue;
+            l_xMin = std::min(l_xMin, m_x[i]);
+            l_xMax = std::max(l_xMax, m_x[i]);
+            l_yMin = std::min(l_yMin, m_y[i]);
+            l_yMax = std::max(l_yMax, m_y[i]);
+            ++l_finite;
+        }
+        if (l_finite == 0)
+            return;
+
+        // square cells holding POINTS_PER_CELL points on average
+        const size_t l_cells = std::min(std::max(l_finite / POINTS_PER_CELL, (size_t)1), (size_t)MAX_CELLS);
+        const double l_width = (double)l_xMax - l_xMin;
+        const double l_height = (double)l_yMax - l_yMin;
+        double l_cellSize = l_width * l_height > 0.0 ? sqrt(l_width * l_height / l_cells)
+                                                     : std::max(l_width, l_height) / l_cells;
+        if (!(l_cellSize > 0.0))
+            l_cellSize = 1.0;
+        m_columns = (int)std::min(l_width / l_cellSize + 1.0, (double)MAX_CELLS);
+        m_rows = (int)std::min(l_height / l_cellSize + 1.0, (double)MAX_CELLS / m_columns);
+        m_xMin = l_xMin;
+        m_yMin = l_yMin;
+        m_cellSize = (float)l_cellSize;
+        m_inverseCellSize = (float)(1.0 / l_cellSize);
+
+        m_heads.assign((size_t)m_columns * m_rows, (uint32_t)NONE);
+        for (size_t i = 0; i < m_x.size(); ++i)
+            p_Link((uint32_t)i);
+    }
+
+    void p_Link(uint32_t a_id)
+    {
+        const float l_x = m_x[a_id];
+        const float l_y = m_y[a_id];
+        if (!p_IsFinite(l_x) || !p_IsFinite(l_y))
+            return;
+        const float l_u = (l_x - m_xMin) * m_inverseCellSize;
+        const float l_v = (l_y - m_yMin) * m_inverseCellSize;
+        if (m_columns == 0 || !(l_u >= 0.0f && l_u < m_columns && l_v >= 0.0f && l_v < m_rows))
+        {
+            m_outside.push_back(a_id);
+            return;
+        }
+        uint32_t& l_head = m_heads[(size_t)(int)l_v * m_columns + (int)l_u];
+        m_next[a_id] = l_head;
+        l_head = a_id;
+    }
+
+    void p_Test(uint32_t a_id, SQuery* a_query) const
+    {
+        const float l_dx = (m_x[a_id] - a_query->x) * a_query->scaleX;
+        const float l_dy = (m_y[a_id] - a_query->y) * a_query->scaleY;
+        const float l_distance = l_dx * l_dx + l_dy * l_dy;
+        if (l_distance <= a_query->best)
+        {
+            a_query->best = l_distance;
+            a_query->id = a_id;
+        }
+    }
+
+    void p_TestCell(uint32_t a_head, SQuery* a_query) const
+    {
+        for (uint32_t i = a_head; i != NONE; i = m_next[i])
+            p_Test(i, a_query);
+    }
+
+    // computed like in p_Link(), kept far enough from the int range that the
+    // ring arithmetic cannot overflow
+    int p_Cell(float a_value, float a_min) const
+    {
+        const float l_cell = floorf((a_value - a_min) * m_inverseCellSize);
+        return (int)std::max(std::min(l_cell, 1e8f), -1e8f);
+    }
+
+    static bool p_IsFinite(float a_value) { return a_value >= -FLT_MAX && a_value <= FLT_MAX; }
+};
+
+// Balanced 2-d tree stored implicitly: a node is a range of the point array
+// with its median in the middle, split across the longer side of the node's
+// box, and ranges of at most LEAF_SIZE points are scanned. Streaming points
+// are collected in a small unsorted buffer that becomes a tree of its own;
+// trees are merged like the digits of a binary counter (a logarithmic
+// method), so every point is rebuilt O(log n) times and a query searches
+// O(log n) trees.
+class CKdTree
+{
+public:
+    CKdTree()
+        : m_size(0)
+    {
+    }
+
+    void Clear()
+    {
+        m_trees.clear();
+        m_pending.clear();
+        m_size = 0;
+    }
+
+    size_t Size() const { return m_size; }
+
+    // the new points get the ids Size() to Size() + a_count - 1
+    void Append(const float* a_x, const float* a_y, size_t a_count)
+    {
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            // NaN would break the ordering of the median splits
+            if (a_x[i] == a_x[i] && a_y[i] == a_y[i])
+            {
+                const SPoint l_point = {a_x[i], a_y[i], (uint32_t)m_size};
+                m_pending.push_back(l_point);
+            }
+            ++m_size;
+        }
+        // a large batch becomes one tree instead of many small ones
+        if (m_pending.size() >= PENDING_SIZE)
+            p_Flush();
+    }
+
+    // same contract as CUniformGridIndex::Nearest()
+    bool Nearest(float a_x, float a_y, float a_maxDistance, uint32_t* a_id, float* a_distance = NULL,
+                 float a_scaleX = 1.0f, float a_scaleY = 1.0f) const
+    {
+        if (a_x != a_x || a_y != a_y)
+            return false;
+        SQuery l_query = {a_x, a_y, a_scaleX, a_scaleY, a_maxDistance * a_maxDistance, 0, false};
+        for (size_t i = 0; i < m_pending.size(); ++i)
+            p_Test(m_pending[i], &l_query);
+        for (size_t t = 0; t < m_trees.size(); ++t)
+            p_Search(m_trees[t], 0, m_trees[t].points.size(), &l_query);
+
+        if (!l_query.found)
+            return false;
+        *a_id = l_query.id;
+        if (a_distance)
+            *a_distance = sqrtf(l_query.best);
+        return true;
+    }
+
+private:
+    static const size_t LEAF_SIZE = 8;
+    static const size_t PENDING_SIZE = 1024;
+
+    struct SPoint
+    {
+        float x;
+        float y;
+        uint32_t id;
+    };
+
+    struct STree
+    {
+        std::vector<SPoint> points;
+        // split axis of the node whose median is at this position, 1 for y
+        std::vector<uint8_t> axis;
+    };
+
+    struct SQuery
+    {
+        float x;
+        float y;
+        float scaleX;
+        float scaleY;
+        // squared distance of the best point so far
+        float best;
+        uint32_t id;
+        bool found;
+    };
+
+    // largest first, each larger than the next
+    std::vector<STree> m_trees;
+    std::vector<SPoint> m_pending;
+    size_t m_size;
+
+    void p_Flush()
+    {
+        STree l_tree;
+        l_tree.points.swap(m_pending);
+        // carry into the trees that are not much larger
+        while (!m_trees.empty() && m_trees.back().points.size() <= l_tree.points.size())
+        {
+            const std::vector<SPoint>& l_last = m_trees.back().points;
+            l_tree.points.insert(l_tree.points.end(), l_last.begin(), l_last.end());
+            m_trees.pop_back();
+        }
+
+        std::vector<SPoint>& l_points = l_tree.points;
+        float l_xMin = FLT_MAX, l_xMax = -FLT_MAX, l_yMin = FLT_MAX, l_yMax = -FLT_MAX;
+        for (size_t i = 0; i < l_points.size(); ++i)
+        {
+            l_xMin = std::min(l_xMin, l_points[i].x);
+            l_xMax = std::max(l_xMax, l_points[i].x);
+            l_yMin = std::min(l_yMin, l_points[i].y);
+            l_yMax = std::max(l_yMax, l_points[i].y);
+        }
+        l_tree.axis.assign(l_points.size(), 0);
+        p_Split(l_tree, 0, l_points.size(), l_xMin, l_xMax, l_yMin, l_yMax);
+        m_trees.push_back(STree());
+        m_trees.back().points.swap(l_tree.points);
+        m_trees.back().axis.swap(l_tree.axis);
+    }
+
+    // the box is cut at every median instead of measured again, which is
+    // close enough to pick the longer side
+    static void p_Split(STree& a_tree, size_t a_begin, size_t a_end, float a_xMin, float a_xMax, float a_yMin,
+                        float a_yMax)
+    {
+        if (a_end - a_begin <= LEAF_SIZE)
+            return;
+        const size_t l_middle = a_begin + (a_end - a_begin) / 2;
+        std::vector<SPoint>::iterator l_points = a_tree.points.begin();
+        if (a_yMax - a_yMin > a_xMax - a_xMin)
+        {
+            std::nth_element(l_points + a_begin, l_points + l_middle, l_points + a_end,
+                             [](const SPoint& a_left, const SPoint& a_right) { return a_left.y < a_right.y; });
+            const float l_split = a_tree.points[l_middle].y;
+            a_tree.axis[l_middle] = 1;
+            p_Split(a_tree, a_begin, l_middle, a_xMin, a_xMax, a_yMin, l_split);
+            p_Split(a_tree, l_middle + 1, a_end, a_xMin, a_xMax, l_split, a_yMax);
+        }
+        else
+        {
+            std::nth_element(l_points + a_begin, l_points + l_middle, l_points + a_end,
+                             [](const SPoint& a_left, const SPoint& a_right) { return a_left.x < a_right.x; });
+            const float l_split = a_tree.points[l_middle].x;
+            p_Split(a_tree, a_begin, l_middle, a_xMin, l_split, a_yMin, a_yMax);
+            p_Split(a_tree, l_middle + 1, a_end, l_split, a_xMax, a_yMin, a_yMax);
+        }
+    }
+
+    static void p_Test(const SPoint& a_point, SQuery* a_query)
+    {
+        const float l_dx = (a_point.x - a_query->x) * a_query->scaleX;
+        const float l_dy = (a_point.y - a_query->y) * a_query->scaleY;
+        const float l_distance = l_dx * l_dx + l_dy * l_dy;
+        if (l_distance <= a_query->best)
+        {
+            a_query->best = l_distance;
+            a_query->id = a_point.id;
+            a_query->found = true;
+        }
+    }
+
+    static void p_Search(const STree& a_tree, size_t a_begin, size_t a_end, SQuery* a_query)
+    {
+        if (a_end - a_begin <= LEAF_SIZE)
+        {
+            for (size_t i = a_begin; i < a_end; ++i)
+                p_Test(a_tree.points[i], a_query);
+            return;
+        }
+        const size_t l_middle = a_begin + (a_end - a_begin) / 2;
+        const SPoint& l_median = a_tree.points[l_middle];
+        p_Test(l_median, a_query);
+        const float l_offset = a_tree.axis[l_middle] ? (a_query->y - l_median.y) * a_query->scaleY
+                                                     : (a_query->x - l_median.x) * a_query->scaleX;
+        // the side of the query first, the other one only if it can be closer
+        if (l_offset < 0.0f)
+        {
+            p_Search(a_tree, a_begin, l_middle, a_query);
+            if (l_offset * l_offset <= a_query->best)
+                p_Search(a_tree, l_middle + 1, a_end, a_query);
+        }
+        else
+        {
+            p_Search(a_tree, l_middle + 1, a_end, a_query);
+            if (l_offset * l_offset <= a_query->best)
+                p_Search(a_tree, a_begin, l_middle, a_query);
+        }
+    }
+};
+
+#endif
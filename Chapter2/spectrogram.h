@@ -0,0 +1,378 @@
+#ifndef SPECTROGRAM_H
+#define SPECTROGRAM_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "gl_functions.h"
+#include "vmath.h"
+
+#if defined(__SSE2__)
+#define SPECTROGRAM_SSE
+#include <emmintrin.h>
+#endif
+
+// In-place radix-2 complex FFT on split real/imaginary arrays. The split
+// layout lets every stage with at least four butterflies per group run four
+// of them per SSE instruction; twiddles are precomputed per stage so the
+// inner loop only streams memory.
+class CFFT
+{
+public:
+    CFFT()
+        : m_size(0)
+    {
+    }
+
+    // a_size must be a power of two
+    void Init(size_t a_size)
+    {
+        m_size = a_size;
+        m_reversed.resize(a_size);
+        int l_bits = 0;
+        while (((size_t)1 << l_bits) < a_size)
+            ++l_bits;
+        for (size_t i = 0; i < a_size; ++i)
+        {
+            size_t l_reversed = 0;
+            for (int b = 0; b < l_bits; ++b)
+                l_reversed |= ((i >> b) & 1) << (l_bits - 1 - b);
+            m_reversed[i] = l_reversed;
+        }
+        // stage with half size h keeps its h twiddles at offset h - 1
+        m_cos.resize(a_size > 1 ? a_size - 1 : 1);
+        m_sin.resize(m_cos.size());
+        for (size_t l_half = 1; l_half < a_size; l_half *= 2)
+        {
+            for (size_t j = 0; j < l_half; ++j)
+            {
+                const double l_angle = -M_PI * j / l_half;
+                m_cos[l_half - 1 + j] = (float)cos(l_angle);
+                m_sin[l_half - 1 + j] = (float)sin(l_angle);
+            }
+        }
+    }
+
+    size_t Size() const { return m_size; }
+
+    void Forward(float* a_re, float* a_im) const
+    {
+        for (size_t i = 0; i < m_size; ++i)
+        {
+            const size_t j = m_reversed[i];
+            if (j > i)
+            {
+                const float l_re = a_re[i], l_im = a_im[i];
+                a_re[i] = a_re[j];
+                a_im[i] = a_im[j];
+                a_re[j] = l_re;
+                a_im[j] = l_im;
+            }
+        }
+
+        for (size_t l_half = 1; l_half < m_size; l_half *= 2)
+        {
+            const float* l_cos = &m_cos[l_half - 1];
+            const float* l_sin = &m_sin[l_half - 1];
+            for (size_t l_start = 0; l_start < m_size; l_start += 2 * l_half)
+            {
+                float* l_reA = a_re + l_start;
+                float* l_imA = a_im + l_start;
+                float* l_reB = l_reA + l_half;
+                float* l_imB = l_imA + l_half;
+                size_t j = 0;
+#ifdef SPECTROGRAM_SSE
+                for (; j + 4 <= l_half; j += 4)
+                {
+                    const __m128 l_wr = _mm_loadu_ps(l_cos + j);
+                    const __m128 l_wi = _mm_loadu_ps(l_sin + j);
+                    const __m128 l_br = _mm_loadu_ps(l_reB + j);
+                    const __m128 l_bi = _mm_loadu_ps(l_imB + j);
+                    const __m128 l_tr = _mm_sub_ps(_mm_mul_ps(l_wr, l_br), _mm_mul_ps(l_wi, l_bi));
+                    const __m128 l_ti = _mm_add_ps(_mm_mul_ps(l_wr, l_bi), _mm_mul_ps(l_wi, l_br));
+                    const __m128 l_ar = _mm_loadu_ps(l_reA + j);
+                    const __m128 l_ai = _mm_loadu_ps(l_imA + j);
+                    _mm_storeu_ps(l_reB + j, _mm_sub_ps(l_ar, l_tr));
+                    _mm_storeu_ps(l_imB + j, _mm_sub_ps(l_ai, l_ti));
+                    _mm_storeu_ps(l_reA + j, _mm_add_ps(l_ar, l_tr));
+                    _mm_storeu_ps(l_imA + j, _mm_add_ps(l_ai, l_ti));
+                }
+#endif
+                for (; j < l_half; ++j)
+                {
+                    const float l_tr = l_cos[j] * l_reB[j] - l_sin[j] * l_imB[j];
+                    const float l_ti = l_cos[j] * l_imB[j] + l_sin[j] * l_reB[j];
+                    l_reB[j] = l_reA[j] - l_tr;
+                    l_imB[j] = l_imA[j] - l_ti;
+                    l_reA[j] += l_tr;
+                    l_imA[j] += l_ti;
+                }
+            }
+        }
+    }
+
+private:
+    size_t m_size;
+    std::vector<size_t> m_reversed;
+    std::vector<float> m_cos;
+    std::vector<float> m_sin;
+};
+
+// Scrolling spectrogram (waterfall) of several channels. Samples are pushed
+// per channel; every a_hop samples the last a_fftSize of them are Hann
+// windowed and transformed, and the power of the a_fftSize / 2 bins becomes
+// one colour mapped column of that channel's image.
+//
+// Each channel's image is a texture used as a ring: a new column replaces
+// the oldest one, only the new columns are uploaded, and Draw() scrolls by
+// shifting the texture coordinates (GL_REPEAT wraps around the ring). The
+// quad runs from the centre of the oldest column to the centre of the newest,
+// so GL_LINEAR never blends the two across the seam of the ring.
+class CSpectrogram
+{
+public:
+    CSpectrogram()
+        : m_numChannels(0), m_fftSize(0), m_hop(0), m_numColumns(0), m_minDecibels(-80.0f),
+          m_maxDecibels(0.0f)
+    {
+    }
+
+    ~CSpectrogram()
+    {
+        Release();
+    }
+
+    // a_fftSize and a_numColumns (the history length) must be powers of two;
+    // needs a current context
+    void Init(int a_numChannels, size_t a_fftSize, size_t a_hop, size_t a_numColumns)
+    {
+        Release();
+        m_numChannels = a_numChannels;
+        m_fftSize = a_fftSize;
+        m_hop = a_hop;
+        m_numColumns = a_numColumns;
+        m_fft.Init(a_fftSize);
+
+        // Hann window, scaled so a full scale sine peaks at 0 dB
+        m_window.resize(a_fftSize);
+        double l_sum = 0.0;
+        for (size_t i = 0; i < a_fftSize; ++i)
+        {
+            m_window[i] = (float)(0.5 - 0.5 * cos(2.0 * M_PI * i / a_fftSize));
+            l_sum += m_window[i];
+        }
+        for (size_t i = 0; i < a_fftSize; ++i)
+            m_window[i] = (float)(m_window[i] * 2.0 / l_sum);
+        m_re.resize(a_fftSize);
+        m_im.resize(a_fftSize);
+        m_power.resize(a_fftSize / 2);
+        p_BuildColorMap();
+
+        m_channels.resize(a_numChannels);
+        m_textures.resize(a_numChannels);
+        glGenTextures(a_numChannels, &m_textures[0]);
+        const std::vector<uint8_t> l_black(m_numColumns * Bins() * 4, 0);
+        for (int c = 0; c < a_numChannels; ++c)
+        {
+            SChannel& l_channel = m_channels[c];
+            l_channel.input.assign(a_fftSize, 0.0f);
+            l_channel.write = 0;
+            l_channel.received = 0;
+            l_channel.sinceColumn = 0;
+            l_channel.column = 0;
+            l_channel.dirtyBegin = l_channel.dirtyCount = 0;
+            l_channel.image.assign(m_numColumns * Bins() * 4, 0);
+
+            glBindTexture(GL_TEXTURE_2D, m_textures[c]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, (GLsizei)m_numColumns, (GLsizei)Bins(), 0, GL_RGBA,
+                         GL_UNSIGNED_BYTE, &l_black[0]);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    void Release()
+    {
+        if (!m_textures.empty())
+            glDeleteTextures((GLsizei)m_textures.size(), &m_textures[0]);
+        m_textures.clear();
+        m_channels.clear();
+        m_numChannels = 0;
+    }
+
+    size_t Bins() const { return m_fftSize / 2; }
+
+    // power range mapped onto the colour scale
+    void SetRange(float a_minDecibels, float a_maxDecibels)
+    {
+        m_minDecibels = a_minDecibels;
+        m_maxDecibels = a_maxDecibels;
+    }
+
+    // CPU only, may be called for many samples between two Upload() calls
+    void Process(int a_channel, const float* a_samples, size_t a_count)
+    {
+        SChannel& l_channel = m_channels[a_channel];
+        for (size_t i = 0; i < a_count; ++i)
+        {
+            l_channel.input[l_channel.write] = a_samples[i];
+            if (++l_channel.write == m_fftSize)
+                l_channel.write = 0;
+            ++l_channel.received;
+            if (++l_channel.sinceColumn >= m_hop && l_channel.received >= m_fftSize)
+            {
+                l_channel.sinceColumn = 0;
+                p_Column(l_channel);
+            }
+        }
+    }
+
+    // sends the columns computed since the last call to the textures
+    void Upload()
+    {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)m_numColumns);
+        for (int c = 0; c < m_numChannels; ++c)
+        {
+            SChannel& l_channel = m_channels[c];
+            if (l_channel.dirtyCount == 0)
+                continue;
+            glBindTexture(GL_TEXTURE_2D, m_textures[c]);
+            // the new columns are one run, or two when they wrap around the ring
+            size_t l_begin = l_channel.dirtyBegin;
+            size_t l_remaining = l_channel.dirtyCount < m_numColumns ? l_channel.dirtyCount : m_numColumns;
+            while (l_remaining > 0)
+            {
+                const size_t l_count = l_begin + l_remaining > m_numColumns ? m_numColumns - l_begin : l_remaining;
+                glPixelStorei(GL_UNPACK_SKIP_PIXELS, (GLint)l_begin);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)l_begin, 0, (GLsizei)l_count, (GLsizei)Bins(), GL_RGBA,
+                                GL_UNSIGNED_BYTE, &l_channel.image[0]);
+                l_remaining -= l_count;
+                l_begin = 0;
+            }
+            l_channel.dirtyCount = 0;
+        }
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    // oldest column at a_x0, newest at a_x1, frequency 0 at a_y0
+    void Draw(int a_channel, float a_x0, float a_y0, float a_x1, float a_y1) const
+    {
+        // the next column to be written is the oldest one; sampling starts and
+        // ends half a column inside the ring
+        const float l_u0 = (m_channels[a_channel].column + 0.5f) / m_numColumns;
+        const float l_u1 = l_u0 + (m_numColumns - 1.0f) / m_numColumns;
+        const GLfloat l_vertices[] = {a_x0, a_y0, a_x1, a_y0, a_x1, a_y1, a_x0, a_y1};
+        const GLfloat l_texCoords[] = {l_u0, 0.0f, l_u1, 0.0f, l_u1, 1.0f, l_u0, 1.0f};
+
+        glEnable(GL_TEXTURE_2D);
+        glBindTexture(GL_TEXTURE_2D, m_textures[a_channel]);
+        glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 0, l_vertices);
+        glTexCoordPointer(2, GL_FLOAT, 0, l_texCoords);
+        glDrawArrays(GL_QUADS, 0, 4);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glDisable(GL_TEXTURE_2D);
+    }
+
+private:
+    struct SChannel
+    {
+        // the last m_fftSize samples, a ring starting at write
+        std::vector<float> input;
+        size_t write;
+        uint64_t received;
+        size_t sinceColumn;
+        // next column of the image ring to be written
+        size_t column;
+        size_t dirtyBegin;
+        size_t dirtyCount;
+        // m_numColumns x Bins() RGBA, row-major like the texture
+        std::vector<uint8_t> image;
+    };
+
+    int m_numChannels;
+    size_t m_fftSize;
+    size_t m_hop;
+    size_t m_numColumns;
+    float m_minDecibels;
+    float m_maxDecibels;
+    CFFT m_fft;
+    std::vector<float> m_window;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+    std::vector<float> m_power;
+    uint8_t m_colorMap[256][4];
+    std::vector<SChannel> m_channels;
+    std::vector<GLuint> m_textures;
+
+    void p_BuildColorMap()
+    {
+        // black - blue - red - yellow - white
+        const float l_stops[5][3] = {{0, 0, 0}, {0, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}};
+        for (int i = 0; i < 256; ++i)
+        {
+            const float l_t = i / 255.0f * 4.0f;
+            int l_stop = (int)l_t;
+            if (l_stop > 3)
+                l_stop = 3;
+            const float l_f = l_t - l_stop;
+            for (int k = 0; k < 3; ++k)
+                m_colorMap[i][k] = (uint8_t)(255.0f * (l_stops[l_stop][k] + l_f * (l_stops[l_stop + 1][k] - l_stops[l_stop][k])) + 0.5f);
+            m_colorMap[i][3] = 255;
+        }
+    }
+
+    void p_Column(SChannel& a_channel)
+    {
+        // oldest sample first
+        for (size_t i = 0; i < m_fftSize; ++i)
+        {
+            size_t l_index = a_channel.write + i;
+            if (l_index >= m_fftSize)
+                l_index -= m_fftSize;
+            m_re[i] = a_channel.input[l_index] * m_window[i];
+            m_im[i] = 0.0f;
+        }
+        m_fft.Forward(&m_re[0], &m_im[0]);
+
+        const size_t l_bins = Bins();
+        for (size_t k = 0; k < l_bins; ++k)
+            m_power[k] = m_re[k] * m_re[k] + m_im[k] * m_im[k] + 1e-20f;
+        VecLog(&m_power[0], &m_power[0], l_bins);
+
+        // 10 log10(power), mapped onto the colour scale
+        const float l_toDecibels = 10.0f / logf(10.0f);
+        const float l_scale = 255.0f / (m_maxDecibels - m_minDecibels);
+        for (size_t k = 0; k < l_bins; ++k)
+        {
+            float l_level = (m_power[k] * l_toDecibels - m_minDecibels) * l_scale;
+            if (l_level < 0.0f)
+                l_level = 0.0f;
+            if (l_level > 255.0f)
+                l_level = 255.0f;
+            memcpy(&a_channel.image[(k * m_numColumns + a_channel.column) * 4], m_colorMap[(int)l_level], 4);
+        }
+
+        if (a_channel.dirtyCount == 0)
+            a_channel.dirtyBegin = a_channel.column;
+        ++a_channel.dirtyCount;
+        if (++a_channel.column == m_numColumns)
+            a_channel.column = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,9 @@
+#version 140
+
+in vec4 traceColor;
+out vec4 fragColor;
+
+void main()
+{
+    fragColor = traceColor;
+}
@@ -0,0 +1,26 @@
+#version 140
+
+// x across the chart in [0, 1], y the raw sample value
+in vec2 samplePoint;
+
+// vertices reserved for every channel in the vertex buffer
+uniform int slotSize;
+
+// per channel: (offset, scale, unused, unused) and colour, std140 keeps the
+// arrays tightly packed at 16 bytes per element
+layout(std140) uniform Channels
+{
+    vec4 transform[512];
+    vec4 color[512];
+};
+
+out vec4 traceColor;
+
+void main()
+{
+    // every channel owns a fixed slot, so the vertex index names the channel
+    int channel = gl_VertexID / slotSize;
+    float y = transform[channel].x + transform[channel].y * samplePoint.y;
+    gl_Position = vec4(samplePoint.x * 2.0 - 1.0, y, 0.0, 1.0);
+    traceColor = color[channel];
+}
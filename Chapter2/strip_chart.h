@@ -0,0 +1,209 @@
+#ifndef STRIP_CHART_H
+#define STRIP_CHART_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "decimation.h"
+#include "gl_functions.h"
+#include "shader.h"
+
+// must match the array size of the Channels block in strip.vert; 512
+// channels of two vec4 fill the 16 KB every implementation guarantees
+#define STRIP_CHART_MAX_CHANNELS 512
+
+// Stacked strip chart for many channels (EEG/ECG wards). All traces live in
+// one vertex buffer, each channel in a fixed slot of a_slotSize vertices, and
+// the whole chart is drawn with a single glMultiDrawArrays call. Per-channel
+// offset, scale and colour sit in a uniform buffer, so changing the layout
+// does not touch the vertex data. The chart always spans the full viewport.
+//
+// Contexts without uniform buffers draw every channel with its own call from
+// client memory, using the fixed function matrices for offset and scale.
+class CStripChart
+{
+public:
+    CStripChart()
+        : m_programId(0), m_vertexBuffer(0), m_uniformBuffer(0), m_sampleAttribute(-1),
+          m_slotSizeId(-1), m_numChannels(0), m_slotSize(0), m_channelsDirty(true)
+    {
+    }
+
+    ~CStripChart()
+    {
+        Release();
+    }
+
+    // needs a current context; returns false when a_numChannels is too large
+    bool Init(int a_numChannels, size_t a_slotSize, const char* a_vertexShaderPath,
+              const char* a_fragmentShaderPath)
+    {
+        if (a_numChannels <= 0 || a_numChannels > STRIP_CHART_MAX_CHANNELS)
+            return false;
+
+        m_numChannels = a_numChannels;
+        m_slotSize = a_slotSize;
+        m_points.assign(m_numChannels * m_slotSize, SStripPoint());
+        m_transforms.assign(4 * STRIP_CHART_MAX_CHANNELS, 0.0f);
+        m_colors.assign(4 * STRIP_CHART_MAX_CHANNELS, 1.0f);
+        m_firsts.resize(m_numChannels);
+        m_counts.assign(m_numChannels, 0);
+        for (int c = 0; c < m_numChannels; ++c)
+            m_firsts[c] = (GLint)(c * m_slotSize);
+        m_channelsDirty = true;
+
+        if (g_gl.hasUniformBuffers)
+            m_programId = LoadShaders(a_vertexShaderPath, a_fragmentShaderPath);
+        if (m_programId)
+        {
+            m_sampleAttribute = g_gl.GetAttribLocation(m_programId, "samplePoint");
+            m_slotSizeId = g_gl.GetUniformLocation(m_programId, "slotSize");
+            g_gl.UniformBlockBinding(m_programId, g_gl.GetUniformBlockIndex(m_programId, "Channels"),
+                                     CHANNELS_BINDING);
+            g_gl.GenBuffers(1, &m_vertexBuffer);
+            g_gl.GenBuffers(1, &m_uniformBuffer);
+        }
+        return true;
+    }
+
+    void Release()
+    {
+        if (m_programId)
+        {
+            g_gl.DeleteBuffers(1, &m_vertexBuffer);
+            g_gl.DeleteBuffers(1, &m_uniformBuffer);
+            g_gl.DeleteProgram(m_programId);
+            m_programId = 0;
+        }
+        m_numChannels = 0;
+    }
+
+    int NumChannels() const { return m_numChannels; }
+
+    // a_offsetY is the baseline in normalized device coordinates, a_scale
+    // multiplies the sample values
+    void SetChannel(int a_channel, float a_offsetY, float a_scale, float a_r, float a_g, float a_b, float a_a)
+    {
+        float* l_transform = &m_transforms[4 * a_channel];
+        float* l_color = &m_colors[4 * a_channel];
+        l_transform[0] = a_offsetY;
+        l_transform[1] = a_scale;
+        l_color[0] = a_r;
+        l_color[1] = a_g;
+        l_color[2] = a_b;
+        l_color[3] = a_a;
+        m_channelsDirty = true;
+    }
+
+    // replaces the trace of a channel; sample i is a_samples[i * a_stride].
+    // The window is reduced to at most 4 points per pixel column and never
+    // to more than the slot size.
+    void SetData(int a_channel, const float* a_samples, size_t a_numSamples, int a_columns, size_t a_stride = 1)
+    {
+        if (a_numSamples > m_slotSize && (a_columns <= 0 || 4 * (size_t)a_columns > m_slotSize))
+            a_columns = (int)(m_slotSize / 4);
+        SStripPoint* l_slot = &m_points[a_channel * m_slotSize];
+        const size_t l_count = DecimateM4Samples(a_samples, a_numSamples, a_columns, l_slot, a_stride);
+        // sample index to [0, 1] across the chart
+        const float l_scale = a_numSamples > 1 ? 1.0f / (a_numSamples - 1) : 0.0f;
+        for (size_t i = 0; i < l_count; ++i)
+            l_slot[i].x *= l_scale;
+        m_counts[a_channel] = (GLsizei)l_count;
+    }
+
+    void Draw()
+    {
+        if (m_numChannels == 0)
+            return;
+        if (m_programId)
+            p_DrawMulti();
+        else
+            p_DrawPerChannel();
+    }
+
+private:
+    struct SStripPoint
+    {
+        GLfloat x, y;
+    };
+
+    static const GLuint CHANNELS_BINDING = 0;
+
+    GLuint m_programId;
+    GLuint m_vertexBuffer;
+    GLuint m_uniformBuffer;
+    GLint m_sampleAttribute;
+    GLint m_slotSizeId;
+    int m_numChannels;
+    size_t m_slotSize;
+    bool m_channelsDirty;
+    std::vector<SStripPoint> m_points;
+    // std140 layout of the Channels block: all transforms, then all colours
+    std::vector<float> m_transforms;
+    std::vector<float> m_colors;
+    std::vector<GLint> m_firsts;
+    std::vector<GLsizei> m_counts;
+
+    void p_DrawMulti()
+    {
+        if (m_channelsDirty)
+        {
+            const size_t l_arrayBytes = m_transforms.size() * sizeof(float);
+            g_gl.BindBuffer(GL_UNIFORM_BUFFER, m_uniformBuffer);
+            g_gl.BufferData(GL_UNIFORM_BUFFER, 2 * l_arrayBytes, NULL, GL_STATIC_DRAW);
+            g_gl.BufferSubData(GL_UNIFORM_BUFFER, 0, l_arrayBytes, &m_transforms[0]);
+            g_gl.BufferSubData(GL_UNIFORM_BUFFER, l_arrayBytes, l_arrayBytes, &m_colors[0]);
+            g_gl.BindBuffer(GL_UNIFORM_BUFFER, 0);
+            m_channelsDirty = false;
+        }
+
+        // the traces change every frame: respecify the store instead of
+        // waiting for the previous draw
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.BufferData(GL_ARRAY_BUFFER, m_points.size() * sizeof(SStripPoint), &m_points[0], GL_STREAM_DRAW);
+        g_gl.EnableVertexAttribArray(m_sampleAttribute);
+        g_gl.VertexAttribPointer(m_sampleAttribute, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+        g_gl.UseProgram(m_programId);
+        g_gl.Uniform1i(m_slotSizeId, (GLint)m_slotSize);
+        g_gl.BindBufferBase(GL_UNIFORM_BUFFER, CHANNELS_BINDING, m_uniformBuffer);
+        glLineWidth(1.0f);
+        g_gl.MultiDrawArrays(GL_LINE_STRIP, &m_firsts[0], &m_counts[0], m_numChannels);
+
+        g_gl.UseProgram(0);
+        g_gl.DisableVertexAttribArray(m_sampleAttribute);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void p_DrawPerChannel()
+    {
+        // same mapping as strip.vert: x from [0, 1] to the full viewport
+        glMatrixMode(GL_PROJECTION);
+        glPushMatrix();
+        glLoadIdentity();
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glLineWidth(1.0f);
+        for (int c = 0; c < m_numChannels; ++c)
+        {
+            const float* l_transform = &m_transforms[4 * c];
+            const float* l_color = &m_colors[4 * c];
+            glLoadIdentity();
+            glTranslatef(-1.0f, l_transform[0], 0.0f);
+            glScalef(2.0f, l_transform[1], 1.0f);
+            glColor4f(l_color[0], l_color[1], l_color[2], l_color[3]);
+            glVertexPointer(2, GL_FLOAT, sizeof(SStripPoint), &m_points[c * m_slotSize]);
+            glDrawArrays(GL_LINE_STRIP, 0, m_counts[c]);
+        }
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        glPopMatrix();
+        glMatrixMode(GL_PROJECTION);
+        glPopMatrix();
+        glMatrixMode(GL_MODELVIEW);
+    }
+};
+
+#endif
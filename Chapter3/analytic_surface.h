@@ -0,0 +1,219 @@
+#ifndef ANALYTIC_SURFACE_H
+#define ANALYTIC_SURFACE_H
+
+#include <float.h>
+#include <stddef.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "color_map.h"
+#include "static_geometry.h"
+#include "thread_pool.h"
+
+// Height field z = f(x, y) sampled on a regular grid, cached on the CPU
+// (the samples) and on the GPU (the coloured vertices). Like
+// CStaticGeometry, the owner states which parameters the surface depends on
+// and Update() reports when they changed, so the samples are only
+// regenerated and re-uploaded then; every other frame is one draw call.
+//
+// Samples are stored x-major: sample (i, j) is at index i * Rows() + j.
+// Passes over the whole grid are split into TILE_SIZE x TILE_SIZE tiles
+// (16 KB of samples, so a tile and its output stay in L1/L2) which run on a
+// CThreadPool when one is given, serially otherwise. Generate() and
+// SetSeparable() also take the range of each tile while it is still in
+// cache, so Range() after them needs no second pass over the samples.
+template <typename TVertex>
+class CAnalyticSurface
+{
+public:
+    static const int TILE_SIZE = 64;
+
+    // a_tile(columnBegin, columnEnd, rowBegin, rowEnd) over a block of samples
+    typedef std::function<void(int, int, int, int)> TileFunction;
+
+    CAnalyticSurface()
+        : m_columns(0), m_rows(0), m_rangeValid(false)
+    {
+    }
+
+    void SetGrid(int a_columns, int a_rows, float a_xMin, float a_xMax, float a_yMin, float a_yMax)
+    {
+        m_columns = a_columns;
+        m_rows = a_rows;
+        m_x.resize(a_columns);
+        m_y.resize(a_rows);
+        for (int i = 0; i < a_columns; ++i)
+            m_x[i] = a_xMin + (a_xMax - a_xMin) * i / a_columns;
+        for (int j = 0; j < a_rows; ++j)
+            m_y[j] = a_yMin + (a_yMax - a_yMin) * j / a_rows;
+        m_z.resize((size_t)a_columns * a_rows);
+        m_tileMin.resize((size_t)TilesX() * TilesY());
+        m_tileMax.resize(m_tileMin.size());
+        m_rangeValid = false;
+        m_geometry.MarkDirty();
+    }
+
+    // true when the samples have to be regenerated
+    bool Update(const float* a_params, size_t a_numParams)
+    {
+        return m_geometry.Update(a_params, a_numParams);
+    }
+
+    int Columns() const { return m_columns; }
+    int Rows() const { return m_rows; }
+    size_t Size() const { return m_z.size(); }
+    // grid coordinates along x (Columns() values) and y (Rows() values)
+    const float* X() const { return &m_x[0]; }
+    const float* Y() const { return &m_y[0]; }
+    const float* Z() const { return &m_z[0]; }
+    // writing through this pointer invalidates the cached range
+    float* Z()
+    {
+        m_rangeValid = false;
+        return &m_z[0];
+    }
+
+    int TilesX() const { return (m_columns + TILE_SIZE - 1) / TILE_SIZE; }
+    int TilesY() const { return (m_rows + TILE_SIZE - 1) / TILE_SIZE; }
+
+    // calls a_tile once per tile; tiles may run concurrently on a_pool
+    void ForEachTile(const TileFunction& a_tile, CThreadPool* a_pool = NULL) const
+    {
+        // tiles are numbered x-major like the samples, so the contiguous run
+        // of tiles each thread starts with is also contiguous in memory
+        const int l_tilesY = TilesY();
+        const size_t l_numTiles = (size_t)TilesX() * l_tilesY;
+        const int l_columns = m_columns;
+        const int l_rows = m_rows;
+        std::function<void(size_t)> l_task = [&](size_t a_index)
+        {
+            const int l_column = (int)(a_index / l_tilesY) * TILE_SIZE;
+            const int l_row = (int)(a_index % l_tilesY) * TILE_SIZE;
+            a_tile(l_column, std::min(l_column + TILE_SIZE, l_columns),
+                   l_row, std::min(l_row + TILE_SIZE, l_rows));
+        };
+        if (a_pool)
+        {
+            a_pool->ParallelFor(l_numTiles, l_task);
+            return;
+        }
+        for (size_t t = 0; t < l_numTiles; ++t)
+            l_task(t);
+    }
+
+    // z = a_function(x, y) for every sample; a_function is any callable
+    // float(float, float) and must be safe to call from several threads
+    template <typename TFunction>
+    void Generate(const TFunction& a_function, CThreadPool* a_pool = NULL)
+    {
+        ForEachTile([&](int a_columnBegin, int a_columnEnd, int a_rowBegin, int a_rowEnd)
+        {
+            for (int i = a_columnBegin; i < a_columnEnd; ++i)
+            {
+                float* l_column = &m_z[(size_t)i * m_rows];
+                for (int j = a_rowBegin; j < a_rowEnd; ++j)
+                    l_column[j] = a_function(m_x[i], m_y[j]);
+            }
+            p_TileRange(a_columnBegin, a_columnEnd, a_rowBegin, a_rowEnd);
+        }, a_pool);
+        m_rangeValid = true;
+    }
+
+    // f(x, y) = a_scale * a_xFactors[i] * a_yFactors[j]: a separable function
+    // costs Columns() + Rows() evaluations instead of one per sample
+    void SetSeparable(const float* a_xFactors, const float* a_yFactors, float a_scale, CThreadPool* a_pool = NULL)
+    {
+        ForEachTile([&](int a_columnBegin, int a_columnEnd, int a_rowBegin, int a_rowEnd)
+        {
+            for (int i = a_columnBegin; i < a_columnEnd; ++i)
+            {
+                const float l_factor = a_scale * a_xFactors[i];
+                float* l_column = &m_z[(size_t)i * m_rows];
+                for (int j = a_rowBegin; j < a_rowEnd; ++j)
+                    l_column[j] = l_factor * a_yFactors[j];
+            }
+            p_TileRange(a_columnBegin, a_columnEnd, a_rowBegin, a_rowEnd);
+        }, a_pool);
+        m_rangeValid = true;
+    }
+
+    // smallest and largest finite sample, reduced per tile and then over the
+    // tiles; returns false (and 0, 0) when every sample is NaN or infinite
+    bool Range(float* a_min, float* a_max, CThreadPool* a_pool = NULL) const
+    {
+        if (!m_rangeValid)
+        {
+            ForEachTile([&](int a_columnBegin, int a_columnEnd, int a_rowBegin, int a_rowEnd)
+            {
+                p_TileRange(a_columnBegin, a_columnEnd, a_rowBegin, a_rowEnd);
+            }, a_pool);
+            m_rangeValid = true;
+        }
+        float l_min = FLT_MAX;
+        float l_max = -FLT_MAX;
+        for (size_t t = 0; t < m_tileMin.size(); ++t)
+        {
+            l_min = std::min(l_min, m_tileMin[t]);
+            l_max = std::max(l_max, m_tileMax[t]);
+        }
+        if (l_min > l_max)
+        {
+            *a_min = *a_max = 0.0f;
+            return false;
+        }
+        *a_min = l_min;
+        *a_max = l_max;
+        return true;
+    }
+
+    // a_vertices holds one coloured vertex per sample, in sample order
+    void Upload(GLenum a_mode, GLfloat a_size, const std::vector<TVertex>& a_vertices)
+    {
+        m_geometry.Upload(a_mode, a_size, a_vertices);
+    }
+
+    void Draw() const
+    {
+        m_geometry.Draw();
+    }
+
+    // needs a current context
+    void Release()
+    {
+        m_geometry.Release();
+    }
+
+private:
+    int m_columns;
+    int m_rows;
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    // finite range of every tile, FLT_MAX / -FLT_MAX for tiles without one
+    mutable std::vector<float> m_tileMin;
+    mutable std::vector<float> m_tileMax;
+    mutable bool m_rangeValid;
+    CStaticGeometry<TVertex> m_geometry;
+
+    // each tile writes only its own entry, so tiles can run concurrently
+    void p_TileRange(int a_columnBegin, int a_columnEnd, int a_rowBegin, int a_rowEnd) const
+    {
+        float l_min = FLT_MAX;
+        float l_max = -FLT_MAX;
+        for (int i = a_columnBegin; i < a_columnEnd; ++i)
+        {
+            float l_columnMin, l_columnMax;
+            if (FieldRange(&m_z[(size_t)i * m_rows + a_rowBegin], a_rowEnd - a_rowBegin, &l_columnMin, &l_columnMax))
+            {
+                l_min = std::min(l_min, l_columnMin);
+                l_max = std::max(l_max, l_columnMax);
+            }
+        }
+        const size_t l_tile = (size_t)(a_columnBegin / TILE_SIZE) * TilesY() + a_rowBegin / TILE_SIZE;
+        m_tileMin[l_tile] = l_min;
+        m_tileMax[l_tile] = l_max;
+    }
+};
+
+#endif
@@ -0,0 +1,4 @@
+#!/bin/bash
+# builds the benchmarks, each one prints its usage at the top of its source
+g++ -O2 -Wall -pthread `pkg-config --cflags glfw3` -o bench_thread_pool bench_thread_pool.cpp `pkg-config --static --libs glfw3` -framework OpenGL
+g++ -O2 -Wall -o bench_color_map bench_color_map.cpp
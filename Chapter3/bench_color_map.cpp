@@ -0,0 +1,207 @@
+// Benchmark of the heat map kernels of color_map.h against the two pass loop
+// the point heat map used before them.
+//
+//   g++ -O2 -o bench_color_map bench_color_map.cpp
+//   ./bench_color_map [max grid size]
+//
+// For square fields from 400^2 (the default Gaussian) up to 4096^2 samples:
+//   old      first pass for min/max seeded with -999.9/999.9, second pass
+//            colouring with the halfmax formula into float RGBA vertices,
+//            reading the {x, y, z} data points
+//   strided  FieldRange + HeatMapRGBA8 over the same data points into
+//            vertices with RGBA8 colour, as HeatMapVertices does
+//   packed   FieldRange + HeatMapRGBA8 over contiguous samples into an RGBA8
+//            image, as the texture path does
+// The kernels are also checked against the scalar HeatMapColor(): the exit
+// code is 1 when a colour differs by more than one step or the range is not
+// the one of the finite samples.
+
+#include "color_map.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+struct SData
+{
+    float x, y, z;
+};
+
+struct SVertex
+{
+    float x, y, z;
+    float r, g, b, a;
+};
+
+struct SHeatVertex
+{
+    float x, y, z;
+    uint8_t r, g, b, a;
+};
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// repeats a_frame until at least 0.2 s have passed, returns ms per call
+template <typename F>
+static double MillisecondsPerFrame(F a_frame)
+{
+    int l_frames = 0;
+    const double l_start = Seconds();
+    double l_elapsed = 0.0;
+    do
+    {
+        a_frame();
+        ++l_frames;
+        l_elapsed = Seconds() - l_start;
+    } while (l_elapsed < 0.2);
+    return l_elapsed * 1000.0 / l_frames;
+}
+
+// the loop of the point heat map before color_map.h
+static void OldHeatMap(const SData* a_data, size_t a_count, SVertex* a_vertices)
+{
+    float l_max = -999.9f;
+    float l_min = 999.9f;
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        if (a_data[i].z > l_max)
+            l_max = a_data[i].z;
+        if (a_data[i].z < l_min)
+            l_min = a_data[i].z;
+    }
+    const float l_halfmax = (l_max + l_min) / 2;
+    for (size_t i = 0; i < a_count; ++i)
+    {
+        float l_b = 1.0f - a_data[i].z / l_halfmax;
+        float l_r = a_data[i].z / l_halfmax - 1.0f;
+        if (l_b < 0)
+            l_b = 0;
+        if (l_r < 0)
+            l_r = 0;
+        SVertex l_vertex = {a_data[i].x, a_data[i].y, a_data[i].z, l_r, 1.0f - l_b - l_r, l_b, 0.5f};
+        a_vertices[i] = l_vertex;
+    }
+}
+
+// a Gaussian with a few NaN holes and infinite samples
+static void GenerateField(std::vector<SData>& a_data, std::vector<float>& a_z, int a_size)
+{
+    const size_t l_count = (size_t)a_size * a_size;
+    a_data.resize(l_count);
+    a_z.resize(l_count);
+    for (int i = 0; i < a_size; ++i)
+    {
+        const float l_x = -1.0f + 2.0f * i / a_size;
+        for (int j = 0; j < a_size; ++j)
+        {
+            const float l_y = -1.0f + 2.0f * j / a_size;
+            const size_t l_index = (size_t)i * a_size + j;
+            SData l_point = {l_x, l_y, expf(-(l_x * l_x + l_y * l_y) / 0.02f) / 0.0628f - 2.0f};
+            a_data[l_index] = l_point;
+        }
+    }
+    a_data[7].z = NAN;
+    a_data[l_count / 3].z = INFINITY;
+    a_data[l_count - 2].z = -INFINITY;
+    for (size_t i = 0; i < l_count; ++i)
+        a_z[i] = a_data[i].z;
+}
+
+// returns false when the kernels disagree with the scalar reference
+static bool Check(const std::vector<float>& a_z)
+{
+    const size_t l_count = a_z.size();
+    float l_min = 0.0f, l_max = 0.0f;
+    FieldRange(&a_z[0], l_count, &l_min, &l_max);
+    float l_finiteMin = FLT_MAX, l_finiteMax = -FLT_MAX;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        if (a_z[i] >= -FLT_MAX && a_z[i] <= FLT_MAX)
+        {
+            l_finiteMin = a_z[i] < l_finiteMin ? a_z[i] : l_finiteMin;
+            l_finiteMax = a_z[i] > l_finiteMax ? a_z[i] : l_finiteMax;
+        }
+    }
+    bool l_ok = l_min == l_finiteMin && l_max == l_finiteMax;
+
+    std::vector<uint8_t> l_rgba(4 * l_count);
+    HeatMapRGBA8(&a_z[0], l_count, l_min, l_max, 128, &l_rgba[0]);
+    int l_maxDifference = 0;
+    for (size_t i = 0; i < l_count; ++i)
+    {
+        float l_r, l_g, l_b;
+        uint8_t l_reference[4] = {0, 0, 0, 0};
+        if (HeatMapColor(a_z[i], l_min, l_max, &l_r, &l_g, &l_b))
+        {
+            l_reference[0] = (uint8_t)(l_r * 255.0f + 0.5f);
+            l_reference[1] = (uint8_t)(l_g * 255.0f + 0.5f);
+            l_reference[2] = (uint8_t)(l_b * 255.0f + 0.5f);
+            l_reference[3] = 128;
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            const int l_difference = abs((int)l_rgba[4 * i + k] - (int)l_reference[k]);
+            l_maxDifference = l_difference > l_maxDifference ? l_difference : l_maxDifference;
+        }
+    }
+    l_ok = l_ok && l_maxDifference <= 1;
+    printf("check: range %g .. %g, colours within %d step of HeatMapColor: %s\n\n", l_min, l_max, l_maxDifference,
+           l_ok ? "ok" : "FAILED");
+    return l_ok;
+}
+
+int main(int argc, char** argv)
+{
+    const int l_maxSize = argc > 1 ? atoi(argv[1]) : 4096;
+
+    std::vector<SData> l_data;
+    std::vector<float> l_z;
+    GenerateField(l_data, l_z, 1024);
+    const bool l_ok = Check(l_z);
+
+    std::vector<SVertex> l_vertices;
+    std::vector<SHeatVertex> l_heatVertices;
+    std::vector<uint8_t> l_image;
+    volatile float l_sink = 0.0f;
+    printf("%10s %12s %12s %12s %10s\n", "samples", "old ms", "strided ms", "packed ms", "speed-up");
+    const int l_sizes[] = {400, 1024, 2048, 4096};
+    for (size_t s = 0; s < sizeof(l_sizes) / sizeof(l_sizes[0]) && l_sizes[s] <= l_maxSize; ++s)
+    {
+        GenerateField(l_data, l_z, l_sizes[s]);
+        // the old loop has no answer for NaN and inf, give it finite data
+        for (size_t i = 0; i < l_z.size(); ++i)
+        {
+            if (!(l_z[i] >= -FLT_MAX && l_z[i] <= FLT_MAX))
+                l_data[i].z = l_z[i] = 0.0f;
+        }
+        const size_t l_count = l_z.size();
+        l_vertices.resize(l_count);
+        l_heatVertices.resize(l_count);
+        l_image.resize(4 * l_count);
+
+        const double l_oldMs = MillisecondsPerFrame([&]() {
+            OldHeatMap(&l_data[0], l_count, &l_vertices[0]);
+            l_sink = l_sink + l_vertices[l_count / 2].r;
+        });
+        const double l_stridedMs = MillisecondsPerFrame([&]() {
+            float l_min = 0.0f, l_max = 0.0f;
+            FieldRange(&l_data[0].z, l_count, &l_min, &l_max, sizeof(SData) / sizeof(float));
+            HeatMapRGBA8(&l_data[0].z, l_count, l_min, l_max, 128, &l_heatVertices[0].r, sizeof(SHeatVertex),
+                         sizeof(SData) / sizeof(float));
+            l_sink = l_sink + l_heatVertices[l_count / 2].r;
+        });
+        const double l_packedMs = MillisecondsPerFrame([&]() {
+            float l_min = 0.0f, l_max = 0.0f;
+            FieldRange(&l_z[0], l_count, &l_min, &l_max);
+            HeatMapRGBA8(&l_z[0], l_count, l_min, l_max, 128, &l_image[0]);
+            l_sink = l_sink + l_image[2 * l_count];
+        });
+        printf("%10zu %12.3f %12.3f %12.3f %9.1fx\n", l_count, l_oldMs, l_stridedMs, l_packedMs, l_oldMs / l_packedMs);
+    }
+    return l_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
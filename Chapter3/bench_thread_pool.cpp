@@ -0,0 +1,149 @@
+// Scaling benchmark of CThreadPool (thread_pool.h) from 1 to N threads.
+//
+//   g++ -O2 -pthread `pkg-config --cflags glfw3` -o bench_thread_pool bench_thread_pool.cpp `pkg-config --static --libs glfw3` -framework OpenGL
+//   ./bench_thread_pool [max threads] [grid size]
+//
+// The workloads are the tiled passes of a CAnalyticSurface (analytic_surface.h)
+// run on the pool: a grid of 4096^2 samples by default, split into its
+// TILE_SIZE x TILE_SIZE tiles, one task per tile. No context is created, GLFW
+// is only linked for the headers the surface includes.
+//   uniform    Generate() with the same Gaussian and sine for every sample,
+//              all tiles cost the same
+//   uneven     Generate() where only the samples near a narrow peak are
+//              expensive, the rest are a constant; the threads that own the
+//              peak tiles are relieved by stealing
+//   separable  SetSeparable(), what the Gaussian of main.cpp uses
+//   range      Range() over samples whose cached range was invalidated
+//   empty      ForEachTile() with tiles that do nothing, the fixed cost of
+//              one pass
+// For each thread count the time per pass, the speed-up over one thread and
+// the parallel efficiency (speed-up / threads) are printed. The maximum
+// defaults to the number of cores.
+
+#include "analytic_surface.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// the vertex of the heat map in main.cpp; nothing is uploaded here
+struct SVertex
+{
+    GLfloat x, y, z;
+    GLubyte r, g, b, a;
+};
+
+typedef CAnalyticSurface<SVertex> CSurface;
+
+static double Seconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// repeats a_frame until at least 0.2 s have passed, returns ms per call
+template <typename F>
+static double MillisecondsPerFrame(F a_frame)
+{
+    int l_frames = 0;
+    const double l_start = Seconds();
+    double l_elapsed = 0.0;
+    do
+    {
+        a_frame();
+        ++l_frames;
+        l_elapsed = Seconds() - l_start;
+    } while (l_elapsed < 0.2);
+    return l_elapsed * 1000.0 / l_frames;
+}
+
+static float Uniform(float a_x, float a_y)
+{
+    return expf(-(a_x * a_x + a_y * a_y) / 0.02f) + sinf(3.0f * a_x);
+}
+
+static float Uneven(float a_x, float a_y)
+{
+    // the peak sits in the first quarter, which one thread owns
+    const float l_dx = a_x + 0.75f;
+    if (l_dx * l_dx + a_y * a_y >= 0.05f)
+        return 0.0f;
+    float l_value = 0.0f;
+    for (int k = 1; k <= 16; ++k)
+        l_value += expf(-(l_dx * l_dx + a_y * a_y) * k) * sinf(k * a_x) / k;
+    return l_value;
+}
+
+struct SWorkload
+{
+    const char* name;
+    std::function<void(CSurface&, CThreadPool*)> pass;
+};
+
+int main(int argc, char** argv)
+{
+    int l_maxThreads = argc > 1 ? atoi(argv[1]) : (int)std::thread::hardware_concurrency();
+    const int l_size = argc > 2 ? atoi(argv[2]) : 4096;
+    if (l_maxThreads <= 0)
+        l_maxThreads = 1;
+    if (l_size < CSurface::TILE_SIZE)
+    {
+        printf("usage: %s [max threads] [grid size >= %d]\n", argv[0], CSurface::TILE_SIZE);
+        return EXIT_FAILURE;
+    }
+
+    CSurface l_surface;
+    l_surface.SetGrid(l_size, l_size, -1.0f, 1.0f, -1.0f, 1.0f);
+    // factors of a Gaussian with sigma 0.1, as GenerateGaussian() computes them
+    std::vector<float> l_xFactors(l_size), l_yFactors(l_size);
+    for (int i = 0; i < l_size; ++i)
+    {
+        l_xFactors[i] = expf(-l_surface.X()[i] * l_surface.X()[i] / 0.02f);
+        l_yFactors[i] = expf(-l_surface.Y()[i] * l_surface.Y()[i] / 0.02f);
+    }
+
+    std::vector<SWorkload> l_workloads;
+    SWorkload l_uniform = {"uniform", [](CSurface& a_surface, CThreadPool* a_pool) {
+        a_surface.Generate(Uniform, a_pool);
+    }};
+    SWorkload l_uneven = {"uneven", [](CSurface& a_surface, CThreadPool* a_pool) {
+        a_surface.Generate(Uneven, a_pool);
+    }};
+    SWorkload l_separable = {"separable", [&](CSurface& a_surface, CThreadPool* a_pool) {
+        a_surface.SetSeparable(&l_xFactors[0], &l_yFactors[0], 1.0f, a_pool);
+    }};
+    SWorkload l_range = {"range", [](CSurface& a_surface, CThreadPool* a_pool) {
+        float l_min, l_max;
+        // the writable samples invalidate the range of the last pass
+        a_surface.Z();
+        a_surface.Range(&l_min, &l_max, a_pool);
+    }};
+    SWorkload l_empty = {"empty", [](CSurface& a_surface, CThreadPool* a_pool) {
+        a_surface.ForEachTile([](int, int, int, int) {}, a_pool);
+    }};
+    l_workloads.push_back(l_uniform);
+    l_workloads.push_back(l_uneven);
+    l_workloads.push_back(l_separable);
+    l_workloads.push_back(l_range);
+    l_workloads.push_back(l_empty);
+
+    printf("%d x %d grid, %d x %d tiles, %d hardware threads\n", l_size, l_size, CSurface::TILE_SIZE,
+           CSurface::TILE_SIZE, (int)std::thread::hardware_concurrency());
+    printf("%-9s %8s %12s %10s %11s\n", "workload", "threads", "ms per pass", "speed-up", "efficiency");
+    for (size_t w = 0; w < l_workloads.size(); ++w)
+    {
+        double l_serialMs = 0.0;
+        for (int l_threads = 1; l_threads <= l_maxThreads; ++l_threads)
+        {
+            CThreadPool l_pool(l_threads);
+            const SWorkload& l_workload = l_workloads[w];
+            const double l_ms = MillisecondsPerFrame([&]() { l_workload.pass(l_surface, &l_pool); });
+            if (l_threads == 1)
+                l_serialMs = l_ms;
+            printf("%-9s %8d %12.3f %10.2f %10.0f%%\n", l_workload.name, l_threads, l_ms, l_serialMs / l_ms,
+                   100.0 * l_serialMs / l_ms / l_threads);
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+#ifndef COLOR_MAP_H
+#define COLOR_MAP_H
+
+#include <float.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#define COLOR_MAP_SSE
+#include <emmintrin.h>
+#endif
+
+// Kernels behind the Chapter 3 heat maps: the range of a field and the
+// blue-green-red ramp, written as packed RGBA8 (bytes r, g, b, a in memory),
+// plus lookup tables of the colour maps for the texture based renderer.
+// Both take any range, including negative and zero-width ones. NaN and
+// infinite samples are left out of the range and NaN cells are coloured
+// fully transparent, so holes in real data stay holes. Four samples are
+// processed at a time with SSE2, the remainder with the scalar versions.
+
+// blue for low, green for the middle and red for high values of
+// a_value in [a_min, a_max]; returns false (and black) for NaN
+inline bool HeatMapColor(float a_value, float a_min, float a_max, float* a_r, float* a_g, float* a_b)
+{
+    if (a_value != a_value)
+    {
+        *a_r = *a_g = *a_b = 0.0f;
+        return false;
+    }
+    // position in the range, the middle when the range is a single value
+    const float l_t = a_max > a_min ? (a_value - a_min) / (a_max - a_min) : 0.5f;
+    float l_b = 1.0f - 2.0f * l_t;
+    float l_r = 2.0f * l_t - 1.0f;
+    l_b = l_b < 0.0f ? 0.0f : (l_b > 1.0f ? 1.0f : l_b);
+    l_r = l_r < 0.0f ? 0.0f : (l_r > 1.0f ? 1.0f : l_r);
+    *a_b = l_b;
+    *a_r = l_r;
+    *a_g = 1.0f - l_b - l_r;
+    return true;
+}
+
+// smallest and largest finite value of a_values[i * a_stride]; returns false
+// (and leaves a_min/a_max alone) when there is none
+inline bool FieldRange(const float* a_values, size_t a_count, float* a_min, float* a_max, size_t a_stride = 1)
+{
+    float l_min = FLT_MAX;
+    float l_max = -FLT_MAX;
+    size_t i = 0;
+#ifdef COLOR_MAP_SSE
+    if (a_stride == 1 && a_count >= 4)
+    {
+        const __m128 l_absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        const __m128 l_largest = _mm_set1_ps(FLT_MAX);
+        const __m128 l_smallest = _mm_set1_ps(-FLT_MAX);
+        __m128 l_min4 = l_largest;
+        __m128 l_max4 = l_smallest;
+        for (; i + 4 <= a_count; i += 4)
+        {
+            const __m128 l_v = _mm_loadu_ps(a_values + i);
+            // |v| <= FLT_MAX is false for NaN and both infinities
+            const __m128 l_finite = _mm_cmple_ps(_mm_and_ps(l_v, l_absMask), l_largest);
+            l_min4 = _mm_min_ps(l_min4, _mm_or_ps(_mm_and_ps(l_finite, l_v), _mm_andnot_ps(l_finite, l_largest)));
+            l_max4 = _mm_max_ps(l_max4, _mm_or_ps(_mm_and_ps(l_finite, l_v), _mm_andnot_ps(l_finite, l_smallest)));
+        }
+        float l_lanes[4];
+        _mm_storeu_ps(l_lanes, l_min4);
+        for (int k = 0; k < 4; ++k)
+            l_min = l_lanes[k] < l_min ? l_lanes[k] : l_min;
+        _mm_storeu_ps(l_lanes, l_max4);
+        for (int k = 0; k < 4; ++k)
+            l_max = l_lanes[k] > l_max ? l_lanes[k] : l_max;
+    }
+#endif
+    for (; i < a_count; ++i)
+    {
+        const float l_v = a_values[i * a_stride];
+        if (!(l_v >= -FLT_MAX && l_v <= FLT_MAX))
+            continue;
+        l_min = l_v < l_min ? l_v : l_min;
+        l_max = l_v > l_max ? l_v : l_max;
+    }
+    if (l_min > l_max)
+        return false;
+    *a_min = l_min;
+    *a_max = l_max;
+    return true;
+}
+
+// colours a_values[i * a_stride] with HeatMapColor() into the four bytes at
+// a_out + i * a_outStride; NaN cells become 0 (transparent black)
+inline void HeatMapRGBA8(const float* a_values, size_t a_count, float a_min, float a_max, uint8_t a_alpha,
+                         uint8_t* a_out, size_t a_outStride = 4, size_t a_stride = 1)
+{
+    // t = a_value * scale + bias, the same as HeatMapColor()
+    const float l_scale = a_max > a_min ? 1.0f / (a_max - a_min) : 0.0f;
+    const float l_bias = a_max > a_min ? -a_min * l_scale : 0.5f;
+    size_t i = 0;
+#ifdef COLOR_MAP_SSE
+    if (a_stride == 1)
+    {
+        const __m128 l_scale4 = _mm_set1_ps(2.0f * l_scale);
+        const __m128 l_bias4 = _mm_set1_ps(2.0f * l_bias);
+        const __m128 l_zero = _mm_setzero_ps();
+        const __m128 l_one = _mm_set1_ps(1.0f);
+        const __m128 l_byte = _mm_set1_ps(255.0f);
+        const __m128i l_alpha = _mm_set1_epi32((int32_t)((uint32_t)a_alpha << 24));
+        for (; i + 4 <= a_count; i += 4)
+        {
+            const __m128 l_v = _mm_loadu_ps(a_values + i);
+            const __m128 l_t2 = _mm_add_ps(_mm_mul_ps(l_v, l_scale4), l_bias4);
+            const __m128 l_b = _mm_min_ps(_mm_max_ps(_mm_sub_ps(l_one, l_t2), l_zero), l_one);
+            const __m128 l_r = _mm_min_ps(_mm_max_ps(_mm_sub_ps(l_t2, l_one), l_zero), l_one);
+            const __m128 l_g = _mm_sub_ps(_mm_sub_ps(l_one, l_b), l_r);
+            __m128i l_rgba = _mm_cvtps_epi32(_mm_mul_ps(l_r, l_byte));
+            l_rgba = _mm_or_si128(l_rgba, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(l_g, l_byte)), 8));
+            l_rgba = _mm_or_si128(l_rgba, _mm_slli_epi32(_mm_cvtps_epi32(_mm_mul_ps(l_b, l_byte)), 16));
+            l_rgba = _mm_or_si128(l_rgba, l_alpha);
+            l_rgba = _mm_and_si128(l_rgba, _mm_castps_si128(_mm_cmpord_ps(l_v, l_v)));
+            if (a_outStride == 4)
+            {
+                _mm_storeu_si128((__m128i*)(a_out + 4 * i), l_rgba);
+            }
+            else
+            {
+                uint32_t l_packed[4];
+                _mm_storeu_si128((__m128i*)l_packed, l_rgba);
+                for (int k = 0; k < 4; ++k)
+                    memcpy(a_out + (i + k) * a_outStride, &l_packed[k], 4);
+            }
+        }
+    }
+#endif
+    for (; i < a_count; ++i)
+    {
+        uint8_t* l_out = a_out + i * a_outStride;
+        float l_r, l_g, l_b;
+        if (!HeatMapColor(a_values[i * a_stride], a_min, a_max, &l_r, &l_g, &l_b))
+        {
+            l_out[0] = l_out[1] = l_out[2] = l_out[3] = 0;
+            continue;
+        }
+        l_out[0] = (uint8_t)(l_r * 255.0f + 0.5f);
+        l_out[1] = (uint8_t)(l_g * 255.0f + 0.5f);
+        l_out[2] = (uint8_t)(l_b * 255.0f + 0.5f);
+        l_out[3] = a_alpha;
+    }
+}
+
+enum EColorMap
+{
+    // HeatMapColor(), the ramp of the point based demos
+    COLOR_MAP_BLUE_GREEN_RED,
+    // heatMap() of the Chapter 6 shaders
+    COLOR_MAP_JET,
+    // perceptually uniform, readable in grey scale and by colour blind users
+    COLOR_MAP_VIRIDIS,
+    COLOR_MAP_COUNT
+};
+
+inline const char* ColorMapName(EColorMap a_map)
+{
+    switch (a_map)
+    {
+        case COLOR_MAP_BLUE_GREEN_RED:
+            return "blue-green-red";
+        case COLOR_MAP_JET:
+            return "jet";
+        case COLOR_MAP_VIRIDIS:
+            return "viridis";
+        default:
+            return "unknown";
+    }
+}
+
+// a_size RGBA8 entries sampling a_map evenly from the low to the high end
+inline void BuildColorMapLUT(EColorMap a_map, uint8_t* a_out, int a_size)
+{
+    // viridis at t = 0, 1/8, ..., 1; linear in between
+    static const uint8_t VIRIDIS[9][3] = {
+        {68, 1, 84}, {71, 44, 122}, {59, 81, 139}, {44, 113, 142}, {33, 144, 141},
+        {39, 173, 129}, {92, 200, 99}, {170, 220, 50}, {253, 231, 37}};
+
+    for (int i = 0; i < a_size; ++i)
+    {
+        const float l_t = a_size > 1 ? (float)i / (a_size - 1) : 0.5f;
+        float l_rgb[3];
+        switch (a_map)
+        {
+            case COLOR_MAP_JET:
+            {
+                // piecewise linear through blue, cyan, green, yellow and red
+                l_rgb[0] = l_rgb[1] = l_rgb[2] = 1.0f;
+                if (l_t < 0.25f)
+                {
+                    l_rgb[0] = 0.0f;
+                    l_rgb[1] = 4.0f * l_t;
+                }
+                else if (l_t < 0.5f)
+                {
+                    l_rgb[0] = 0.0f;
+                    l_rgb[2] = 1.0f + 4.0f * (0.25f - l_t);
+                }
+                else if (l_t < 0.75f)
+                {
+                    l_rgb[0] = 4.0f * (l_t - 0.5f);
+                    l_rgb[2] = 0.0f;
+                }
+                else
+                {
+                    l_rgb[1] = 1.0f + 4.0f * (0.75f - l_t);
+                    l_rgb[2] = 0.0f;
+                }
+                break;
+            }
+            case COLOR_MAP_VIRIDIS:
+            {
+                const float l_position = l_t * 8.0f;
+                const int l_key = l_position >= 8.0f ? 7 : (int)l_position;
+                const float l_f = l_position - l_key;
+                for (int c = 0; c < 3; ++c)
+                    l_rgb[c] = (VIRIDIS[l_key][c] + l_f * (VIRIDIS[l_key + 1][c] - VIRIDIS[l_key][c])) / 255.0f;
+                break;
+            }
+            default:
+                HeatMapColor(l_t, 0.0f, 1.0f, &l_rgb[0], &l_rgb[1], &l_rgb[2]);
+                break;
+        }
+        for (int c = 0; c < 3; ++c)
+            a_out[4 * i + c] = (uint8_t)(l_rgb[c] * 255.0f + 0.5f);
+        a_out[4 * i + 3] = 255;
+    }
+}
+
+#endif
@@ -0,0 +1,8 @@
+#version 120
+
+// 2-D Gaussian with sigma = params.x, as in GaussianDemo
+float surface(vec2 p, vec4 params)
+{
+    float variance = params.x * params.x;
+    return exp(-0.5 * dot(p, p) / variance) / (2.0 * 3.14159265 * variance);
+}
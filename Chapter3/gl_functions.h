@@ -0,0 +1,162 @@
+#ifndef GL_FUNCTIONS_H
+#define GL_FUNCTIONS_H
+
+// The demos only link against the OpenGL 1.1 entry points, anything
+// newer (buffer objects, sync objects, persistent mapping) is looked up at
+// runtime through GLFW once a context is current.
+#ifndef GLFW_INCLUDE_GLEXT
+#define GLFW_INCLUDE_GLEXT
+#endif
+#include <GLFW/glfw3.h>
+#include <stdio.h>
+
+struct SGLFunctions
+{
+    // OpenGL 1.5 buffer objects
+    PFNGLGENBUFFERSPROC GenBuffers;
+    PFNGLDELETEBUFFERSPROC DeleteBuffers;
+    PFNGLBINDBUFFERPROC BindBuffer;
+    PFNGLBUFFERDATAPROC BufferData;
+    PFNGLBUFFERSUBDATAPROC BufferSubData;
+    // OpenGL 3.0 / 3.2 mapping and sync objects
+    PFNGLMAPBUFFERRANGEPROC MapBufferRange;
+    PFNGLUNMAPBUFFERPROC UnmapBuffer;
+    PFNGLFENCESYNCPROC FenceSync;
+    PFNGLCLIENTWAITSYNCPROC ClientWaitSync;
+    PFNGLDELETESYNCPROC DeleteSync;
+    // OpenGL 4.4 / ARB_buffer_storage
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+    // OpenGL 2.0 shaders and generic vertex attributes
+    PFNGLCREATESHADERPROC CreateShader;
+    PFNGLDELETESHADERPROC DeleteShader;
+    PFNGLSHADERSOURCEPROC ShaderSource;
+    PFNGLCOMPILESHADERPROC CompileShader;
+    PFNGLGETSHADERIVPROC GetShaderiv;
+    PFNGLGETSHADERINFOLOGPROC GetShaderInfoLog;
+    PFNGLCREATEPROGRAMPROC CreateProgram;
+    PFNGLDELETEPROGRAMPROC DeleteProgram;
+    PFNGLATTACHSHADERPROC AttachShader;
+    PFNGLLINKPROGRAMPROC LinkProgram;
+    PFNGLBINDATTRIBLOCATIONPROC BindAttribLocation;
+    PFNGLGETPROGRAMIVPROC GetProgramiv;
+    PFNGLGETPROGRAMINFOLOGPROC GetProgramInfoLog;
+    PFNGLUSEPROGRAMPROC UseProgram;
+    PFNGLGETUNIFORMLOCATIONPROC GetUniformLocation;
+    PFNGLGETATTRIBLOCATIONPROC GetAttribLocation;
+    PFNGLUNIFORM1FPROC Uniform1f;
+    PFNGLUNIFORM2FPROC Uniform2f;
+    PFNGLUNIFORM4FPROC Uniform4f;
+    PFNGLVERTEXATTRIBPOINTERPROC VertexAttribPointer;
+    PFNGLENABLEVERTEXATTRIBARRAYPROC EnableVertexAttribArray;
+    PFNGLDISABLEVERTEXATTRIBARRAYPROC DisableVertexAttribArray;
+    PFNGLVERTEXATTRIB1FPROC VertexAttrib1f;
+    PFNGLVERTEXATTRIB4FPROC VertexAttrib4f;
+    // OpenGL 3.1 / 3.3 instanced rendering
+    PFNGLDRAWARRAYSINSTANCEDPROC DrawArraysInstanced;
+    PFNGLVERTEXATTRIBDIVISORPROC VertexAttribDivisor;
+    // OpenGL 1.4 multi-draw
+    PFNGLMULTIDRAWARRAYSPROC MultiDrawArrays;
+    // OpenGL 3.1 / ARB_uniform_buffer_object
+    PFNGLGETUNIFORMBLOCKINDEXPROC GetUniformBlockIndex;
+    PFNGLUNIFORMBLOCKBINDINGPROC UniformBlockBinding;
+    PFNGLBINDBUFFERBASEPROC BindBufferBase;
+    PFNGLUNIFORM1IPROC Uniform1i;
+    // OpenGL 1.3 multitexture
+    PFNGLACTIVETEXTUREPROC ActiveTexture;
+
+    int version;
+    bool hasBuffers;
+    bool hasPersistentMapping;
+    bool hasShaders;
+    bool hasInstancing;
+    bool hasUniformBuffers;
+    // single channel float textures (GL_R32F) that shaders can sample
+    bool hasFloatTextures;
+};
+
+static SGLFunctions g_gl;
+
+// Resolves the entry points above for the current context. Returns false
+// when not even buffer objects are available.
+bool LoadGLFunctions()
+{
+    // context version as major * 10 + minor
+    int l_major = 0, l_minor = 0;
+    const char* l_version = (const char*)glGetString(GL_VERSION);
+    if (l_version)
+        sscanf(l_version, "%d.%d", &l_major, &l_minor);
+    g_gl.version = l_major * 10 + l_minor;
+
+    g_gl.GenBuffers = (PFNGLGENBUFFERSPROC)glfwGetProcAddress("glGenBuffers");
+    g_gl.DeleteBuffers = (PFNGLDELETEBUFFERSPROC)glfwGetProcAddress("glDeleteBuffers");
+    g_gl.BindBuffer = (PFNGLBINDBUFFERPROC)glfwGetProcAddress("glBindBuffer");
+    g_gl.BufferData = (PFNGLBUFFERDATAPROC)glfwGetProcAddress("glBufferData");
+    g_gl.BufferSubData = (PFNGLBUFFERSUBDATAPROC)glfwGetProcAddress("glBufferSubData");
+    g_gl.MapBufferRange = (PFNGLMAPBUFFERRANGEPROC)glfwGetProcAddress("glMapBufferRange");
+    g_gl.UnmapBuffer = (PFNGLUNMAPBUFFERPROC)glfwGetProcAddress("glUnmapBuffer");
+    g_gl.FenceSync = (PFNGLFENCESYNCPROC)glfwGetProcAddress("glFenceSync");
+    g_gl.ClientWaitSync = (PFNGLCLIENTWAITSYNCPROC)glfwGetProcAddress("glClientWaitSync");
+    g_gl.DeleteSync = (PFNGLDELETESYNCPROC)glfwGetProcAddress("glDeleteSync");
+    g_gl.BufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+
+    g_gl.CreateShader = (PFNGLCREATESHADERPROC)glfwGetProcAddress("glCreateShader");
+    g_gl.DeleteShader = (PFNGLDELETESHADERPROC)glfwGetProcAddress("glDeleteShader");
+    g_gl.ShaderSource = (PFNGLSHADERSOURCEPROC)glfwGetProcAddress("glShaderSource");
+    g_gl.CompileShader = (PFNGLCOMPILESHADERPROC)glfwGetProcAddress("glCompileShader");
+    g_gl.GetShaderiv = (PFNGLGETSHADERIVPROC)glfwGetProcAddress("glGetShaderiv");
+    g_gl.GetShaderInfoLog = (PFNGLGETSHADERINFOLOGPROC)glfwGetProcAddress("glGetShaderInfoLog");
+    g_gl.CreateProgram = (PFNGLCREATEPROGRAMPROC)glfwGetProcAddress("glCreateProgram");
+    g_gl.DeleteProgram = (PFNGLDELETEPROGRAMPROC)glfwGetProcAddress("glDeleteProgram");
+    g_gl.AttachShader = (PFNGLATTACHSHADERPROC)glfwGetProcAddress("glAttachShader");
+    g_gl.LinkProgram = (PFNGLLINKPROGRAMPROC)glfwGetProcAddress("glLinkProgram");
+    g_gl.BindAttribLocation = (PFNGLBINDATTRIBLOCATIONPROC)glfwGetProcAddress("glBindAttribLocation");
+    g_gl.GetProgramiv = (PFNGLGETPROGRAMIVPROC)glfwGetProcAddress("glGetProgramiv");
+    g_gl.GetProgramInfoLog = (PFNGLGETPROGRAMINFOLOGPROC)glfwGetProcAddress("glGetProgramInfoLog");
+    g_gl.UseProgram = (PFNGLUSEPROGRAMPROC)glfwGetProcAddress("glUseProgram");
+    g_gl.GetUniformLocation = (PFNGLGETUNIFORMLOCATIONPROC)glfwGetProcAddress("glGetUniformLocation");
+    g_gl.GetAttribLocation = (PFNGLGETATTRIBLOCATIONPROC)glfwGetProcAddress("glGetAttribLocation");
+    g_gl.Uniform1f = (PFNGLUNIFORM1FPROC)glfwGetProcAddress("glUniform1f");
+    g_gl.Uniform2f = (PFNGLUNIFORM2FPROC)glfwGetProcAddress("glUniform2f");
+    g_gl.Uniform4f = (PFNGLUNIFORM4FPROC)glfwGetProcAddress("glUniform4f");
+    g_gl.VertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC)glfwGetProcAddress("glVertexAttribPointer");
+    g_gl.EnableVertexAttribArray = (PFNGLENABLEVERTEXATTRIBARRAYPROC)glfwGetProcAddress("glEnableVertexAttribArray");
+    g_gl.DisableVertexAttribArray = (PFNGLDISABLEVERTEXATTRIBARRAYPROC)glfwGetProcAddress("glDisableVertexAttribArray");
+    g_gl.VertexAttrib1f = (PFNGLVERTEXATTRIB1FPROC)glfwGetProcAddress("glVertexAttrib1f");
+    g_gl.VertexAttrib4f = (PFNGLVERTEXATTRIB4FPROC)glfwGetProcAddress("glVertexAttrib4f");
+    g_gl.DrawArraysInstanced = (PFNGLDRAWARRAYSINSTANCEDPROC)glfwGetProcAddress("glDrawArraysInstanced");
+    g_gl.VertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC)glfwGetProcAddress("glVertexAttribDivisor");
+    g_gl.MultiDrawArrays = (PFNGLMULTIDRAWARRAYSPROC)glfwGetProcAddress("glMultiDrawArrays");
+    g_gl.GetUniformBlockIndex = (PFNGLGETUNIFORMBLOCKINDEXPROC)glfwGetProcAddress("glGetUniformBlockIndex");
+    g_gl.UniformBlockBinding = (PFNGLUNIFORMBLOCKBINDINGPROC)glfwGetProcAddress("glUniformBlockBinding");
+    g_gl.BindBufferBase = (PFNGLBINDBUFFERBASEPROC)glfwGetProcAddress("glBindBufferBase");
+    g_gl.Uniform1i = (PFNGLUNIFORM1IPROC)glfwGetProcAddress("glUniform1i");
+    g_gl.ActiveTexture = (PFNGLACTIVETEXTUREPROC)glfwGetProcAddress("glActiveTexture");
+
+    g_gl.hasBuffers = g_gl.GenBuffers && g_gl.DeleteBuffers && g_gl.BindBuffer &&
+                      g_gl.BufferData && g_gl.BufferSubData;
+    // some drivers hand out pointers for entry points they do not support,
+    // so also check the context version or the extension string
+    g_gl.hasPersistentMapping = g_gl.hasBuffers && g_gl.BufferStorage && g_gl.MapBufferRange &&
+                                g_gl.UnmapBuffer && g_gl.FenceSync && g_gl.ClientWaitSync && g_gl.DeleteSync &&
+                                (g_gl.version >= 44 || glfwExtensionSupported("GL_ARB_buffer_storage"));
+    g_gl.hasShaders = g_gl.CreateShader && g_gl.DeleteShader && g_gl.ShaderSource && g_gl.CompileShader &&
+                      g_gl.GetShaderiv && g_gl.GetShaderInfoLog && g_gl.CreateProgram && g_gl.DeleteProgram &&
+                      g_gl.AttachShader && g_gl.LinkProgram && g_gl.BindAttribLocation && g_gl.GetProgramiv &&
+                      g_gl.GetProgramInfoLog && g_gl.UseProgram && g_gl.GetUniformLocation && g_gl.GetAttribLocation &&
+                      g_gl.Uniform1f && g_gl.Uniform2f && g_gl.Uniform4f && g_gl.VertexAttribPointer &&
+                      g_gl.EnableVertexAttribArray && g_gl.DisableVertexAttribArray && g_gl.VertexAttrib1f &&
+                      g_gl.VertexAttrib4f;
+    g_gl.hasInstancing = g_gl.hasBuffers && g_gl.hasShaders && g_gl.DrawArraysInstanced &&
+                         g_gl.VertexAttribDivisor &&
+                         (g_gl.version >= 33 || glfwExtensionSupported("GL_ARB_instanced_arrays"));
+    g_gl.hasUniformBuffers = g_gl.hasBuffers && g_gl.hasShaders && g_gl.MultiDrawArrays &&
+                             g_gl.GetUniformBlockIndex && g_gl.UniformBlockBinding && g_gl.BindBufferBase &&
+                             g_gl.Uniform1i &&
+                             (g_gl.version >= 31 || glfwExtensionSupported("GL_ARB_uniform_buffer_object"));
+    g_gl.hasFloatTextures = g_gl.hasShaders && g_gl.Uniform1i && g_gl.ActiveTexture &&
+                            (g_gl.version >= 30 || (glfwExtensionSupported("GL_ARB_texture_float") &&
+                                                    glfwExtensionSupported("GL_ARB_texture_rg")));
+    return g_gl.hasBuffers;
+}
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef GPU_HEAT_MAP_H
+#define GPU_HEAT_MAP_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "color_map.h"
+#include "gl_functions.h"
+#include "heat_map_texture.h"
+#include "shader.h"
+
+// Heat map surface evaluated entirely on the GPU. The XY grid is uploaded
+// once; the vertex shader computes z = surface(x, y) from a few uniforms and
+// the fragment shader colours it from the lookup textures of
+// CreateColorMapTextures(), the same ramps as the CPU modes. A parameter
+// change costs a handful of glUniform calls instead of regenerating and
+// re-uploading every vertex.
+//
+// Functions are registered as GLSL files defining
+//     float surface(vec2 p, vec4 params);
+// which get linked into the vertex stage next to the shared heatmap.vert.
+class CGPUHeatMap
+{
+public:
+    CGPUHeatMap()
+        : m_vertexBuffer(0), m_count(0)
+    {
+        for (int i = 0; i < COLOR_MAP_COUNT; ++i)
+            m_lutTextures[i] = 0;
+    }
+
+    ~CGPUHeatMap()
+    {
+        Release();
+    }
+
+    // needs a current context with shaders and buffer objects
+    bool IsAvailable() const { return g_gl.hasShaders && g_gl.hasBuffers; }
+
+    // uploads the a_columns x a_rows grid, x-major like CAnalyticSurface
+    bool Init(int a_columns, int a_rows, float a_xMin, float a_xMax, float a_yMin, float a_yMax)
+    {
+        if (!IsAvailable() || a_columns <= 0 || a_rows <= 0)
+            return false;
+
+        std::vector<GLfloat> l_grid;
+        l_grid.reserve(2 * (size_t)a_columns * a_rows);
+        for (int i = 0; i < a_columns; ++i)
+        {
+            const float l_x = a_xMin + (a_xMax - a_xMin) * i / a_columns;
+            for (int j = 0; j < a_rows; ++j)
+            {
+                l_grid.push_back(l_x);
+                l_grid.push_back(a_yMin + (a_yMax - a_yMin) * j / a_rows);
+            }
+        }
+        m_count = (size_t)a_columns * a_rows;
+        if (!m_vertexBuffer)
+        {
+            g_gl.GenBuffers(1, &m_vertexBuffer);
+            CreateColorMapTextures(m_lutTextures);
+        }
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.BufferData(GL_ARRAY_BUFFER, l_grid.size() * sizeof(GLfloat), &l_grid[0], GL_STATIC_DRAW);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        return true;
+    }
+
+    // links a_functionPath with the heat map shaders; returns the id to pass
+    // to Draw(), or -1 when the program could not be built
+    int RegisterFunction(const char* a_functionPath, const char* a_vertexShaderPath = "heatmap.vert",
+                         const char* a_fragmentShaderPath = "heatmap.frag")
+    {
+        if (!IsAvailable())
+            return -1;
+        const char* l_vertexShaderPaths[] = {a_vertexShaderPath, a_functionPath};
+        SProgram l_program;
+        l_program.id = LoadShaders(l_vertexShaderPaths, 2, a_fragmentShaderPath);
+        if (!l_program.id)
+            return -1;
+        l_program.gridPoint = g_gl.GetAttribLocation(l_program.id, "gridPoint");
+        l_program.surfaceParams = g_gl.GetUniformLocation(l_program.id, "surfaceParams");
+        l_program.valueScale = g_gl.GetUniformLocation(l_program.id, "valueScale");
+        l_program.colorMap = g_gl.GetUniformLocation(l_program.id, "colorMap");
+        l_program.lutScale = g_gl.GetUniformLocation(l_program.id, "lutScale");
+        l_program.transparency = g_gl.GetUniformLocation(l_program.id, "transparency");
+        m_programs.push_back(l_program);
+        return (int)m_programs.size() - 1;
+    }
+
+    // a_params are handed to surface(); values from a_min to a_max span
+    // a_colorMap
+    void Draw(int a_function, const float a_params[4], EColorMap a_colorMap, float a_min, float a_max,
+              float a_transparency, GLfloat a_pointSize) const
+    {
+        if (a_function < 0 || a_function >= (int)m_programs.size() || m_count == 0)
+            return;
+        const SProgram& l_program = m_programs[a_function];
+
+        glBindTexture(GL_TEXTURE_1D, m_lutTextures[a_colorMap]);
+        g_gl.UseProgram(l_program.id);
+        g_gl.Uniform4f(l_program.surfaceParams, a_params[0], a_params[1], a_params[2], a_params[3]);
+        // same normalisation as HeatMapColor(), the middle for an empty range
+        if (a_max > a_min)
+            g_gl.Uniform2f(l_program.valueScale, 1.0f / (a_max - a_min), -a_min / (a_max - a_min));
+        else
+            g_gl.Uniform2f(l_program.valueScale, 0.0f, 0.5f);
+        g_gl.Uniform1i(l_program.colorMap, 0);
+        g_gl.Uniform2f(l_program.lutScale, (COLOR_MAP_LUT_SIZE - 1.0f) / COLOR_MAP_LUT_SIZE,
+                       0.5f / COLOR_MAP_LUT_SIZE);
+        g_gl.Uniform1f(l_program.transparency, a_transparency);
+
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.EnableVertexAttribArray(l_program.gridPoint);
+        g_gl.VertexAttribPointer(l_program.gridPoint, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        glPointSize(a_pointSize);
+        glDrawArrays(GL_POINTS, 0, (GLsizei)m_count);
+        g_gl.DisableVertexAttribArray(l_program.gridPoint);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        g_gl.UseProgram(0);
+        glBindTexture(GL_TEXTURE_1D, 0);
+    }
+
+    // needs a current context
+    void Release()
+    {
+        if (m_vertexBuffer)
+        {
+            g_gl.DeleteBuffers(1, &m_vertexBuffer);
+            glDeleteTextures(COLOR_MAP_COUNT, m_lutTextures);
+            m_vertexBuffer = 0;
+        }
+        for (size_t i = 0; i < m_programs.size(); ++i)
+            g_gl.DeleteProgram(m_programs[i].id);
+        m_programs.clear();
+        m_count = 0;
+    }
+
+private:
+    struct SProgram
+    {
+        GLuint id;
+        GLint gridPoint;
+        GLint surfaceParams;
+        GLint valueScale;
+        GLint colorMap;
+        GLint lutScale;
+        GLint transparency;
+    };
+
+    GLuint m_vertexBuffer;
+    GLuint m_lutTextures[COLOR_MAP_COUNT];
+    size_t m_count;
+    std::vector<SProgram> m_programs;
+};
+
+#endif
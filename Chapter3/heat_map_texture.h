@@ -0,0 +1,247 @@
+#ifndef HEAT_MAP_TEXTURE_H
+#define HEAT_MAP_TEXTURE_H
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+
+#include "color_map.h"
+#include "gl_functions.h"
+#include "shader.h"
+
+#define COLOR_MAP_LUT_SIZE 256
+
+// one 1-D RGBA8 texture per colour map, filled by BuildColorMapLUT(); the
+// shaders of every GPU heat map look their colours up in these, so they
+// match the ramps of the CPU paths. Needs a current context
+inline void CreateColorMapTextures(GLuint a_textures[COLOR_MAP_COUNT])
+{
+    std::vector<uint8_t> l_lut(4 * COLOR_MAP_LUT_SIZE);
+    glGenTextures(COLOR_MAP_COUNT, a_textures);
+    for (int i = 0; i < COLOR_MAP_COUNT; ++i)
+    {
+        BuildColorMapLUT((EColorMap)i, &l_lut[0], COLOR_MAP_LUT_SIZE);
+        glBindTexture(GL_TEXTURE_1D, a_textures[i]);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, COLOR_MAP_LUT_SIZE, 0, GL_RGBA, GL_UNSIGNED_BYTE, &l_lut[0]);
+    }
+    glBindTexture(GL_TEXTURE_1D, 0);
+}
+
+// Heat map drawn as one textured quad instead of a point per cell. The field
+// is a single channel float texture (GL_R32F) and the fragment shader turns
+// every sample into a colour through a 1-D lookup texture, so
+//  - a parameter change re-uploads one float per cell and nothing else,
+//  - switching colour maps only binds another lookup texture,
+//  - linear filtering keeps the map smooth at any zoom, without the
+//    overdraw and aliasing of fat points.
+// Cells holding NaN are discarded and stay transparent. A field with more
+// samples along an axis than GL_MAX_TEXTURE_SIZE is averaged down in blocks
+// until it fits, instead of failing to upload.
+class CHeatMapTexture
+{
+public:
+    CHeatMapTexture()
+        : m_programId(0), m_fieldTexture(0), m_columns(0), m_rows(0), m_dirty(true),
+          m_fieldId(-1), m_colorMapId(-1), m_valueScaleId(-1), m_lutScaleId(-1), m_transparencyId(-1),
+          m_min(0.0f), m_max(0.0f), m_maxTextureSize(0)
+    {
+        for (int i = 0; i < COLOR_MAP_COUNT; ++i)
+            m_lutTextures[i] = 0;
+    }
+
+    ~CHeatMapTexture()
+    {
+        Release();
+    }
+
+    bool IsAvailable() const { return m_programId != 0; }
+
+    // needs a current context; false without float textures or shaders
+    bool Init(const char* a_vertexShaderPath, const char* a_fragmentShaderPath)
+    {
+        if (!g_gl.hasFloatTextures)
+            return false;
+        m_programId = LoadShaders(a_vertexShaderPath, a_fragmentShaderPath);
+        if (!m_programId)
+            return false;
+        m_fieldId = g_gl.GetUniformLocation(m_programId, "field");
+        m_colorMapId = g_gl.GetUniformLocation(m_programId, "colorMap");
+        m_valueScaleId = g_gl.GetUniformLocation(m_programId, "valueScale");
+        m_lutScaleId = g_gl.GetUniformLocation(m_programId, "lutScale");
+        m_transparencyId = g_gl.GetUniformLocation(m_programId, "transparency");
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &m_maxTextureSize);
+
+        // every colour map is built once; choosing one is a texture bind
+        CreateColorMapTextures(m_lutTextures);
+
+        glGenTextures(1, &m_fieldTexture);
+        glBindTexture(GL_TEXTURE_2D, m_fieldTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    // same contract as CStaticGeometry::Update(): true when SetField() has
+    // to be called because the parameters the field depends on changed
+    bool Update(const float* a_params, size_t a_numParams)
+    {
+        if (m_params.size() != a_numParams || !std::equal(m_params.begin(), m_params.end(), a_params))
+        {
+            m_params.assign(a_params, a_params + a_numParams);
+            m_dirty = true;
+        }
+        return m_dirty;
+    }
+
+    // a_values holds a_columns x a_rows samples stored x-major like
+    // CAnalyticSurface; values from a_min to a_max span the colour map
+    void SetField(const float* a_values, int a_columns, int a_rows, float a_min, float a_max)
+    {
+        if (!m_programId)
+            return;
+        // too large for one texture: average blocks of samples down to the limit
+        const int l_stepX = (a_columns + m_maxTextureSize - 1) / m_maxTextureSize;
+        const int l_stepY = (a_rows + m_maxTextureSize - 1) / m_maxTextureSize;
+        if (l_stepX > 1 || l_stepY > 1)
+        {
+            p_Reduce(a_values, a_columns, a_rows, l_stepX, l_stepY);
+            a_values = &m_reduced[0];
+            a_columns = (a_columns + l_stepX - 1) / l_stepX;
+            a_rows = (a_rows + l_stepY - 1) / l_stepY;
+        }
+        // x-major storage is row-major with x down the texture: the texture
+        // is a_rows texels wide and Draw() swaps the coordinates back
+        glBindTexture(GL_TEXTURE_2D, m_fieldTexture);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        if (a_columns != m_columns || a_rows != m_rows)
+        {
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, a_rows, a_columns, 0, GL_RED, GL_FLOAT, a_values);
+            m_columns = a_columns;
+            m_rows = a_rows;
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, a_rows, a_columns, GL_RED, GL_FLOAT, a_values);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        m_min = a_min;
+        m_max = a_max;
+        m_dirty = false;
+    }
+
+    // the field on the z = 0 plane from (a_xMin, a_yMin) to (a_xMax, a_yMax)
+    void Draw(EColorMap a_colorMap, float a_xMin, float a_xMax, float a_yMin, float a_yMax,
+              float a_transparency) const
+    {
+        if (!m_programId || m_columns == 0)
+            return;
+
+        // texture s runs along y, t along x
+        const GLfloat l_corners[] = {
+            a_xMin, a_yMin, 0.0f, 0.0f,
+            a_xMax, a_yMin, 0.0f, 1.0f,
+            a_xMin, a_yMax, 1.0f, 0.0f,
+            a_xMax, a_yMax, 1.0f, 1.0f};
+
+        g_gl.ActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, m_lutTextures[a_colorMap]);
+        g_gl.ActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, m_fieldTexture);
+
+        g_gl.UseProgram(m_programId);
+        g_gl.Uniform1i(m_fieldId, 0);
+        g_gl.Uniform1i(m_colorMapId, 1);
+        // same normalisation as HeatMapColor(), the middle for an empty range
+        if (m_max > m_min)
+            g_gl.Uniform2f(m_valueScaleId, 1.0f / (m_max - m_min), -m_min / (m_max - m_min));
+        else
+            g_gl.Uniform2f(m_valueScaleId, 0.0f, 0.5f);
+        g_gl.Uniform2f(m_lutScaleId, (COLOR_MAP_LUT_SIZE - 1.0f) / COLOR_MAP_LUT_SIZE, 0.5f / COLOR_MAP_LUT_SIZE);
+        g_gl.Uniform1f(m_transparencyId, a_transparency);
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        glVertexPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &l_corners[0]);
+        glTexCoordPointer(2, GL_FLOAT, 4 * sizeof(GLfloat), &l_corners[2]);
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        g_gl.UseProgram(0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        g_gl.ActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_1D, 0);
+        g_gl.ActiveTexture(GL_TEXTURE0);
+    }
+
+    // needs a current context
+    void Release()
+    {
+        if (m_programId)
+        {
+            glDeleteTextures(1, &m_fieldTexture);
+            glDeleteTextures(COLOR_MAP_COUNT, m_lutTextures);
+            g_gl.DeleteProgram(m_programId);
+            m_programId = 0;
+        }
+        m_columns = m_rows = 0;
+        m_dirty = true;
+    }
+
+private:
+    GLuint m_programId;
+    GLuint m_fieldTexture;
+    GLuint m_lutTextures[COLOR_MAP_COUNT];
+    int m_columns;
+    int m_rows;
+    bool m_dirty;
+    std::vector<float> m_params;
+    GLint m_fieldId;
+    GLint m_colorMapId;
+    GLint m_valueScaleId;
+    GLint m_lutScaleId;
+    GLint m_transparencyId;
+    float m_min;
+    float m_max;
+    GLint m_maxTextureSize;
+    // the field averaged down when it exceeds m_maxTextureSize
+    std::vector<float> m_reduced;
+    std::vector<int> m_reducedCounts;
+
+    // m_reduced = means of the finite samples of every a_stepX x a_stepY
+    // block, NaN for blocks without any
+    void p_Reduce(const float* a_values, int a_columns, int a_rows, int a_stepX, int a_stepY)
+    {
+        const int l_columns = (a_columns + a_stepX - 1) / a_stepX;
+        const int l_rows = (a_rows + a_stepY - 1) / a_stepY;
+        m_reduced.assign((size_t)l_columns * l_rows, 0.0f);
+        m_reducedCounts.assign(m_reduced.size(), 0);
+        for (int i = 0; i < a_columns; ++i)
+        {
+            const float* l_column = a_values + (size_t)i * a_rows;
+            float* l_sums = &m_reduced[(size_t)(i / a_stepX) * l_rows];
+            int* l_counts = &m_reducedCounts[(size_t)(i / a_stepX) * l_rows];
+            for (int j = 0; j < a_rows; ++j)
+            {
+                if (l_column[j] >= -FLT_MAX && l_column[j] <= FLT_MAX)
+                {
+                    l_sums[j / a_stepY] += l_column[j];
+                    ++l_counts[j / a_stepY];
+                }
+            }
+        }
+        for (size_t i = 0; i < m_reduced.size(); ++i)
+            m_reduced[i] = m_reducedCounts[i] ? m_reduced[i] / m_reducedCounts[i] : NAN;
+    }
+};
+
+#endif
@@ -0,0 +1,16 @@
+#version 120
+
+// the colour map, low values at the left end; the same lookup table as
+// heatmap_texture.frag
+uniform sampler1D colorMap;
+// keeps the lookup on the centres of the first and last entry
+uniform vec2 lutScale;
+uniform float transparency;
+
+varying float heatPosition;
+
+void main()
+{
+    vec3 color = texture1D(colorMap, heatPosition * lutScale.x + lutScale.y).rgb;
+    gl_FragColor = vec4(color, transparency);
+}
@@ -0,0 +1,22 @@
+#version 120
+
+// grid position, uploaded once; the height comes from surface()
+attribute vec2 gridPoint;
+
+// function parameters, e.g. sigma of the Gaussian in x
+uniform vec4 surfaceParams;
+// t = value * valueScale.x + valueScale.y maps the range to [0, 1]
+uniform vec2 valueScale;
+
+// position in the colour map, looked up by heatmap.frag
+varying float heatPosition;
+
+// defined by the registered function file linked into the same stage
+float surface(vec2 p, vec4 params);
+
+void main()
+{
+    float z = surface(gridPoint, surfaceParams);
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(gridPoint, z, 1.0);
+    heatPosition = clamp(z * valueScale.x + valueScale.y, 0.0, 1.0);
+}
@@ -0,0 +1,26 @@
+#version 120
+
+// one float sample per texel
+uniform sampler2D field;
+// the colour map, low values at the left end
+uniform sampler1D colorMap;
+// t = value * valueScale.x + valueScale.y maps the range to [0, 1]
+uniform vec2 valueScale;
+// keeps the lookup on the centres of the first and last entry
+uniform vec2 lutScale;
+uniform float transparency;
+
+varying vec2 fieldCoord;
+
+void main()
+{
+    float value = texture2D(field, fieldCoord).r;
+    // NaN marks a cell without data
+    if (value != value)
+    {
+        discard;
+    }
+    float t = clamp(value * valueScale.x + valueScale.y, 0.0, 1.0);
+    vec3 color = texture1D(colorMap, t * lutScale.x + lutScale.y).rgb;
+    gl_FragColor = vec4(color, transparency);
+}
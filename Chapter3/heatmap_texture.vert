@@ -0,0 +1,10 @@
+#version 120
+
+// the quad comes through the fixed function arrays, in the plot plane
+varying vec2 fieldCoord;
+
+void main()
+{
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    fieldCoord = gl_MultiTexCoord0.xy;
+}
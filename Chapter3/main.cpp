@@ -1,6 +1,20 @@
+#include "static_geometry.h"
+#include "analytic_surface.h"
+#include "color_map.h"
+#include "frame_arena.h"
+#include "gpu_heat_map.h"
+#include "heat_map_texture.h"
+#include "input_queue.h"
+#include "redraw_tracker.h"
+#include "spatial_index.h"
+#include "terrain_lod.h"
+#include "thread_pool.h"
+#include "vmath.h"
+
 #include <GLFW/glfw3.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #define _USE_MATH_DEFINES // M_PI constant
 #include <math.h>
 
@@ -21,11 +35,51 @@ typedef struct
     GLfloat r, g, b, a;
 } Vertex;
 
-//structure for data stream
+//vertex of a heat map, colour packed as RGBA8
 typedef struct
 {
     GLfloat x, y, z;
-} Data;
+    GLubyte r, g, b, a;
+} HeatVertex;
+
+// the axes never change, keep them in a vertex buffer
+CStaticGeometry<Vertex> g_origin;
+// scratch memory for data generated during a frame, released at buffer swap
+CFrameArena g_frameArena(4 << 20);
+// the Gaussian, only regenerated when sigma changes
+CAnalyticSurface<HeatVertex> g_gaussian;
+// grid_x = grid_y of the Gaussian, set from the command line
+int g_gridSize = 400;
+// runs the tiles of large fields on every core
+CThreadPool g_threadPool;
+// the same Gaussian evaluated in the vertex shader (G key, C for the colour
+// map); the grid and the program are only built the first time G is pressed
+CGPUHeatMap g_gpuHeatMap;
+int g_gpuGaussian = -1;
+bool g_gpuHeatMapTried = false;
+bool g_shaderMode = false;
+// the Gaussian as a float texture and a colour map lookup (T and C keys)
+CHeatMapTexture g_heatMapTexture;
+bool g_textureMode = false;
+EColorMap g_colorMap = COLOR_MAP_BLUE_GREEN_RED;
+// the Gaussian as a connected surface with quadtree level of detail (L key)
+CTerrainLOD g_terrain;
+bool g_terrainMode = false;
+// grids up to this many samples rebuild the terrain every frame while sigma
+// animates; the rebuild reads every sample and evicts every patch, so larger
+// ones keep the last settled surface until sigma holds still (space)
+const size_t TERRAIN_ANIMATED_SAMPLES = 1024 * 1024;
+// redraw only when something changed (R key switches to every vsync)
+CRedrawTracker g_redraw;
+bool g_onDemand = true;
+// longest sleep between two wakeups of an idle window, in seconds
+const double ON_DEMAND_TIMEOUT = 0.5;
+// the callbacks only queue input; ProcessInput() applies it once per frame
+CInputQueue g_input;
+// value of the Gaussian under the cursor, shown in the title bar
+CRegularGridIndex g_hoverGrid;
+// projection * modelview of the last frame, for turning the cursor into a ray
+GLfloat g_pickMatrix[16];
 
 // Camera params depend on window size
 // This is the callback that gives us updates to window size
@@ -46,6 +100,7 @@ void FrameBufferSizeCallback(GLFWwindow* a_window, int a_width, int a_height)
 
     // Setup the viewport of the virtual camera (using the window size)
     glViewport(0, 0, a_width, a_height);
+    g_redraw.MarkDirty();
 
     // Specify that matrix operations should be applied to the projection matrix stack
     glMatrixMode(GL_PROJECTION);
@@ -62,78 +117,258 @@ void FrameBufferSizeCallback(GLFWwindow* a_window, int a_width, int a_height)
 	glFrustum(-l_width_f, l_width_f, -l_height_f, l_height_f, l_front, l_back);
 }
 
-void Draw2DHeatMap(const Data *data, int num_points)
+// heat map colouring of a cached surface into its vertices; the
+// range usually comes for free from the generation pass, the colours are
+// packed to RGBA8 four cells at a time on the thread pool
+void HeatMapVertices(const CAnalyticSurface<HeatVertex>& surface, std::vector<HeatVertex>& vertices)
 {
-    // locate the maximum and minimum values in the dataset
-    float max_value = -999.9f;
-    float min_value = 999.9f;
-    for (int i=0; i<num_points; i++)
+    const float *z = surface.Z();
+    float max_value, min_value;
+    surface.Range(&min_value, &max_value, &g_threadPool);
+    const GLubyte transparency = 64;
+
+    vertices.resize(surface.Size());
+    const int rows = surface.Rows();
+    surface.ForEachTile([&](int column_begin, int column_end, int row_begin, int row_end)
     {
-        const Data d = data[i];
-        if( d.z > max_value)
-        {
-            max_value = d.z;
-        }
-        if (d.z < min_value)
+        for (int i = column_begin; i < column_end; i++)
         {
-            min_value = d.z;
+            const size_t first = (size_t)i*rows + row_begin;
+            for (int j = row_begin; j < row_end; j++)
+            {
+                HeatVertex &v = vertices[first + j - row_begin];
+                v.x = surface.X()[i];
+                v.y = surface.Y()[j];
+                v.z = z[first + j - row_begin];
+            }
+            HeatMapRGBA8(z + first, row_end - row_begin, min_value, max_value, transparency,
+                         &vertices[first].r, sizeof(HeatVertex));
         }
+    }, &g_threadPool);
+}
+
+//fills g_gaussian with the 2-D Gaussian for sigma; the samples are shared by
+//the point and the texture heat maps and only regenerated when sigma changes
+void GenerateGaussian(float sigma)
+{
+    //construct a square grid, 400x400 unless given on the command line
+    const int grid_x = g_gridSize;
+    const int grid_y = g_gridSize;
+    static float generated_sigma = -1.0f;
+    if (g_gaussian.Size() == 0)
+    {
+        g_gaussian.SetGrid(grid_x, grid_y, -1.0f, 1.0f, -1.0f, 1.0f);
+        g_hoverGrid.SetGrid(grid_x, grid_y, g_gaussian.X()[0], g_gaussian.X()[grid_x-1],
+                            g_gaussian.Y()[0], g_gaussian.Y()[grid_y-1]);
+        generated_sigma = -1.0f;
+    }
+    if (sigma == generated_sigma)
+        return;
+    generated_sigma = sigma;
+
+    //the 2-D Gaussian is the product of two 1-D Gaussians, so only
+    //grid_x + grid_y exponentials are needed
+    float *x_factors = g_frameArena.Allocate<float>(grid_x);
+    float *y_factors = g_frameArena.Allocate<float>(grid_y);
+    for (int i = 0; i < grid_x; i++)
+    {
+        x_factors[i] = -0.5f*(g_gaussian.X()[i]*g_gaussian.X()[i])/(sigma*sigma);
+    }
+    for (int j = 0; j < grid_y; j++)
+    {
+        y_factors[j] = -0.5f*(g_gaussian.Y()[j]*g_gaussian.Y()[j])/(sigma*sigma);
+    }
+    VecExp(x_factors, x_factors, grid_x);
+    VecExp(y_factors, y_factors, grid_y);
+    //compute the height z based on a 2-D Gaussian function.
+    g_gaussian.SetSeparable(x_factors, y_factors, 1.0f/(sigma*sigma*2.0f*M_PI), &g_threadPool);
+}
+
+void GaussianDemo(float sigma)
+{
+    GenerateGaussian(sigma);
+
+    //nothing to do while sigma (e.g. frozen) stays the same
+    if (g_gaussian.Update(&sigma, 1))
+    {
+        //visualize the result using a 2D heat map
+        static std::vector<HeatVertex> vertices;
+        HeatMapVertices(g_gaussian, vertices);
+        g_gaussian.Upload(GL_POINTS, 3.0f, vertices);
+    }
+    g_gaussian.Draw();
+}
+
+// GaussianDemo as a flat R32F texture coloured through a lookup texture:
+// a new sigma uploads one float per cell, a new colour map nothing at all
+void TextureGaussianDemo(float sigma)
+{
+    GenerateGaussian(sigma);
+
+    if (g_heatMapTexture.Update(&sigma, 1))
+    {
+        //read only, keeps the range cached by the generation pass
+        const CAnalyticSurface<HeatVertex>& surface = g_gaussian;
+        float max_value, min_value;
+        surface.Range(&min_value, &max_value, &g_threadPool);
+        g_heatMapTexture.SetField(surface.Z(), surface.Columns(), surface.Rows(), min_value, max_value);
     }
-    const float halfmax = (max_value + min_value) / 2;
+    g_heatMapTexture.Draw(g_colorMap, -1.0f, 1.0f, -1.0f, 1.0f, 0.75f);
+}
 
-    // display the result
-    glPointSize(3.0f);
-    glBegin(GL_POINTS);
-    float transparency = 0.25f;
+// GaussianDemo as a continuous surface: the level of detail follows the
+// camera, so the cost of a frame does not grow with the grid size. Large
+// grids follow an animated sigma once it stops changing
+void TerrainGaussianDemo(float sigma)
+{
+    static float terrain_sigma = -1.0f;
+    static float previous_sigma = -1.0f;
+    const bool settled = sigma == previous_sigma;
+    previous_sigma = sigma;
+    const bool rebuild = sigma != terrain_sigma &&
+        (settled || terrain_sigma < 0.0f || (size_t)g_gridSize*g_gridSize <= TERRAIN_ANIMATED_SAMPLES);
+    if (rebuild)
+        terrain_sigma = sigma;
+
+    //the terrain reads the samples in place: keep them at its sigma, even
+    //after another mode generated them for the animated one
+    GenerateGaussian(terrain_sigma);
+    if (rebuild)
+    {
+        const CAnalyticSurface<HeatVertex>& surface = g_gaussian;
+        g_terrain.SetField(surface.Z(), surface.Columns(), surface.Rows(),
+                           surface.X()[0], surface.X()[surface.Columns()-1],
+                           surface.Y()[0], surface.Y()[surface.Rows()-1], &g_threadPool);
+    }
+    g_terrain.Draw();
+}
+
+// GaussianDemo with height and colour computed on the GPU: only sigma and the
+// value range are sent per frame, the colours come from the lookup textures
+// of the texture mode
+void GPUGaussianDemo(float sigma)
+{
+    const float params[4] = {sigma, 0.0f, 0.0f, 0.0f};
+    //the peak of the Gaussian is at the origin, the tails go to zero
+    const float max_value = 1.0f/(sigma*sigma*2.0f*M_PI);
+    g_gpuHeatMap.Draw(g_gpuGaussian, params, g_colorMap, 0.0f, max_value, 0.25f, 3.0f);
+}
 
-    for (int i = 0; i<num_points; i++)
+//keeps the transform of the frame being drawn for picking
+void StorePickMatrix()
+{
+    GLfloat projection[16], modelview[16];
+    glGetFloatv(GL_PROJECTION_MATRIX, projection);
+    glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+    //both column-major
+    for (int column = 0; column < 4; column++)
     {
-        const Data d = data[i];
-        float value = d.z;
-        float b = 1.0f - value/halfmax;
-        float r = value/halfmax - 1.0f;
-        if(b < 0)
+        for (int row = 0; row < 4; row++)
         {
-            b=0;
+            GLfloat sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+                sum += projection[k*4 + row] * modelview[column*4 + k];
+            g_pickMatrix[column*4 + row] = sum;
         }
-        if(r < 0)
+    }
+}
+
+//where the ray through (ndc_x, ndc_y) meets the plane z = plane_z; false
+//when it runs parallel to the plane or meets it behind the camera
+bool CursorOnPlane(float ndc_x, float ndc_y, float plane_z, float *x, float *y)
+{
+    const GLfloat *m = g_pickMatrix;
+    //clip = x * column 0 + y * column 1 + d, both clip.x and clip.y have to
+    //match the cursor after the division by clip.w
+    float d[4];
+    for (int k = 0; k < 4; k++)
+        d[k] = plane_z*m[8 + k] + m[12 + k];
+    const float a1 = m[0] - ndc_x*m[3], b1 = m[4] - ndc_x*m[7], e1 = d[0] - ndc_x*d[3];
+    const float a2 = m[1] - ndc_y*m[3], b2 = m[5] - ndc_y*m[7], e2 = d[1] - ndc_y*d[3];
+    const float det = a1*b2 - a2*b1;
+    if (fabsf(det) < 1e-12f)
+        return false;
+    *x = (b1*e2 - b2*e1)/det;
+    *y = (a2*e1 - a1*e2)/det;
+    return *x*m[3] + *y*m[7] + d[3] > 0.0f;
+}
+
+//sample of the Gaussian under the cursor: on the z = 0 plane for the flat
+//texture, otherwise the first sample the cursor ray passes below while it
+//descends from the top to the bottom of the field's range
+bool PickGaussian(GLFWwindow* window, float *x, float *y, float *value)
+{
+    if (g_gaussian.Size() == 0)
+        return false;
+    int window_width, window_height, width, height;
+    glfwGetWindowSize(window, &window_width, &window_height);
+    glfwGetFramebufferSize(window, &width, &height);
+    if (window_width <= 0 || window_height <= 0)
+        return false;
+    const float ndc_x = 2.0f*g_cursorX/window_width - 1.0f;
+    const float ndc_y = 1.0f - 2.0f*g_cursorY/window_height;
+
+    const CAnalyticSurface<HeatVertex>& surface = g_gaussian;
+    float min_value = 0.0f, max_value = 0.0f;
+    if (!g_textureMode)
+        surface.Range(&min_value, &max_value, &g_threadPool);
+    float top_x, top_y, bottom_x, bottom_y;
+    if (!CursorOnPlane(ndc_x, ndc_y, max_value, &top_x, &top_y) ||
+        !CursorOnPlane(ndc_x, ndc_y, min_value, &bottom_x, &bottom_y))
+        return false;
+
+    //half a cell per step, the regular grid turns every step into a sample
+    const float cell_size = 2.0f/g_gridSize;
+    const float length = sqrtf((bottom_x - top_x)*(bottom_x - top_x) + (bottom_y - top_y)*(bottom_y - top_y));
+    const int steps = (int)fminf(2.0f*length/cell_size, 4.0f*g_gridSize) + 1;
+    for (int i = 0; i <= steps; i++)
+    {
+        const float t = (float)i/steps;
+        int column, row;
+        if (!g_hoverGrid.Nearest(top_x + t*(bottom_x - top_x), top_y + t*(bottom_y - top_y), &column, &row))
+            continue;
+        const float z = surface.Z()[g_hoverGrid.Index(column, row)];
+        if (max_value + t*(min_value - max_value) <= z || i == steps)
         {
-            r=0;
+            *x = surface.X()[column];
+            *y = surface.Y()[row];
+            *value = z;
+            return true;
         }
-        float g = 1.0f - b - r;
+    }
+    return false;
+}
 
-        glColor4f(r, g, b, transparency);
-        glVertex3f(d.x, d.y, d.z);
+void UpdateHover(GLFWwindow* window)
+{
+    static char shown[128] = "Chapter 3";
+    char title[128] = "Chapter 3";
+    float x, y, value;
+    //the shader mode never computes the samples on the CPU
+    if (!g_locked && !g_shaderMode && PickGaussian(window, &x, &y, &value))
+        snprintf(title, sizeof(title), "Chapter 3 - f(%.3f, %.3f) = %.4g", x, y, value);
+    if (strcmp(title, shown) != 0)
+    {
+        glfwSetWindowTitle(window, title);
+        strcpy(shown, title);
     }
-    glEnd();
 }
 
-void GaussianDemo(float sigma)
+//uploads the grid and links the shader of the G key on first use
+bool InitGPUHeatMap()
 {
-    //construct a 400x400 grid
-    const int grid_x = 400;
-    const int grid_y = 400;
-    const int num_points = grid_x*grid_y;
-    Data *data=(Data*)malloc(sizeof(Data)*num_points);
-    int data_counter=0;
-    for(int x = -grid_x/2; x<grid_x/2; x+=1){
-        for(int y = -grid_y/2; y<grid_y/2; y+=1){
-            float x_data = 2.0f*x/grid_x;
-            float y_data = 2.0f*y/grid_y;
-            //compute the height z based on a 2-D Gaussian function.
-            float z_data = exp(-0.5f*(x_data*x_data)/(sigma*sigma) - 0.5f*(y_data*y_data)/(sigma*sigma))/(sigma*sigma*2.0f*M_PI);
-            data[data_counter].x = x_data;
-            data[data_counter].y = y_data;
-            data[data_counter].z = z_data;
-            data_counter++;
-        }
+    if (!g_gpuHeatMapTried)
+    {
+        g_gpuHeatMapTried = true;
+        if (g_gpuHeatMap.Init(g_gridSize, g_gridSize, -1.0f, 1.0f, -1.0f, 1.0f))
+            g_gpuGaussian = g_gpuHeatMap.RegisterFunction("gaussian.glsl");
+        if (g_gpuGaussian < 0)
+            printf("Shader heat map not available, G key disabled\n");
     }
-    //visualize the result using a 2D heat map
-    Draw2DHeatMap(data, num_points);
-    free(data);
+    return g_gpuGaussian >= 0;
 }
 
-void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+void HandleKey(GLFWwindow* window, int key, int action)
 {
     if (action != GLFW_PRESS)
         return;
@@ -146,6 +381,23 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         case GLFW_KEY_SPACE:
             g_freeze=!g_freeze;
             break;
+        case GLFW_KEY_G:
+            g_shaderMode = !g_shaderMode && InitGPUHeatMap();
+            break;
+        case GLFW_KEY_T:
+            g_textureMode = !g_textureMode && g_heatMapTexture.IsAvailable();
+            break;
+        case GLFW_KEY_L:
+            g_terrainMode = !g_terrainMode && g_terrain.IsAvailable();
+            break;
+        case GLFW_KEY_R:
+            g_onDemand = !g_onDemand;
+            printf("Redraw %s\n", g_onDemand ? "on demand" : "every frame");
+            break;
+        case GLFW_KEY_C:
+            g_colorMap = (EColorMap)((g_colorMap + 1) % COLOR_MAP_COUNT);
+            printf("Colour map: %s\n", ColorMapName(g_colorMap));
+            break;
         case GLFW_KEY_LEFT:
             g_alpha += 5.0f;
             break;
@@ -171,7 +423,7 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
-void MouseCallback(GLFWwindow* window, int button, int action, int mods)
+void HandleMouseButton(GLFWwindow* window, int button, int action)
 {
     if (button != GLFW_MOUSE_BUTTON_LEFT)
         return;
@@ -188,48 +440,103 @@ void MouseCallback(GLFWwindow* window, int button, int action, int mods)
     }
 }
 
-void CursorPositionCallback(GLFWwindow* window, double x, double y)
+void HandleCursor(GLFWwindow* window, double x, double y)
 {
     //if the mouse button is pressed
     if (g_locked)
     {
         g_alpha += (GLfloat) (x - g_cursorX) / 10.0f;
         g_beta += (GLfloat) (y - g_cursorY) / 10.0f;
+        g_redraw.MarkDirty();
     }
     //update the cursor position
     g_cursorX = (int) x;
     g_cursorY = (int) y;
 }
 
+// applies everything queued since the last frame: keys and buttons in order,
+// each button after the cursor position pending when it arrived, then the
+// latest cursor position and the scrolling summed up, so any number of mouse
+// events costs one camera update
+void ProcessInput(GLFWwindow* window)
+{
+    SInputEvent event;
+    while (g_input.Pop(&event))
+    {
+        if (event.type == INPUT_KEY)
+        {
+            HandleKey(window, event.code, event.action);
+        }
+        else
+        {
+            if (event.hasCursor)
+                HandleCursor(window, event.x, event.y);
+            HandleMouseButton(window, event.code, event.action);
+        }
+        g_redraw.MarkDirty();
+    }
+
+    double x, y;
+    if (g_input.TakeCursor(&x, &y))
+    {
+        HandleCursor(window, x, y);
+        UpdateHover(window);
+    }
+
+    if (g_input.TakeScroll(&x, &y))
+    {
+        g_zoom += (float) y / 4.0f;
+        if (g_zoom < 0.0f)
+            g_zoom = 0.0f;
+        g_redraw.MarkDirty();
+    }
+}
+
+void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    g_input.PushKey(key, scancode, action, mods, glfwGetTime());
+}
+
+void MouseCallback(GLFWwindow* window, int button, int action, int mods)
+{
+    g_input.PushMouseButton(button, action, mods, glfwGetTime());
+}
+
+void CursorPositionCallback(GLFWwindow* window, double x, double y)
+{
+    g_input.PushCursor(x, y, glfwGetTime());
+}
+
 void ScrollCallback(GLFWwindow* window, double x, double y)
 {
-    g_zoom += (float) y / 4.0f;
-    if (g_zoom < 0.0f)
-        g_zoom = 0.0f;
+    g_input.PushScroll(x, y, glfwGetTime());
+}
+
+// the window was uncovered or needs repainting for another reason
+void WindowRefreshCallback(GLFWwindow* window)
+{
+    g_redraw.MarkDirty();
 }
 
 void DrawOrigin(){
-    float transparency = 0.5f;
-    glLineWidth(4.0f);
-    glBegin(GL_LINES);
-    //draw a red line for the x-axis
-    glColor4f(1.0f, 0.0f, 0.0f, transparency);
-    glVertex3f(0.0f, 0.0f, 0.0f);
-    glColor4f(1.0f, 0.0f, 0.0f, transparency);
-    glVertex3f(0.3f, 0.0f, 0.0f);
-
-    //draw a green line for the y-axis
-    glColor4f(0.0f, 1.0f, 0.0f, transparency);
-    glVertex3f(0.0f, 0.0f, 0.0f);
-    glColor4f(0.0f, 1.0f, 0.0f, transparency);
-    glVertex3f(0.0f, 0.0f, 0.3f);
-
-    //draw a blue line for the z-axis
-    glColor4f(0.0f, 0.0f, 1.0f, transparency);
-    glVertex3f(0.0f, 0.0f, 0.0f);
-    glColor4f(0.0f, 0.0f, 1.0f, transparency);
-    glVertex3f(0.0f, 0.3f, 0.0f);
-    glEnd();
+    if (g_origin.IsDirty())
+    {
+        float transparency = 0.5f;
+        const Vertex l_axes[] = {
+            //draw a red line for the x-axis
+            {0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, transparency},
+            {0.3f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, transparency},
+            //draw a green line for the y-axis
+            {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, transparency},
+            {0.0f, 0.0f, 0.3f, 0.0f, 1.0f, 0.0f, transparency},
+            //draw a blue line for the z-axis
+            {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, transparency},
+            {0.0f, 0.3f, 0.0f, 0.0f, 0.0f, 1.0f, transparency}
+        };
+        std::vector<Vertex> l_lines(l_axes, l_axes + sizeof(l_axes) / sizeof(l_axes[0]));
+        g_origin.Upload(GL_LINES, 4.0f, l_lines);
+    }
+    g_origin.Draw();
 }
 
 int main(int argc, char const *argv[])
@@ -237,6 +544,25 @@ int main(int argc, char const *argv[])
     GLFWwindow* l_window;
     int l_width, l_height;
 
+    // usage: main [grid size] [--stats file], e.g. main 4096 for a
+    // 4096x4096 field; --stats exports the frame counters once a second
+    const char* stats_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+        {
+            stats_path = argv[++i];
+            continue;
+        }
+        g_gridSize = atoi(argv[i]);
+        if (g_gridSize < 2)
+        {
+            fprintf(stderr, "usage: %s [grid size >= 2] [--stats file]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    printf("Gaussian: %dx%d grid, %d threads\n", g_gridSize, g_gridSize, g_threadPool.NumThreads());
+
     if (!glfwInit())
     {
         exit(EXIT_FAILURE);
@@ -248,6 +574,10 @@ int main(int argc, char const *argv[])
         glfwTerminate();
         exit(EXIT_FAILURE);
     }
+    //skipped frames are counted in refresh intervals of the display
+    const GLFWvidmode* video_mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+    if (video_mode)
+        g_redraw.SetRefreshRate(video_mode->refreshRate);
 
     //initialize the callbacks for event handling
     //keyboard input callback
@@ -260,11 +590,18 @@ int main(int argc, char const *argv[])
     glfwSetCursorPosCallback(l_window, CursorPositionCallback);
     //mouse scroll callback
     glfwSetScrollCallback(l_window, ScrollCallback);
+    //window needs repainting, e.g. after being uncovered
+    glfwSetWindowRefreshCallback(l_window, WindowRefreshCallback);
 
     // Make sure window is on the current calling thread
     glfwMakeContextCurrent(l_window);
     glfwSwapInterval(1);
 
+    // resolve the buffer object entry points for the cached geometry
+    LoadGLFunctions();
+    if (!g_heatMapTexture.Init("heatmap_texture.vert", "heatmap_texture.frag"))
+        printf("Float textures not available, T key disabled\n");
+
     //get the frame buffer (window) size
     glfwGetFramebufferSize(l_window, &l_width, &l_height);
     // initial call to the framebuffer callback, and initialize the OpenGL
@@ -288,8 +625,28 @@ int main(int argc, char const *argv[])
     float sign = 1.0f;
     float step_size = 0.01f;
 
+    double last_export = glfwGetTime();
     while (!glfwWindowShouldClose(l_window))
     {
+        if (stats_path && glfwGetTime() - last_export >= 1.0)
+        {
+            g_redraw.ExportStats(stats_path);
+            last_export = glfwGetTime();
+        }
+
+        ProcessInput(l_window);
+
+        //nothing changed: sleep until an event arrives or the timeout
+        //passes, then check again
+        if (g_onDemand && !g_redraw.NeedsRedraw())
+        {
+            const double wait_start = glfwGetTime();
+            glfwWaitEventsTimeout(ON_DEMAND_TIMEOUT);
+            if (!g_redraw.NeedsRedraw() && !g_input.HasPending())
+                g_redraw.IdleWakeup(glfwGetTime() - wait_start);
+            continue;
+        }
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         //draw the scene
@@ -302,6 +659,7 @@ int main(int argc, char const *argv[])
         glRotatef(g_beta, 1.0, 0.0, 0.0);
         // rotate alpha degrees around the z-axis
         glRotatef(g_alpha, 0.0, 0.0, 1.0);
+        StorePickMatrix();
 
         //draw the origin with the x,y,z axes for visualization
         DrawOrigin();
@@ -316,14 +674,47 @@ int main(int argc, char const *argv[])
                 sign = 1.0f;
             }
         }
-        GaussianDemo(sigma);
+        if (g_terrainMode)
+            TerrainGaussianDemo(sigma);
+        else if (g_textureMode)
+            TextureGaussianDemo(sigma);
+        else if (g_shaderMode)
+            GPUGaussianDemo(sigma);
+        else
+            GaussianDemo(sigma);
+
+        //the value under the cursor follows the animation too
+        UpdateHover(l_window);
+
+        g_redraw.FrameRendered();
+        //an animation or a surface still refining needs the next frame too
+        if (!g_freeze || (g_terrainMode && g_terrain.IsRefining()))
+            g_redraw.MarkDirty();
 
         // Swap the front and back buffers (GLFW uses double buffering) to update the screen and process all pending events:
         glfwSwapBuffers(l_window);
+        g_input.FramePresented(glfwGetTime());
+        g_frameArena.Reset();
         glfwPollEvents();
     }
 
+    printf("Frame arena: peak %zu of %zu bytes, %zu overflows\n",
+           g_frameArena.Peak(), g_frameArena.Capacity(), g_frameArena.Overflows());
+    printf("Frames: %llu rendered, %llu skipped in %.1f s idle, %llu idle wakeups\n",
+           (unsigned long long)g_redraw.RenderedFrames(), (unsigned long long)g_redraw.SkippedFrames(),
+           g_redraw.IdleSeconds(), (unsigned long long)g_redraw.IdleWakeups());
+    printf("Input to present: %.1f ms mean, %.1f ms max over %llu frames, %llu events dropped\n",
+           g_input.MeanLatency() * 1000.0, g_input.MaxLatency() * 1000.0,
+           (unsigned long long)g_input.LatencySamples(), (unsigned long long)g_input.Dropped());
+    if (stats_path)
+        g_redraw.ExportStats(stats_path);
+
     // Release the memory and terminate the GLFW library.
+    g_origin.Release();
+    g_gaussian.Release();
+    g_gpuHeatMap.Release();
+    g_heatMapTexture.Release();
+    g_terrain.Release();
     glfwDestroyWindow(l_window);
     glfwTerminate();
 
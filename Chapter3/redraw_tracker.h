@@ -0,0 +1,84 @@
+#ifndef REDRAW_TRACKER_H
+#define REDRAW_TRACKER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Dirty tracking for a redraw-on-demand render loop. Anything that changes
+// what is on screen (input callbacks, animations, renderers still streaming
+// in detail) calls MarkDirty(); the loop only renders a frame when
+// NeedsRedraw() and otherwise sleeps in glfwWaitEventsTimeout(), so an idle
+// window costs next to no CPU.
+//
+// Counted for monitoring: rendered frames, idle wakeups (an event that
+// changed nothing, or the timeout, without rendering) and the time spent
+// idle. Skipped frames are the refresh intervals of the display that passed
+// while idle, i.e. the frames a render-every-vsync loop would have drawn.
+class CRedrawTracker
+{
+public:
+    CRedrawTracker()
+        : m_dirty(true), m_rendered(0), m_idleWakeups(0), m_idleSeconds(0.0), m_refreshRate(60.0)
+    {
+    }
+
+    // refresh rate of the display in Hz, 60 when unknown
+    void SetRefreshRate(double a_hertz)
+    {
+        if (a_hertz > 0.0)
+            m_refreshRate = a_hertz;
+    }
+
+    void MarkDirty() { m_dirty = true; }
+    bool NeedsRedraw() const { return m_dirty; }
+
+    // call after a frame was rendered; clears the dirty flag
+    void FrameRendered()
+    {
+        m_dirty = false;
+        ++m_rendered;
+    }
+
+    // call after a wakeup without rendering, a_idleSeconds spent waiting
+    void IdleWakeup(double a_idleSeconds)
+    {
+        ++m_idleWakeups;
+        m_idleSeconds += a_idleSeconds;
+    }
+
+    uint64_t RenderedFrames() const { return m_rendered; }
+    uint64_t IdleWakeups() const { return m_idleWakeups; }
+    uint64_t SkippedFrames() const { return (uint64_t)(m_idleSeconds * m_refreshRate); }
+    double IdleSeconds() const { return m_idleSeconds; }
+
+    // writes the counters in the Prometheus text format, for a node
+    // exporter textfile collector or any scraper that reads it; the file is
+    // replaced atomically so a reader never sees half of it
+    bool ExportStats(const char* a_path, const char* a_prefix = "dataviz") const
+    {
+        char l_temporary[1024];
+        snprintf(l_temporary, sizeof(l_temporary), "%s.tmp", a_path);
+        FILE* l_file = fopen(l_temporary, "w");
+        if (!l_file)
+            return false;
+        fprintf(l_file, "# TYPE %s_frames_rendered_total counter\n", a_prefix);
+        fprintf(l_file, "%s_frames_rendered_total %llu\n", a_prefix, (unsigned long long)m_rendered);
+        fprintf(l_file, "# TYPE %s_frames_skipped_total counter\n", a_prefix);
+        fprintf(l_file, "%s_frames_skipped_total %llu\n", a_prefix, (unsigned long long)SkippedFrames());
+        fprintf(l_file, "# TYPE %s_idle_wakeups_total counter\n", a_prefix);
+        fprintf(l_file, "%s_idle_wakeups_total %llu\n", a_prefix, (unsigned long long)m_idleWakeups);
+        fprintf(l_file, "# TYPE %s_idle_seconds_total counter\n", a_prefix);
+        fprintf(l_file, "%s_idle_seconds_total %.3f\n", a_prefix, m_idleSeconds);
+        const bool l_written = fclose(l_file) == 0;
+        return l_written && rename(l_temporary, a_path) == 0;
+    }
+
+private:
+    bool m_dirty;
+    uint64_t m_rendered;
+    uint64_t m_idleWakeups;
+    double m_idleSeconds;
+    double m_refreshRate;
+};
+
+#endif
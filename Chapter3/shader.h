@@ -0,0 +1,131 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "gl_functions.h"
+
+// Same loader as the one in the later chapters, going through the entry
+// points resolved by LoadGLFunctions(). The vertex stage may be linked from
+// several files, e.g. a shared main() and the function it evaluates.
+
+std::string ReadSourceFile(const char* a_path)
+{
+    std::string l_code;
+    std::ifstream l_fileStream(a_path, std::ios::in);
+    if (l_fileStream.is_open())
+    {
+        std::string l_line = "";
+        while(getline(l_fileStream, l_line))
+            l_code += "\n" + l_line;
+        l_fileStream.close();
+        return l_code;
+    }
+    else
+    {
+        printf("Failed to open \"%s\".\n", a_path);
+        return "";
+    }
+}
+
+bool CompileShader(const std::string& a_programCode, const GLuint a_shaderId)
+{
+    GLint l_result = GL_FALSE;
+    int l_infologLength(0);
+    char const * l_programCodePtr = a_programCode.c_str();
+    g_gl.ShaderSource(a_shaderId, 1, &l_programCodePtr, NULL);
+    g_gl.CompileShader(a_shaderId);
+
+    // check the shader for successful compile
+    g_gl.GetShaderiv(a_shaderId, GL_COMPILE_STATUS, &l_result);
+    g_gl.GetShaderiv(a_shaderId, GL_INFO_LOG_LENGTH, &l_infologLength);
+
+    if (l_result != GL_TRUE && l_infologLength > 0)
+    {
+        std::vector<char> l_errMsg(l_infologLength+1);
+        g_gl.GetShaderInfoLog(a_shaderId, l_infologLength, NULL, &l_errMsg[0]);
+        printf("Error compiling shader [%s] error: `%s`\n", a_programCode.c_str(), &l_errMsg[0]);
+        return false;
+    }
+    return l_result == GL_TRUE;
+}
+
+GLuint LoadShaders(const char* const* a_vertexShaderPaths, int a_numVertexShaders,
+                   const char* a_fragmentShaderPath)
+{
+    if (!g_gl.hasShaders)
+    {
+        return 0;
+    }
+
+    std::vector<std::string> l_vertexShaderCode(a_numVertexShaders);
+    for (int i = 0; i < a_numVertexShaders; ++i)
+    {
+        l_vertexShaderCode[i] = ReadSourceFile(a_vertexShaderPaths[i]);
+        if (l_vertexShaderCode[i].empty())
+        {
+            return 0;
+        }
+    }
+
+    std::string l_fragmentShaderCode = ReadSourceFile(a_fragmentShaderPath);
+    if (l_fragmentShaderCode.empty())
+    {
+        return 0;
+    }
+
+    std::vector<GLuint> l_vertexShaderIds(a_numVertexShaders);
+    for (int i = 0; i < a_numVertexShaders; ++i)
+    {
+        l_vertexShaderIds[i] = g_gl.CreateShader(GL_VERTEX_SHADER);
+        printf("Compiling vertex shader %s\n", a_vertexShaderPaths[i]);
+        CompileShader(l_vertexShaderCode[i], l_vertexShaderIds[i]);
+    }
+
+    GLuint l_fragmentShaderId = g_gl.CreateShader(GL_FRAGMENT_SHADER);
+    printf("Compiling fragment shader %s\n", a_fragmentShaderPath);
+    CompileShader(l_fragmentShaderCode, l_fragmentShaderId);
+
+    GLint l_result = GL_FALSE;
+    int l_infologLength(0);
+    printf("Linking program...\n");
+
+    GLuint l_programId = g_gl.CreateProgram();
+    for (int i = 0; i < a_numVertexShaders; ++i)
+        g_gl.AttachShader(l_programId, l_vertexShaderIds[i]);
+    g_gl.AttachShader(l_programId, l_fragmentShaderId);
+    g_gl.LinkProgram(l_programId);
+
+    // check for errors
+    g_gl.GetProgramiv(l_programId, GL_LINK_STATUS, &l_result);
+    g_gl.GetProgramiv(l_programId, GL_INFO_LOG_LENGTH, &l_infologLength);
+    if (l_result != GL_TRUE)
+    {
+        std::vector<char> l_errMsg(l_infologLength+1);
+        if (l_infologLength > 0)
+            g_gl.GetProgramInfoLog(l_programId, l_infologLength, NULL, &l_errMsg[0]);
+        printf("Error linking shaders error: `%s`\n", &l_errMsg[0]);
+        g_gl.DeleteProgram(l_programId);
+        l_programId = 0;
+    }
+    else
+    {
+        printf("Linked successfully\n");
+    }
+
+    // flag for delete, and will free all memories
+    // when the attached program is deleted
+    for (int i = 0; i < a_numVertexShaders; ++i)
+        g_gl.DeleteShader(l_vertexShaderIds[i]);
+    g_gl.DeleteShader(l_fragmentShaderId);
+    return l_programId;
+}
+
+GLuint LoadShaders(const char* a_vertexShaderPath, const char* a_fragmentShaderPath)
+{
+    return LoadShaders(&a_vertexShaderPath, 1, a_fragmentShaderPath);
+}
+
+#endif
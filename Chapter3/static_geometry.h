@@ -0,0 +1,125 @@
+#ifndef STATIC_GEOMETRY_H
+#define STATIC_GEOMETRY_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "gl_functions.h"
+
+// GPU-resident geometry for chart furniture (grids, axes) that rarely
+// changes. The owner describes what the geometry depends on with a few
+// parameters; Update() reports when they changed (or MarkDirty() was called)
+// so the vertices only get regenerated and re-uploaded then, and every other
+// frame costs a single draw call.
+//
+// TVertex must start with x, y, z followed by r, g, b, a, either as floats
+// or as bytes (packed RGBA8, a quarter of the size).
+template <typename TVertex>
+class CStaticGeometry
+{
+public:
+    CStaticGeometry()
+        : m_buffer(0), m_count(0), m_mode(GL_LINES), m_size(1.0f), m_dirty(true)
+    {
+    }
+
+    ~CStaticGeometry()
+    {
+        Release();
+    }
+
+    // needs a current context
+    void Release()
+    {
+        if (m_buffer)
+        {
+            g_gl.DeleteBuffers(1, &m_buffer);
+            m_buffer = 0;
+        }
+        m_dirty = true;
+    }
+
+    void MarkDirty() { m_dirty = true; }
+    bool IsDirty() const { return m_dirty; }
+
+    // compares the parameters the geometry was built from with the current
+    // ones; returns true when the caller has to call Upload() again
+    bool Update(const float* a_params, size_t a_numParams)
+    {
+        if (m_params.size() != a_numParams)
+        {
+            m_params.assign(a_params, a_params + a_numParams);
+            m_dirty = true;
+        }
+        for (size_t i = 0; i < a_numParams; ++i)
+        {
+            if (m_params[i] != a_params[i])
+            {
+                m_params[i] = a_params[i];
+                m_dirty = true;
+            }
+        }
+        return m_dirty;
+    }
+
+    void Upload(GLenum a_mode, GLfloat a_size, const std::vector<TVertex>& a_vertices)
+    {
+        m_mode = a_mode;
+        m_size = a_size;
+        m_count = a_vertices.size();
+        if (g_gl.hasBuffers)
+        {
+            if (!m_buffer)
+                g_gl.GenBuffers(1, &m_buffer);
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+            g_gl.BufferData(GL_ARRAY_BUFFER, m_count * sizeof(TVertex),
+                            m_count ? &a_vertices[0] : NULL, GL_STATIC_DRAW);
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+        else
+        {
+            // no buffer objects: keep a client side copy to draw from
+            m_vertices = a_vertices;
+        }
+        m_dirty = false;
+    }
+
+    void Draw() const
+    {
+        if (m_count == 0)
+            return;
+
+        const char* l_pointer = NULL;
+        if (m_buffer)
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, m_buffer);
+        else
+            l_pointer = (const char*)&m_vertices[0];
+
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, sizeof(TVertex), l_pointer + offsetof(TVertex, x));
+        glColorPointer(4, sizeof(((TVertex*)0)->r) == 1 ? GL_UNSIGNED_BYTE : GL_FLOAT, sizeof(TVertex),
+                       l_pointer + offsetof(TVertex, r));
+        if (m_mode == GL_POINTS)
+            glPointSize(m_size);
+        else
+            glLineWidth(m_size);
+        glDrawArrays(m_mode, 0, (GLsizei)m_count);
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+
+        if (m_buffer)
+            g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+private:
+    GLuint m_buffer;
+    size_t m_count;
+    GLenum m_mode;
+    GLfloat m_size;
+    bool m_dirty;
+    std::vector<float> m_params;
+    std::vector<TVertex> m_vertices;
+};
+
+#endif
@@ -0,0 +1,622 @@
+#ifndef TERRAIN_LOD_H
+#define TERRAIN_LOD_H
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "color_map.h"
+#include "gl_functions.h"
+#include "thread_pool.h"
+
+// Continuous level of detail renderer for large height fields (16k x 16k
+// and up), drawn as a connected, heat map coloured surface.
+//
+// The field is covered by a quadtree of patches. Every patch is a grid of
+// PATCH_SIZE x PATCH_SIZE quads; a node at depth d samples the field every
+// 2^(depth - d) cells, so the leaves are full resolution and the root is the
+// whole field at the coarsest step. All patches share one index buffer.
+//
+// SetField() builds, once per field, the z range and the geometric error of
+// every node: the largest distance between the field (at the next finer
+// step) and the node's surface. Draw() walks the tree from the root, culls
+// nodes whose bounding box is outside the view frustum, and refines a node
+// while its error projected to the screen is above the tolerance in pixels.
+//
+// Patch vertices are built on demand into a fixed pool of slots in one
+// vertex buffer, least recently used first to go, and at most
+// MAX_UPLOADS_PER_FRAME patches are built per frame: a node whose children
+// are not ready yet is drawn at its own level for a few frames, and a node
+// that coarsens before its own patch is ready keeps drawing the finer
+// patches still resident below it. The cost of
+// a frame therefore depends on the screen and the tolerance, not on the size
+// of the field. Each patch carries a skirt down to its lowest point that
+// hides the cracks between neighbours of different levels.
+class CTerrainLOD
+{
+public:
+    static const int PATCH_SIZE = 32;
+    static const int MAX_RESIDENT_PATCHES = 1024;
+    static const int MAX_UPLOADS_PER_FRAME = 32;
+    // how far below a node that cannot be built yet resident patches are looked for
+    static const int MAX_FALLBACK_LEVELS = 2;
+
+    CTerrainLOD()
+        : m_heights(NULL), m_columns(0), m_rows(0), m_xMin(0.0f), m_xMax(0.0f), m_yMin(0.0f), m_yMax(0.0f),
+          m_depth(0), m_min(0.0f), m_max(0.0f), m_tolerance(2.0f), m_alpha(255),
+          m_vertexBuffer(0), m_indexBuffer(0), m_frame(0),
+          m_drawnPatches(0), m_culledPatches(0), m_uploadedPatches(0), m_deferred(false)
+    {
+    }
+
+    ~CTerrainLOD()
+    {
+        Release();
+    }
+
+    // needs a current context with buffer objects
+    bool IsAvailable() const { return g_gl.hasBuffers; }
+
+    // a_heights holds a_columns x a_rows samples stored x-major like
+    // CAnalyticSurface (sample (i, j) at i * a_rows + j) and must stay valid
+    // until the next SetField(); NaN samples are not supported. The extents
+    // are the coordinates of the first and the last sample.
+    void SetField(const float* a_heights, int a_columns, int a_rows, float a_xMin, float a_xMax, float a_yMin,
+                  float a_yMax, CThreadPool* a_pool = NULL)
+    {
+        m_heights = a_heights;
+        m_columns = a_columns;
+        m_rows = a_rows;
+        m_xMin = a_xMin;
+        m_xMax = a_xMax;
+        m_yMin = a_yMin;
+        m_yMax = a_yMax;
+
+        // smallest tree whose leaves at full resolution cover the field
+        m_depth = 0;
+        while ((PATCH_SIZE << m_depth) < std::max(a_columns, a_rows) - 1)
+            ++m_depth;
+        m_nodes.resize(m_depth + 1);
+        for (int d = 0; d <= m_depth; ++d)
+            m_nodes[d].assign((size_t)1 << (2 * d), SNode());
+
+        // the bounds and errors of the deeper level feed the next one up
+        for (int d = m_depth; d >= 0; --d)
+        {
+            const size_t l_perSide = (size_t)1 << d;
+            std::function<void(size_t)> l_task = [&](size_t a_index)
+            {
+                p_BuildNode(d, (int)(a_index % l_perSide), (int)(a_index / l_perSide));
+            };
+            if (a_pool)
+                a_pool->ParallelFor(m_nodes[d].size(), l_task);
+            else
+                for (size_t n = 0; n < m_nodes[d].size(); ++n)
+                    l_task(n);
+        }
+        m_min = m_nodes[0][0].zMin;
+        m_max = m_nodes[0][0].zMax;
+
+        // every resident patch belongs to the old field
+        m_resident.clear();
+        for (size_t s = 0; s < m_slots.size(); ++s)
+            m_slots[s].key = NO_NODE;
+    }
+
+    // refinement stops once a node's error is below a_pixels on screen
+    void SetTolerance(float a_pixels) { m_tolerance = a_pixels; }
+    void SetTransparency(float a_alpha) { m_alpha = (uint8_t)(a_alpha * 255.0f + 0.5f); }
+
+    // uses the current fixed function matrices and viewport
+    void Draw()
+    {
+        if (!m_heights || !IsAvailable())
+            return;
+        if (!m_vertexBuffer)
+            p_CreateBuffers();
+        ++m_frame;
+        m_drawnPatches = m_culledPatches = m_uploadedPatches = 0;
+        m_deferred = false;
+
+        GLfloat l_modelView[16], l_projection[16];
+        GLint l_viewport[4];
+        glGetFloatv(GL_MODELVIEW_MATRIX, l_modelView);
+        glGetFloatv(GL_PROJECTION_MATRIX, l_projection);
+        glGetIntegerv(GL_VIEWPORT, l_viewport);
+        p_SetupView(l_modelView, l_projection, l_viewport[3]);
+
+        m_draw.clear();
+        p_Select(0, 0, 0);
+
+        // a connected surface needs the depth test the point clouds do without
+        glPushAttrib(GL_ENABLE_BIT);
+        glEnable(GL_DEPTH_TEST);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        for (size_t i = 0; i < m_draw.size(); ++i)
+        {
+            // every slot is a full patch, point the arrays at its start
+            const size_t l_slot = (size_t)m_draw[i] * PATCH_VERTICES * sizeof(STerrainVertex);
+            glVertexPointer(3, GL_FLOAT, sizeof(STerrainVertex), (const void*)(l_slot + offsetof(STerrainVertex, x)));
+            glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(STerrainVertex),
+                           (const void*)(l_slot + offsetof(STerrainVertex, r)));
+            glDrawElements(GL_TRIANGLES, PATCH_INDICES, GL_UNSIGNED_SHORT, (void*)0);
+        }
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        g_gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+        glPopAttrib();
+    }
+
+    // statistics of the last Draw()
+    int DrawnPatches() const { return m_drawnPatches; }
+    int CulledPatches() const { return m_culledPatches; }
+    int UploadedPatches() const { return m_uploadedPatches; }
+    // true when the last Draw() ran out of upload budget and left nodes
+    // coarser than wanted: the next frame will refine further
+    bool IsRefining() const { return m_deferred; }
+    int Depth() const { return m_depth; }
+
+    // needs a current context
+    void Release()
+    {
+        if (m_vertexBuffer)
+        {
+            g_gl.DeleteBuffers(1, &m_vertexBuffer);
+            g_gl.DeleteBuffers(1, &m_indexBuffer);
+            m_vertexBuffer = m_indexBuffer = 0;
+        }
+        m_resident.clear();
+        m_slots.clear();
+    }
+
+private:
+    static const int PATCH_SIDE = PATCH_SIZE + 1;
+    // the grid plus one skirt vertex below every edge vertex
+    static const int PATCH_VERTICES = PATCH_SIDE * PATCH_SIDE + 4 * PATCH_SIDE;
+    static const int PATCH_INDICES = 6 * PATCH_SIZE * PATCH_SIZE + 4 * 6 * PATCH_SIZE;
+    static const uint64_t NO_NODE = ~(uint64_t)0;
+
+    struct STerrainVertex
+    {
+        GLfloat x, y, z;
+        GLubyte r, g, b, a;
+    };
+
+    struct SNode
+    {
+        float zMin;
+        float zMax;
+        // largest height difference between the field and this node's patch
+        float error;
+    };
+
+    struct SSlot
+    {
+        uint64_t key;
+        uint64_t lastUsed;
+    };
+
+    const float* m_heights;
+    int m_columns;
+    int m_rows;
+    float m_xMin, m_xMax, m_yMin, m_yMax;
+    int m_depth;
+    // per depth, node (x, y) at index y * 2^depth + x
+    std::vector<std::vector<SNode> > m_nodes;
+    float m_min;
+    float m_max;
+    float m_tolerance;
+    uint8_t m_alpha;
+
+    GLuint m_vertexBuffer;
+    GLuint m_indexBuffer;
+    std::vector<SSlot> m_slots;
+    std::unordered_map<uint64_t, int> m_resident;
+    uint64_t m_frame;
+    std::vector<int> m_draw;
+    std::vector<STerrainVertex> m_patch;
+    std::vector<float> m_patchHeights;
+
+    // view of the current frame, in field coordinates
+    float m_planes[6][4];
+    float m_camera[3];
+    // pixels per unit of error at distance 1
+    float m_pixelScale;
+
+    int m_drawnPatches;
+    int m_culledPatches;
+    int m_uploadedPatches;
+    bool m_deferred;
+
+    static uint64_t p_Key(int a_depth, int a_x, int a_y)
+    {
+        return ((uint64_t)a_depth << 56) | ((uint64_t)a_x << 28) | (uint64_t)a_y;
+    }
+
+    // sample step of a node at a_depth, in cells
+    int p_Step(int a_depth) const { return 1 << (m_depth - a_depth); }
+
+    float p_Height(int a_i, int a_j) const
+    {
+        a_i = std::min(a_i, m_columns - 1);
+        a_j = std::min(a_j, m_rows - 1);
+        return m_heights[(size_t)a_i * m_rows + a_j];
+    }
+
+    float p_X(int a_i) const
+    {
+        return m_xMin + (m_xMax - m_xMin) * std::min(a_i, m_columns - 1) / (m_columns - 1);
+    }
+
+    float p_Y(int a_j) const
+    {
+        return m_yMin + (m_yMax - m_yMin) * std::min(a_j, m_rows - 1) / (m_rows - 1);
+    }
+
+    void p_BuildNode(int a_depth, int a_x, int a_y)
+    {
+        SNode& l_node = m_nodes[a_depth][(size_t)a_y * ((size_t)1 << a_depth) + a_x];
+        const int l_step = p_Step(a_depth);
+        const int l_i0 = a_x * PATCH_SIZE * l_step;
+        const int l_j0 = a_y * PATCH_SIZE * l_step;
+        if (l_step == 1)
+        {
+            // leaf: exact, only the bounds are needed
+            l_node.zMin = FLT_MAX;
+            l_node.zMax = -FLT_MAX;
+            for (int i = 0; i <= PATCH_SIZE; ++i)
+            {
+                for (int j = 0; j <= PATCH_SIZE; ++j)
+                {
+                    const float l_z = p_Height(l_i0 + i, l_j0 + j);
+                    l_node.zMin = std::min(l_node.zMin, l_z);
+                    l_node.zMax = std::max(l_node.zMax, l_z);
+                }
+            }
+            l_node.error = 0.0f;
+            return;
+        }
+
+        // bounds and error of the children, which cover the same samples
+        const std::vector<SNode>& l_children = m_nodes[a_depth + 1];
+        const size_t l_childSide = (size_t)1 << (a_depth + 1);
+        l_node.zMin = FLT_MAX;
+        l_node.zMax = -FLT_MAX;
+        l_node.error = 0.0f;
+        for (int c = 0; c < 4; ++c)
+        {
+            const SNode& l_child = l_children[(size_t)(2 * a_y + c / 2) * l_childSide + 2 * a_x + c % 2];
+            l_node.zMin = std::min(l_node.zMin, l_child.zMin);
+            l_node.zMax = std::max(l_node.zMax, l_child.zMax);
+            l_node.error = std::max(l_node.error, l_child.error);
+        }
+
+        // plus how far the samples the children add are from this patch
+        const int l_half = l_step / 2;
+        for (int i = 0; i <= 2 * PATCH_SIZE; ++i)
+        {
+            for (int j = 0; j <= 2 * PATCH_SIZE; ++j)
+            {
+                if (i % 2 == 0 && j % 2 == 0)
+                    continue;
+                const int l_ci = l_i0 + (i / 2) * l_step;
+                const int l_cj = l_j0 + (j / 2) * l_step;
+                const float l_fx = (i % 2) * 0.5f;
+                const float l_fy = (j % 2) * 0.5f;
+                const float l_surface =
+                    (1.0f - l_fx) * ((1.0f - l_fy) * p_Height(l_ci, l_cj) + l_fy * p_Height(l_ci, l_cj + l_step)) +
+                    l_fx * ((1.0f - l_fy) * p_Height(l_ci + l_step, l_cj) +
+                            l_fy * p_Height(l_ci + l_step, l_cj + l_step));
+                const float l_z = p_Height(l_i0 + i * l_half, l_j0 + j * l_half);
+                l_node.error = std::max(l_node.error, fabsf(l_z - l_surface));
+            }
+        }
+    }
+
+    void p_CreateBuffers()
+    {
+        std::vector<GLushort> l_indices;
+        l_indices.reserve(PATCH_INDICES);
+        for (int i = 0; i < PATCH_SIZE; ++i)
+        {
+            for (int j = 0; j < PATCH_SIZE; ++j)
+            {
+                const GLushort l_a = (GLushort)(i * PATCH_SIDE + j);
+                const GLushort l_b = (GLushort)(l_a + PATCH_SIDE);
+                const GLushort l_quad[] = {l_a, l_b, (GLushort)(l_b + 1), l_a, (GLushort)(l_b + 1), (GLushort)(l_a + 1)};
+                l_indices.insert(l_indices.end(), l_quad, l_quad + 6);
+            }
+        }
+        // skirts: edge e, vertex k of the grid and the one below it
+        for (int e = 0; e < 4; ++e)
+        {
+            for (int k = 0; k < PATCH_SIZE; ++k)
+            {
+                const GLushort l_top0 = p_EdgeVertex(e, k);
+                const GLushort l_top1 = p_EdgeVertex(e, k + 1);
+                const GLushort l_bottom0 = (GLushort)(PATCH_SIDE * PATCH_SIDE + e * PATCH_SIDE + k);
+                const GLushort l_bottom1 = (GLushort)(l_bottom0 + 1);
+                const GLushort l_quad[] = {l_top0, l_bottom0, l_bottom1, l_top0, l_bottom1, l_top1};
+                l_indices.insert(l_indices.end(), l_quad, l_quad + 6);
+            }
+        }
+
+        g_gl.GenBuffers(1, &m_indexBuffer);
+        g_gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+        g_gl.BufferData(GL_ELEMENT_ARRAY_BUFFER, l_indices.size() * sizeof(GLushort), &l_indices[0], GL_STATIC_DRAW);
+        g_gl.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        g_gl.GenBuffers(1, &m_vertexBuffer);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.BufferData(GL_ARRAY_BUFFER, (size_t)MAX_RESIDENT_PATCHES * PATCH_VERTICES * sizeof(STerrainVertex),
+                        NULL, GL_DYNAMIC_DRAW);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+
+        SSlot l_free = {NO_NODE, 0};
+        m_slots.assign(MAX_RESIDENT_PATCHES, l_free);
+        m_patch.resize(PATCH_VERTICES);
+        m_patchHeights.resize(PATCH_VERTICES);
+    }
+
+    // grid vertex k along edge e: x = 0, x = max, y = 0, y = max
+    static GLushort p_EdgeVertex(int a_edge, int a_k)
+    {
+        switch (a_edge)
+        {
+            case 0:
+                return (GLushort)a_k;
+            case 1:
+                return (GLushort)(PATCH_SIZE * PATCH_SIDE + a_k);
+            case 2:
+                return (GLushort)(a_k * PATCH_SIDE);
+            default:
+                return (GLushort)(a_k * PATCH_SIDE + PATCH_SIZE);
+        }
+    }
+
+    void p_SetupView(const GLfloat* a_modelView, const GLfloat* a_projection, int a_viewportHeight)
+    {
+        // clip = projection * modelview, column major
+        float l_clip[16];
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                l_clip[c * 4 + r] = a_projection[r] * a_modelView[c * 4] + a_projection[4 + r] * a_modelView[c * 4 + 1] +
+                                    a_projection[8 + r] * a_modelView[c * 4 + 2] +
+                                    a_projection[12 + r] * a_modelView[c * 4 + 3];
+        // frustum planes from the rows of the clip matrix: w + x, w - x, ...
+        for (int p = 0; p < 6; ++p)
+        {
+            const int l_row = p / 2;
+            const float l_sign = p % 2 == 0 ? 1.0f : -1.0f;
+            for (int k = 0; k < 4; ++k)
+                m_planes[p][k] = l_clip[k * 4 + 3] + l_sign * l_clip[k * 4 + l_row];
+        }
+
+        // the modelview is a rotation and a translation: camera = -R^T t
+        for (int c = 0; c < 3; ++c)
+            m_camera[c] = -(a_modelView[c * 4] * a_modelView[12] + a_modelView[c * 4 + 1] * a_modelView[13] +
+                            a_modelView[c * 4 + 2] * a_modelView[14]);
+
+        // projection[5] = cot(fovY / 2)
+        m_pixelScale = 0.5f * a_viewportHeight * a_projection[5];
+    }
+
+    void p_Bounds(int a_depth, int a_x, int a_y, float* a_min, float* a_max) const
+    {
+        const SNode& l_node = m_nodes[a_depth][(size_t)a_y * ((size_t)1 << a_depth) + a_x];
+        const int l_span = PATCH_SIZE * p_Step(a_depth);
+        a_min[0] = p_X(a_x * l_span);
+        a_max[0] = p_X((a_x + 1) * l_span);
+        a_min[1] = p_Y(a_y * l_span);
+        a_max[1] = p_Y((a_y + 1) * l_span);
+        a_min[2] = l_node.zMin;
+        a_max[2] = l_node.zMax;
+    }
+
+    bool p_Visible(const float* a_min, const float* a_max) const
+    {
+        for (int p = 0; p < 6; ++p)
+        {
+            // the box corner furthest along the plane normal
+            float l_distance = m_planes[p][3];
+            for (int k = 0; k < 3; ++k)
+                l_distance += m_planes[p][k] * (m_planes[p][k] >= 0.0f ? a_max[k] : a_min[k]);
+            if (l_distance < 0.0f)
+                return false;
+        }
+        return true;
+    }
+
+    bool p_Refine(int a_depth, int a_x, int a_y, const float* a_min, const float* a_max) const
+    {
+        if (a_depth == m_depth)
+            return false;
+        float l_distance2 = 0.0f;
+        for (int k = 0; k < 3; ++k)
+        {
+            const float l_d = std::max(std::max(a_min[k] - m_camera[k], m_camera[k] - a_max[k]), 0.0f);
+            l_distance2 += l_d * l_d;
+        }
+        const float l_error = m_nodes[a_depth][(size_t)a_y * ((size_t)1 << a_depth) + a_x].error;
+        const float l_distance = std::max(sqrtf(l_distance2), 1e-6f);
+        return l_error * m_pixelScale / l_distance > m_tolerance;
+    }
+
+    bool p_Exists(int a_depth, int a_x, int a_y) const
+    {
+        const int l_span = PATCH_SIZE * p_Step(a_depth);
+        return a_x * l_span < m_columns - 1 && a_y * l_span < m_rows - 1;
+    }
+
+    void p_Select(int a_depth, int a_x, int a_y)
+    {
+        float l_min[3], l_max[3];
+        p_Bounds(a_depth, a_x, a_y, l_min, l_max);
+        if (!p_Visible(l_min, l_max))
+        {
+            ++m_culledPatches;
+            return;
+        }
+
+        if (p_Refine(a_depth, a_x, a_y, l_min, l_max))
+        {
+            // descend only when every visible child can be drawn this frame
+            bool l_ready = true;
+            for (int c = 0; c < 4 && l_ready; ++c)
+            {
+                const int l_cx = 2 * a_x + c % 2;
+                const int l_cy = 2 * a_y + c / 2;
+                if (!p_Exists(a_depth + 1, l_cx, l_cy))
+                    continue;
+                float l_childMin[3], l_childMax[3];
+                p_Bounds(a_depth + 1, l_cx, l_cy, l_childMin, l_childMax);
+                if (p_Visible(l_childMin, l_childMax))
+                    l_ready = p_Acquire(a_depth + 1, l_cx, l_cy, false) >= 0;
+            }
+            if (l_ready)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    const int l_cx = 2 * a_x + c % 2;
+                    const int l_cy = 2 * a_y + c / 2;
+                    if (p_Exists(a_depth + 1, l_cx, l_cy))
+                        p_Select(a_depth + 1, l_cx, l_cy);
+                }
+                return;
+            }
+        }
+
+        // the root is always drawn, whatever the upload budget
+        const int l_slot = p_Acquire(a_depth, a_x, a_y, a_depth == 0);
+        if (l_slot >= 0)
+        {
+            m_draw.push_back(l_slot);
+            ++m_drawnPatches;
+        }
+        else
+        {
+            // coarsening past the budget: the finer patches stand in
+            p_SelectResident(a_depth, a_x, a_y, MAX_FALLBACK_LEVELS);
+        }
+    }
+
+    // draws the resident patches up to a_levels below a node that has none
+    void p_SelectResident(int a_depth, int a_x, int a_y, int a_levels)
+    {
+        if (a_levels == 0 || a_depth == m_depth)
+            return;
+        for (int c = 0; c < 4; ++c)
+        {
+            const int l_cx = 2 * a_x + c % 2;
+            const int l_cy = 2 * a_y + c / 2;
+            if (!p_Exists(a_depth + 1, l_cx, l_cy))
+                continue;
+            float l_childMin[3], l_childMax[3];
+            p_Bounds(a_depth + 1, l_cx, l_cy, l_childMin, l_childMax);
+            if (!p_Visible(l_childMin, l_childMax))
+                continue;
+            std::unordered_map<uint64_t, int>::iterator l_found = m_resident.find(p_Key(a_depth + 1, l_cx, l_cy));
+            if (l_found != m_resident.end())
+            {
+                m_slots[l_found->second].lastUsed = m_frame;
+                m_draw.push_back(l_found->second);
+                ++m_drawnPatches;
+            }
+            else
+            {
+                p_SelectResident(a_depth + 1, l_cx, l_cy, a_levels - 1);
+            }
+        }
+    }
+
+    // slot holding the patch of a node, built now if the budget allows;
+    // -1 when it is not resident and cannot be built this frame
+    int p_Acquire(int a_depth, int a_x, int a_y, bool a_force)
+    {
+        const uint64_t l_key = p_Key(a_depth, a_x, a_y);
+        std::unordered_map<uint64_t, int>::iterator l_found = m_resident.find(l_key);
+        if (l_found != m_resident.end())
+        {
+            m_slots[l_found->second].lastUsed = m_frame;
+            return l_found->second;
+        }
+        if (m_uploadedPatches >= MAX_UPLOADS_PER_FRAME && !a_force)
+        {
+            m_deferred = true;
+            return -1;
+        }
+
+        // least recently used slot that this frame does not draw
+        int l_slot = -1;
+        for (int s = 0; s < (int)m_slots.size(); ++s)
+        {
+            if (m_slots[s].key == NO_NODE)
+            {
+                l_slot = s;
+                break;
+            }
+            if (m_slots[s].lastUsed != m_frame && (l_slot < 0 || m_slots[s].lastUsed < m_slots[l_slot].lastUsed))
+                l_slot = s;
+        }
+        if (l_slot < 0)
+            return -1;
+        if (m_slots[l_slot].key != NO_NODE)
+            m_resident.erase(m_slots[l_slot].key);
+
+        p_BuildPatch(a_depth, a_x, a_y, l_slot);
+        m_slots[l_slot].key = l_key;
+        m_slots[l_slot].lastUsed = m_frame;
+        m_resident[l_key] = l_slot;
+        ++m_uploadedPatches;
+        return l_slot;
+    }
+
+    void p_BuildPatch(int a_depth, int a_x, int a_y, int a_slot)
+    {
+        const int l_step = p_Step(a_depth);
+        const int l_i0 = a_x * PATCH_SIZE * l_step;
+        const int l_j0 = a_y * PATCH_SIZE * l_step;
+        const SNode& l_node = m_nodes[a_depth][(size_t)a_y * ((size_t)1 << a_depth) + a_x];
+
+        for (int i = 0; i <= PATCH_SIZE; ++i)
+        {
+            for (int j = 0; j <= PATCH_SIZE; ++j)
+            {
+                STerrainVertex& l_vertex = m_patch[i * PATCH_SIDE + j];
+                l_vertex.x = p_X(l_i0 + i * l_step);
+                l_vertex.y = p_Y(l_j0 + j * l_step);
+                l_vertex.z = p_Height(l_i0 + i * l_step, l_j0 + j * l_step);
+                m_patchHeights[i * PATCH_SIDE + j] = l_vertex.z;
+            }
+        }
+        HeatMapRGBA8(&m_patchHeights[0], PATCH_SIDE * PATCH_SIDE, m_min, m_max, m_alpha, &m_patch[0].r,
+                     sizeof(STerrainVertex));
+        // skirts hang from the edges down to the lowest point of the patch,
+        // deep enough to cover the edge of any coarser neighbour
+        for (int e = 0; e < 4; ++e)
+        {
+            for (int k = 0; k < PATCH_SIDE; ++k)
+            {
+                STerrainVertex& l_skirt = m_patch[PATCH_SIDE * PATCH_SIDE + e * PATCH_SIDE + k];
+                l_skirt = m_patch[p_EdgeVertex(e, k)];
+                l_skirt.z = l_node.zMin;
+            }
+        }
+
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+        g_gl.BufferSubData(GL_ARRAY_BUFFER, (size_t)a_slot * PATCH_VERTICES * sizeof(STerrainVertex),
+                           PATCH_VERTICES * sizeof(STerrainVertex), &m_patch[0]);
+        g_gl.BindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for data parallel loops. ParallelFor() deals the
+// task indices out in contiguous runs, one run per thread, so neighbouring
+// tiles stay on the same core. Every thread works through its own queue from
+// the back and, once that is empty, steals from the front of the others:
+// uneven tiles (e.g. cheap ones outside a peak) balance themselves without
+// any central queue. The calling thread takes part in the work.
+class CThreadPool
+{
+public:
+    // a_numThreads includes the calling thread; 0 uses every core
+    CThreadPool(int a_numThreads = 0)
+        : m_task(NULL), m_remaining(0), m_generation(0), m_stop(false)
+    {
+        if (a_numThreads <= 0)
+            a_numThreads = (int)std::thread::hardware_concurrency();
+        if (a_numThreads <= 0)
+            a_numThreads = 1;
+        for (int i = 0; i < a_numThreads; ++i)
+            m_queues.push_back(new SQueue());
+        // the last queue belongs to the calling thread
+        for (int i = 0; i < a_numThreads - 1; ++i)
+            m_workers.push_back(std::thread(&CThreadPool::p_Worker, this, i));
+    }
+
+    ~CThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> l_lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (size_t i = 0; i < m_workers.size(); ++i)
+            m_workers[i].join();
+        for (size_t i = 0; i < m_queues.size(); ++i)
+            delete m_queues[i];
+    }
+
+    int NumThreads() const { return (int)m_queues.size(); }
+
+    // calls a_task(i) for every i < a_count and returns when all are done
+    void ParallelFor(size_t a_count, const std::function<void(size_t)>& a_task)
+    {
+        if (a_count == 0)
+            return;
+        if (m_queues.size() == 1)
+        {
+            for (size_t i = 0; i < a_count; ++i)
+                a_task(i);
+            return;
+        }
+
+        m_task = &a_task;
+        m_remaining.store(a_count);
+        const size_t l_numQueues = m_queues.size();
+        for (size_t q = 0; q < l_numQueues; ++q)
+        {
+            std::lock_guard<std::mutex> l_lock(m_queues[q]->mutex);
+            for (size_t i = q * a_count / l_numQueues; i < (q + 1) * a_count / l_numQueues; ++i)
+                m_queues[q]->tasks.push_back(i);
+        }
+        {
+            std::lock_guard<std::mutex> l_lock(m_mutex);
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        p_Work(l_numQueues - 1);
+
+        std::unique_lock<std::mutex> l_lock(m_mutex);
+        m_done.wait(l_lock, [this] { return m_remaining.load() == 0; });
+    }
+
+private:
+    struct SQueue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    std::vector<SQueue*> m_queues;
+    std::vector<std::thread> m_workers;
+    const std::function<void(size_t)>* m_task;
+    std::atomic<size_t> m_remaining;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation;
+    bool m_stop;
+
+    bool p_Pop(size_t a_queue, size_t* a_index)
+    {
+        SQueue* l_own = m_queues[a_queue];
+        {
+            std::lock_guard<std::mutex> l_lock(l_own->mutex);
+            if (!l_own->tasks.empty())
+            {
+                *a_index = l_own->tasks.back();
+                l_own->tasks.pop_back();
+                return true;
+            }
+        }
+        // steal the task furthest away from what the victim works on
+        for (size_t i = 1; i < m_queues.size(); ++i)
+        {
+            SQueue* l_victim = m_queues[(a_queue + i) % m_queues.size()];
+            std::lock_guard<std::mutex> l_lock(l_victim->mutex);
+            if (!l_victim->tasks.empty())
+            {
+                *a_index = l_victim->tasks.front();
+                l_victim->tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void p_Work(size_t a_queue)
+    {
+        size_t l_index;
+        while (p_Pop(a_queue, &l_index))
+        {
+            (*m_task)(l_index);
+            if (m_remaining.fetch_sub(1) == 1)
+            {
+                // last task of the loop: wake the caller
+                std::lock_guard<std::mutex> l_lock(m_mutex);
+                m_done.notify_all();
+            }
+        }
+    }
+
+    void p_Worker(size_t a_queue)
+    {
+        uint64_t l_seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> l_lock(m_mutex);
+                m_wake.wait(l_lock, [this, l_seen] { return m_stop || m_generation != l_seen; });
+                if (m_stop)
+                    return;
+                l_seen = m_generation;
+            }
+            p_Work(a_queue);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,463 @@
+#ifndef VMATH_H
+#define VMATH_H
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Vectorized cos/exp/log over float arrays for the function-sampled plot
+// generators. The approximations follow the Cephes single precision
+// routines (about 2 ulp over the ranges the demos use) and are evaluated 8
+// lanes at a time with AVX2+FMA, 4 lanes with SSE2, or one at a time on other
+// CPUs. The widest kernel the CPU supports is picked on first use.
+//
+//   VecCos(in, out, n)  out[i] = cos(in[i])   accurate for |in[i]| < 8192
+//   VecExp(in, out, n)  out[i] = exp(in[i])   +inf above 88.72, denormals
+//                                              below -87.34, 0 below -103.97
+//   VecLog(in, out, n)  out[i] = log(in[i])   NaN for in[i] < 0, -inf for 0,
+//                                              +inf for +inf
+// NaN inputs give NaN. Chapter2/bench_vmath.cpp checks the accuracy against libm and
+// measures the throughput of every kernel.
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#define VMATH_X86 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+// shared constants
+// beyond these exp(x) is +inf or rounds to 0; 2^n stays within [-150, 128]
+#define VMATH_EXP_HI 89.0f
+#define VMATH_EXP_LO -104.0f
+// 2^24, scales a denormal into the normal range
+#define VMATH_TWO24 16777216.0f
+#define VMATH_LOG2EF 1.44269504088896341f
+#define VMATH_EXP_C1 0.693359375f
+#define VMATH_EXP_C2 -2.12194440e-4f
+#define VMATH_EXP_P0 1.9875691500E-4f
+#define VMATH_EXP_P1 1.3981999507E-3f
+#define VMATH_EXP_P2 8.3334519073E-3f
+#define VMATH_EXP_P3 4.1665795894E-2f
+#define VMATH_EXP_P4 1.6666665459E-1f
+#define VMATH_EXP_P5 5.0000001201E-1f
+
+#define VMATH_SQRTHF 0.707106781186547524f
+#define VMATH_LOG_P0 7.0376836292E-2f
+#define VMATH_LOG_P1 -1.1514610310E-1f
+#define VMATH_LOG_P2 1.1676998740E-1f
+#define VMATH_LOG_P3 -1.2420140846E-1f
+#define VMATH_LOG_P4 1.4249322787E-1f
+#define VMATH_LOG_P5 -1.6668057665E-1f
+#define VMATH_LOG_P6 2.0000714765E-1f
+#define VMATH_LOG_P7 -2.4999993993E-1f
+#define VMATH_LOG_P8 3.3333331174E-1f
+
+#define VMATH_FOPI 1.27323954473516f
+#define VMATH_DP1 0.78515625f
+#define VMATH_DP2 2.4187564849853515625e-4f
+#define VMATH_DP3 3.77489497744594108e-8f
+#define VMATH_SIN_P0 -1.9515295891E-4f
+#define VMATH_SIN_P1 8.3321608736E-3f
+#define VMATH_SIN_P2 -1.6666654611E-1f
+#define VMATH_COS_P0 2.443315711809948E-005f
+#define VMATH_COS_P1 -1.388731625493765E-003f
+#define VMATH_COS_P2 4.166664568298827E-002f
+
+typedef void (*VecFunction)(const float*, float*, size_t);
+
+// ---------------------------------------------------------------------------
+// scalar reference, also used for the tails of the SIMD kernels
+
+static float p_ScalarExp(float a_x)
+{
+    if (a_x != a_x)
+        return a_x;
+    if (a_x > VMATH_EXP_HI)
+        a_x = VMATH_EXP_HI;
+    if (a_x < VMATH_EXP_LO)
+        a_x = VMATH_EXP_LO;
+    // exp(x) = 2^n * exp(r) with r = x - n * ln(2)
+    const float l_n = floorf(a_x * VMATH_LOG2EF + 0.5f);
+    const float l_r = a_x - l_n * VMATH_EXP_C1 - l_n * VMATH_EXP_C2;
+    float l_y = VMATH_EXP_P0;
+    l_y = l_y * l_r + VMATH_EXP_P1;
+    l_y = l_y * l_r + VMATH_EXP_P2;
+    l_y = l_y * l_r + VMATH_EXP_P3;
+    l_y = l_y * l_r + VMATH_EXP_P4;
+    l_y = l_y * l_r + VMATH_EXP_P5;
+    l_y = l_y * l_r * l_r + l_r + 1.0f;
+    // 2^n in two halves, each a normal float, so the last product overflows
+    // to +inf or rounds into the denormals like expf
+    const int32_t l_half = (int32_t)l_n >> 1;
+    const int32_t l_bits[2] = {(l_half + 127) << 23, ((int32_t)l_n - l_half + 127) << 23};
+    float l_scale[2];
+    memcpy(l_scale, l_bits, sizeof(l_scale));
+    return l_y * l_scale[0] * l_scale[1];
+}
+
+static float p_ScalarLog(float a_x)
+{
+    if (a_x < 0.0f || a_x != a_x)
+        return NAN;
+    if (a_x == 0.0f)
+        return -HUGE_VALF;
+    if (a_x == HUGE_VALF)
+        return a_x;
+    // denormals are scaled by 2^24 into the normal range
+    float l_e = -126.0f;
+    if (a_x < FLT_MIN)
+    {
+        a_x *= VMATH_TWO24;
+        l_e -= 24.0f;
+    }
+    // split into mantissa in [0.5, 1) and exponent
+    int32_t l_bits;
+    memcpy(&l_bits, &a_x, sizeof(l_bits));
+    l_e += (float)((l_bits >> 23) & 0xff);
+    l_bits = (l_bits & 0x807fffff) | 0x3f000000;
+    float l_m;
+    memcpy(&l_m, &l_bits, sizeof(l_m));
+    if (l_m < VMATH_SQRTHF)
+    {
+        l_e -= 1.0f;
+        l_m = l_m + l_m - 1.0f;
+    }
+    else
+    {
+        l_m = l_m - 1.0f;
+    }
+    const float l_z = l_m * l_m;
+    float l_y = VMATH_LOG_P0;
+    l_y = l_y * l_m + VMATH_LOG_P1;
+    l_y = l_y * l_m + VMATH_LOG_P2;
+    l_y = l_y * l_m + VMATH_LOG_P3;
+    l_y = l_y * l_m + VMATH_LOG_P4;
+    l_y = l_y * l_m + VMATH_LOG_P5;
+    l_y = l_y * l_m + VMATH_LOG_P6;
+    l_y = l_y * l_m + VMATH_LOG_P7;
+    l_y = l_y * l_m + VMATH_LOG_P8;
+    l_y = l_y * l_m * l_z;
+    l_y += l_e * VMATH_EXP_C2;
+    l_y += -0.5f * l_z;
+    return l_m + l_y + l_e * VMATH_EXP_C1;
+}
+
+static float p_ScalarCos(float a_x)
+{
+    // reduce to an octant of [0, pi/4] and pick the sin or cos polynomial
+    float l_x = a_x < 0.0f ? -a_x : a_x;
+    int l_j = (int)(l_x * VMATH_FOPI);
+    l_j = (l_j + 1) & ~1;
+    const float l_y = (float)l_j;
+    l_j -= 2;
+    const bool l_negate = (l_j & 4) == 0;
+    const bool l_sinPoly = (l_j & 2) == 0;
+    l_x = ((l_x - l_y * VMATH_DP1) - l_y * VMATH_DP2) - l_y * VMATH_DP3;
+    const float l_z = l_x * l_x;
+    float l_r;
+    if (l_sinPoly)
+    {
+        l_r = ((VMATH_SIN_P0 * l_z + VMATH_SIN_P1) * l_z + VMATH_SIN_P2) * l_z * l_x + l_x;
+    }
+    else
+    {
+        l_r = ((VMATH_COS_P0 * l_z + VMATH_COS_P1) * l_z + VMATH_COS_P2) * l_z * l_z - 0.5f * l_z + 1.0f;
+    }
+    return l_negate ? -l_r : l_r;
+}
+
+static void p_ScalarExpArray(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = p_ScalarExp(a_in[i]);
+}
+
+static void p_ScalarLogArray(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = p_ScalarLog(a_in[i]);
+}
+
+static void p_ScalarCosArray(const float* a_in, float* a_out, size_t a_count)
+{
+    for (size_t i = 0; i < a_count; ++i)
+        a_out[i] = p_ScalarCos(a_in[i]);
+}
+
+#ifdef VMATH_X86
+// ---------------------------------------------------------------------------
+// SSE2, 4 lanes
+
+static void p_SSEExpArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= a_count; i += 4)
+    {
+        const __m128 l_in = _mm_loadu_ps(a_in + i);
+        const __m128 l_nan = _mm_cmpunord_ps(l_in, l_in);
+        __m128 l_x = _mm_min_ps(_mm_max_ps(l_in, _mm_set1_ps(VMATH_EXP_LO)), _mm_set1_ps(VMATH_EXP_HI));
+        // n = floor(x * log2(e) + 0.5)
+        __m128 l_n = _mm_add_ps(_mm_mul_ps(l_x, _mm_set1_ps(VMATH_LOG2EF)), _mm_set1_ps(0.5f));
+        __m128 l_t = _mm_cvtepi32_ps(_mm_cvttps_epi32(l_n));
+        l_n = _mm_sub_ps(l_t, _mm_and_ps(_mm_cmpgt_ps(l_t, l_n), _mm_set1_ps(1.0f)));
+        __m128 l_r = _mm_sub_ps(l_x, _mm_mul_ps(l_n, _mm_set1_ps(VMATH_EXP_C1)));
+        l_r = _mm_sub_ps(l_r, _mm_mul_ps(l_n, _mm_set1_ps(VMATH_EXP_C2)));
+        __m128 l_y = _mm_set1_ps(VMATH_EXP_P0);
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_r), _mm_set1_ps(VMATH_EXP_P1));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_r), _mm_set1_ps(VMATH_EXP_P2));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_r), _mm_set1_ps(VMATH_EXP_P3));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_r), _mm_set1_ps(VMATH_EXP_P4));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_r), _mm_set1_ps(VMATH_EXP_P5));
+        l_y = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(l_y, l_r), l_r), _mm_add_ps(l_r, _mm_set1_ps(1.0f)));
+        // 2^n built directly in the exponent bits, in two halves
+        const __m128i l_ni = _mm_cvttps_epi32(l_n);
+        const __m128i l_half = _mm_srai_epi32(l_ni, 1);
+        const __m128i l_bits0 = _mm_slli_epi32(_mm_add_epi32(l_half, _mm_set1_epi32(127)), 23);
+        const __m128i l_bits1 = _mm_slli_epi32(_mm_add_epi32(_mm_sub_epi32(l_ni, l_half), _mm_set1_epi32(127)), 23);
+        l_y = _mm_mul_ps(_mm_mul_ps(l_y, _mm_castsi128_ps(l_bits0)), _mm_castsi128_ps(l_bits1));
+        _mm_storeu_ps(a_out + i, _mm_or_ps(_mm_andnot_ps(l_nan, l_y), _mm_and_ps(l_nan, l_in)));
+    }
+    p_ScalarExpArray(a_in + i, a_out + i, a_count - i);
+}
+
+static void p_SSELogArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= a_count; i += 4)
+    {
+        const __m128 l_in = _mm_loadu_ps(a_in + i);
+        const __m128 l_invalid = _mm_cmpnge_ps(l_in, _mm_setzero_ps());
+        const __m128 l_zero = _mm_cmpeq_ps(l_in, _mm_setzero_ps());
+        const __m128 l_infinite = _mm_cmpeq_ps(l_in, _mm_set1_ps(HUGE_VALF));
+        // denormals are scaled by 2^24 into the normal range
+        const __m128 l_denormal = _mm_cmplt_ps(l_in, _mm_set1_ps(FLT_MIN));
+        const __m128 l_x = _mm_or_ps(_mm_andnot_ps(l_denormal, l_in),
+                                     _mm_and_ps(l_denormal, _mm_mul_ps(l_in, _mm_set1_ps(VMATH_TWO24))));
+        __m128i l_bits = _mm_castps_si128(l_x);
+        __m128 l_e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(l_bits, 23), _mm_set1_epi32(126)));
+        l_e = _mm_sub_ps(l_e, _mm_and_ps(l_denormal, _mm_set1_ps(24.0f)));
+        __m128 l_m = _mm_or_ps(_mm_and_ps(l_x, _mm_castsi128_ps(_mm_set1_epi32(0x807fffff))), _mm_set1_ps(0.5f));
+        // m < sqrt(0.5): e -= 1, m = 2m - 1, otherwise m = m - 1
+        const __m128 l_small = _mm_cmplt_ps(l_m, _mm_set1_ps(VMATH_SQRTHF));
+        l_e = _mm_sub_ps(l_e, _mm_and_ps(l_small, _mm_set1_ps(1.0f)));
+        l_m = _mm_add_ps(_mm_sub_ps(l_m, _mm_set1_ps(1.0f)), _mm_and_ps(l_small, l_m));
+        const __m128 l_z = _mm_mul_ps(l_m, l_m);
+        __m128 l_y = _mm_set1_ps(VMATH_LOG_P0);
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P1));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P2));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P3));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P4));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P5));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P6));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P7));
+        l_y = _mm_add_ps(_mm_mul_ps(l_y, l_m), _mm_set1_ps(VMATH_LOG_P8));
+        l_y = _mm_mul_ps(_mm_mul_ps(l_y, l_m), l_z);
+        l_y = _mm_add_ps(l_y, _mm_mul_ps(l_e, _mm_set1_ps(VMATH_EXP_C2)));
+        l_y = _mm_sub_ps(l_y, _mm_mul_ps(l_z, _mm_set1_ps(0.5f)));
+        __m128 l_r = _mm_add_ps(_mm_add_ps(l_m, l_y), _mm_mul_ps(l_e, _mm_set1_ps(VMATH_EXP_C1)));
+        // log(0) = -inf, log(inf) = inf, log(x < 0) = NaN
+        l_r = _mm_or_ps(_mm_andnot_ps(l_zero, l_r), _mm_and_ps(l_zero, _mm_set1_ps(-HUGE_VALF)));
+        l_r = _mm_or_ps(_mm_andnot_ps(l_infinite, l_r), _mm_and_ps(l_infinite, l_in));
+        l_r = _mm_or_ps(l_r, l_invalid);
+        _mm_storeu_ps(a_out + i, l_r);
+    }
+    p_ScalarLogArray(a_in + i, a_out + i, a_count - i);
+}
+
+static void p_SSECosArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 4 <= a_count; i += 4)
+    {
+        __m128 l_x = _mm_and_ps(_mm_loadu_ps(a_in + i), _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)));
+        __m128i l_j = _mm_cvttps_epi32(_mm_mul_ps(l_x, _mm_set1_ps(VMATH_FOPI)));
+        l_j = _mm_and_si128(_mm_add_epi32(l_j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+        const __m128 l_y = _mm_cvtepi32_ps(l_j);
+        l_j = _mm_sub_epi32(l_j, _mm_set1_epi32(2));
+        const __m128 l_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(l_j, _mm_set1_epi32(4)), 29));
+        const __m128 l_sinPoly = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(l_j, _mm_set1_epi32(2)), _mm_setzero_si128()));
+        l_x = _mm_sub_ps(l_x, _mm_mul_ps(l_y, _mm_set1_ps(VMATH_DP1)));
+        l_x = _mm_sub_ps(l_x, _mm_mul_ps(l_y, _mm_set1_ps(VMATH_DP2)));
+        l_x = _mm_sub_ps(l_x, _mm_mul_ps(l_y, _mm_set1_ps(VMATH_DP3)));
+        const __m128 l_z = _mm_mul_ps(l_x, l_x);
+
+        __m128 l_c = _mm_set1_ps(VMATH_COS_P0);
+        l_c = _mm_add_ps(_mm_mul_ps(l_c, l_z), _mm_set1_ps(VMATH_COS_P1));
+        l_c = _mm_add_ps(_mm_mul_ps(l_c, l_z), _mm_set1_ps(VMATH_COS_P2));
+        l_c = _mm_mul_ps(_mm_mul_ps(l_c, l_z), l_z);
+        l_c = _mm_add_ps(_mm_sub_ps(l_c, _mm_mul_ps(l_z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+        __m128 l_s = _mm_set1_ps(VMATH_SIN_P0);
+        l_s = _mm_add_ps(_mm_mul_ps(l_s, l_z), _mm_set1_ps(VMATH_SIN_P1));
+        l_s = _mm_add_ps(_mm_mul_ps(l_s, l_z), _mm_set1_ps(VMATH_SIN_P2));
+        l_s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(l_s, l_z), l_x), l_x);
+
+        const __m128 l_r = _mm_or_ps(_mm_and_ps(l_sinPoly, l_s), _mm_andnot_ps(l_sinPoly, l_c));
+        _mm_storeu_ps(a_out + i, _mm_xor_ps(l_r, l_sign));
+    }
+    p_ScalarCosArray(a_in + i, a_out + i, a_count - i);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 + FMA, 8 lanes; compiled for those instructions only, and only
+// called after the CPU reported support for them
+
+#define VMATH_AVX2 __attribute__((target("avx2,fma")))
+
+VMATH_AVX2 static void p_AVX2ExpArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8)
+    {
+        const __m256 l_in = _mm256_loadu_ps(a_in + i);
+        const __m256 l_nan = _mm256_cmp_ps(l_in, l_in, _CMP_UNORD_Q);
+        const __m256 l_x = _mm256_min_ps(_mm256_max_ps(l_in, _mm256_set1_ps(VMATH_EXP_LO)), _mm256_set1_ps(VMATH_EXP_HI));
+        const __m256 l_n = _mm256_floor_ps(_mm256_fmadd_ps(l_x, _mm256_set1_ps(VMATH_LOG2EF), _mm256_set1_ps(0.5f)));
+        __m256 l_r = _mm256_fnmadd_ps(l_n, _mm256_set1_ps(VMATH_EXP_C1), l_x);
+        l_r = _mm256_fnmadd_ps(l_n, _mm256_set1_ps(VMATH_EXP_C2), l_r);
+        __m256 l_y = _mm256_set1_ps(VMATH_EXP_P0);
+        l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(VMATH_EXP_P1));
+        l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(VMATH_EXP_P2));
+        l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(VMATH_EXP_P3));
+        l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(VMATH_EXP_P4));
+        l_y = _mm256_fmadd_ps(l_y, l_r, _mm256_set1_ps(VMATH_EXP_P5));
+        l_y = _mm256_fmadd_ps(_mm256_mul_ps(l_y, l_r), l_r, _mm256_add_ps(l_r, _mm256_set1_ps(1.0f)));
+        const __m256i l_ni = _mm256_cvttps_epi32(l_n);
+        const __m256i l_half = _mm256_srai_epi32(l_ni, 1);
+        const __m256i l_bits0 = _mm256_slli_epi32(_mm256_add_epi32(l_half, _mm256_set1_epi32(127)), 23);
+        const __m256i l_bits1 = _mm256_slli_epi32(_mm256_add_epi32(_mm256_sub_epi32(l_ni, l_half), _mm256_set1_epi32(127)), 23);
+        l_y = _mm256_mul_ps(_mm256_mul_ps(l_y, _mm256_castsi256_ps(l_bits0)), _mm256_castsi256_ps(l_bits1));
+        _mm256_storeu_ps(a_out + i, _mm256_blendv_ps(l_y, l_in, l_nan));
+    }
+    p_ScalarExpArray(a_in + i, a_out + i, a_count - i);
+}
+
+VMATH_AVX2 static void p_AVX2LogArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8)
+    {
+        const __m256 l_in = _mm256_loadu_ps(a_in + i);
+        const __m256 l_invalid = _mm256_cmp_ps(l_in, _mm256_setzero_ps(), _CMP_NGE_UQ);
+        const __m256 l_zero = _mm256_cmp_ps(l_in, _mm256_setzero_ps(), _CMP_EQ_OQ);
+        const __m256 l_infinite = _mm256_cmp_ps(l_in, _mm256_set1_ps(HUGE_VALF), _CMP_EQ_OQ);
+        const __m256 l_denormal = _mm256_cmp_ps(l_in, _mm256_set1_ps(FLT_MIN), _CMP_LT_OQ);
+        const __m256 l_x = _mm256_blendv_ps(l_in, _mm256_mul_ps(l_in, _mm256_set1_ps(VMATH_TWO24)), l_denormal);
+        const __m256i l_bits = _mm256_castps_si256(l_x);
+        __m256 l_e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(l_bits, 23), _mm256_set1_epi32(126)));
+        l_e = _mm256_sub_ps(l_e, _mm256_and_ps(l_denormal, _mm256_set1_ps(24.0f)));
+        __m256 l_m = _mm256_or_ps(_mm256_and_ps(l_x, _mm256_castsi256_ps(_mm256_set1_epi32(0x807fffff))), _mm256_set1_ps(0.5f));
+        const __m256 l_small = _mm256_cmp_ps(l_m, _mm256_set1_ps(VMATH_SQRTHF), _CMP_LT_OQ);
+        l_e = _mm256_sub_ps(l_e, _mm256_and_ps(l_small, _mm256_set1_ps(1.0f)));
+        l_m = _mm256_add_ps(_mm256_sub_ps(l_m, _mm256_set1_ps(1.0f)), _mm256_and_ps(l_small, l_m));
+        const __m256 l_z = _mm256_mul_ps(l_m, l_m);
+        __m256 l_y = _mm256_set1_ps(VMATH_LOG_P0);
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P1));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P2));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P3));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P4));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P5));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P6));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P7));
+        l_y = _mm256_fmadd_ps(l_y, l_m, _mm256_set1_ps(VMATH_LOG_P8));
+        l_y = _mm256_mul_ps(_mm256_mul_ps(l_y, l_m), l_z);
+        l_y = _mm256_fmadd_ps(l_e, _mm256_set1_ps(VMATH_EXP_C2), l_y);
+        l_y = _mm256_fnmadd_ps(l_z, _mm256_set1_ps(0.5f), l_y);
+        __m256 l_r = _mm256_fmadd_ps(l_e, _mm256_set1_ps(VMATH_EXP_C1), _mm256_add_ps(l_m, l_y));
+        l_r = _mm256_blendv_ps(l_r, _mm256_set1_ps(-HUGE_VALF), l_zero);
+        l_r = _mm256_blendv_ps(l_r, l_in, l_infinite);
+        l_r = _mm256_or_ps(l_r, l_invalid);
+        _mm256_storeu_ps(a_out + i, l_r);
+    }
+    p_ScalarLogArray(a_in + i, a_out + i, a_count - i);
+}
+
+VMATH_AVX2 static void p_AVX2CosArray(const float* a_in, float* a_out, size_t a_count)
+{
+    size_t i = 0;
+    for (; i + 8 <= a_count; i += 8)
+    {
+        __m256 l_x = _mm256_and_ps(_mm256_loadu_ps(a_in + i), _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff)));
+        __m256i l_j = _mm256_cvttps_epi32(_mm256_mul_ps(l_x, _mm256_set1_ps(VMATH_FOPI)));
+        l_j = _mm256_and_si256(_mm256_add_epi32(l_j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+        const __m256 l_y = _mm256_cvtepi32_ps(l_j);
+        l_j = _mm256_sub_epi32(l_j, _mm256_set1_epi32(2));
+        const __m256 l_sign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_andnot_si256(l_j, _mm256_set1_epi32(4)), 29));
+        const __m256 l_sinPoly = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(l_j, _mm256_set1_epi32(2)), _mm256_setzero_si256()));
+        l_x = _mm256_fnmadd_ps(l_y, _mm256_set1_ps(VMATH_DP1), l_x);
+        l_x = _mm256_fnmadd_ps(l_y, _mm256_set1_ps(VMATH_DP2), l_x);
+        l_x = _mm256_fnmadd_ps(l_y, _mm256_set1_ps(VMATH_DP3), l_x);
+        const __m256 l_z = _mm256_mul_ps(l_x, l_x);
+
+        __m256 l_c = _mm256_set1_ps(VMATH_COS_P0);
+        l_c = _mm256_fmadd_ps(l_c, l_z, _mm256_set1_ps(VMATH_COS_P1));
+        l_c = _mm256_fmadd_ps(l_c, l_z, _mm256_set1_ps(VMATH_COS_P2));
+        l_c = _mm256_mul_ps(_mm256_mul_ps(l_c, l_z), l_z);
+        l_c = _mm256_add_ps(_mm256_fnmadd_ps(l_z, _mm256_set1_ps(0.5f), l_c), _mm256_set1_ps(1.0f));
+
+        __m256 l_s = _mm256_set1_ps(VMATH_SIN_P0);
+        l_s = _mm256_fmadd_ps(l_s, l_z, _mm256_set1_ps(VMATH_SIN_P1));
+        l_s = _mm256_fmadd_ps(l_s, l_z, _mm256_set1_ps(VMATH_SIN_P2));
+        l_s = _mm256_fmadd_ps(_mm256_mul_ps(l_s, l_z), l_x, l_x);
+
+        const __m256 l_r = _mm256_blendv_ps(l_c, l_s, l_sinPoly);
+        _mm256_storeu_ps(a_out + i, _mm256_xor_ps(l_r, l_sign));
+    }
+    p_ScalarCosArray(a_in + i, a_out + i, a_count - i);
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// runtime dispatch
+
+struct SVecMathKernels
+{
+    VecFunction cos;
+    VecFunction exp;
+    VecFunction log;
+    const char* name;
+};
+
+static SVecMathKernels p_SelectVecMathKernels()
+{
+    SVecMathKernels l_kernels = {p_ScalarCosArray, p_ScalarExpArray, p_ScalarLogArray, "scalar"};
+#ifdef VMATH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+    {
+        SVecMathKernels l_avx2 = {p_AVX2CosArray, p_AVX2ExpArray, p_AVX2LogArray, "AVX2"};
+        l_kernels = l_avx2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        SVecMathKernels l_sse = {p_SSECosArray, p_SSEExpArray, p_SSELogArray, "SSE2"};
+        l_kernels = l_sse;
+    }
+#endif
+    return l_kernels;
+}
+
+inline const SVecMathKernels& VecMathKernels()
+{
+    static const SVecMathKernels l_kernels = p_SelectVecMathKernels();
+    return l_kernels;
+}
+
+inline void VecCos(const float* a_in, float* a_out, size_t a_count)
+{
+    VecMathKernels().cos(a_in, a_out, a_count);
+}
+
+inline void VecExp(const float* a_in, float* a_out, size_t a_count)
+{
+    VecMathKernels().exp(a_in, a_out, a_count);
+}
+
+inline void VecLog(const float* a_in, float* a_out, size_t a_count)
+{
+    VecMathKernels().log(a_in, a_out, a_count);
+}
+
+#endif
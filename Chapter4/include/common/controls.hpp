@@ -2,6 +2,7 @@
 #define CONTROLS_HPP
 
 #include "common/common.h"
+#include "common/input_queue.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -15,6 +16,11 @@ public:
     glm::mat4 GetViewMatrix();
     glm::mat4 GetProjectionMatrix();
 
+    // with a queue the arrow keys come from its events instead of polling,
+    // timed to the moment they were pressed and released; the queue's key
+    // callback has to push into it and nothing else may pop from it
+    void SetInputQueue(CInputQueue* a_input);
+
     void ComputeMatricesFromWindow(GLFWwindow* a_window);
 
 private:
@@ -26,6 +32,15 @@ private:
     // the view matrix and projection matrix
     glm::mat4 m_viewMatrix;
     glm::mat4 m_projectionMatrix;
+    // state of every key as replayed from m_input
+    CInputQueue* m_input;
+    bool m_keyDown[GLFW_KEY_LAST + 1];
+    double m_keyDownSince[GLFW_KEY_LAST + 1];
+    // time the keys released during this frame were down, read by p_HeldTime
+    double m_keyHeld[GLFW_KEY_LAST + 1];
+
+    void p_ApplyInput(double a_frameStart);
+    float p_HeldTime(GLFWwindow* a_window, int a_key, double a_frameStart, double a_frameEnd);
 };
 
 
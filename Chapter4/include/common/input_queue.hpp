@@ -0,0 +1,214 @@
+#ifndef INPUT_QUEUE_HPP
+#define INPUT_QUEUE_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+
+// Timestamped input events between the GLFW callbacks (producer) and the
+// once-per-frame camera update (consumer), without locks. Discrete events
+// (keys, mouse buttons) go through a single producer / single consumer ring
+// in order. Continuous input is coalesced on the way in: the cursor keeps
+// only its latest position and scrolling accumulates, so a 1000 Hz mouse
+// adds one update per frame, never a backlog the frame has to work through.
+//
+// Every input keeps the glfwGetTime() of its arrival. FramePresented(),
+// called right after the buffer swap, closes the measurement: the time from
+// the oldest input applied in that frame to its presentation is the input
+// to photon latency (up to the display's scan-out).
+enum EInputEventType
+{
+    INPUT_KEY,
+    INPUT_MOUSE_BUTTON
+};
+
+struct SInputEvent
+{
+    EInputEventType type;
+    // glfwGetTime() when the callback ran
+    double time;
+    // GLFW key or mouse button
+    int code;
+    int scancode;
+    int action;
+    int mods;
+};
+
+class CInputQueue
+{
+public:
+    // discrete events that fit between two frames; more are dropped
+    static const size_t CAPACITY = 256;
+
+    CInputQueue()
+        : m_head(0), m_tail(0), m_dropped(0), m_cursor(0), m_cursorTime(0), m_scroll(0), m_scrollTime(0),
+          m_oldestApplied(-1.0), m_latencySum(0.0), m_latencyMax(0.0), m_latencySamples(0)
+    {
+    }
+
+    // -- producer side, from the GLFW callbacks --
+
+    bool PushKey(int a_key, int a_scancode, int a_action, int a_mods, double a_time)
+    {
+        SInputEvent l_event = {INPUT_KEY, a_time, a_key, a_scancode, a_action, a_mods};
+        return p_Push(l_event);
+    }
+
+    bool PushMouseButton(int a_button, int a_action, int a_mods, double a_time)
+    {
+        SInputEvent l_event = {INPUT_MOUSE_BUTTON, a_time, a_button, 0, a_action, a_mods};
+        return p_Push(l_event);
+    }
+
+    // replaces any position the consumer has not taken yet
+    void PushCursor(double a_x, double a_y, double a_time)
+    {
+        m_cursor.store(p_Pack((float)a_x, (float)a_y), std::memory_order_relaxed);
+        p_KeepOldest(m_cursorTime, a_time);
+    }
+
+    // adds to the scrolling the consumer has not taken yet
+    void PushScroll(double a_x, double a_y, double a_time)
+    {
+        uint64_t l_old = m_scroll.load(std::memory_order_relaxed);
+        float l_x, l_y;
+        do
+        {
+            p_Unpack(l_old, &l_x, &l_y);
+        } while (!m_scroll.compare_exchange_weak(l_old, p_Pack(l_x + (float)a_x, l_y + (float)a_y)));
+        p_KeepOldest(m_scrollTime, a_time);
+    }
+
+    // -- consumer side, once per frame --
+
+    // next discrete event in arrival order
+    bool Pop(SInputEvent* a_event)
+    {
+        const size_t l_head = m_head.load(std::memory_order_relaxed);
+        if (l_head == m_tail.load(std::memory_order_acquire))
+            return false;
+        *a_event = m_events[l_head % CAPACITY];
+        m_head.store(l_head + 1, std::memory_order_release);
+        p_Applied(a_event->time);
+        return true;
+    }
+
+    // latest cursor position, if it moved since the last call
+    bool TakeCursor(double* a_x, double* a_y)
+    {
+        const uint64_t l_time = m_cursorTime.exchange(0);
+        if (l_time == 0)
+            return false;
+        float l_x, l_y;
+        p_Unpack(m_cursor.load(std::memory_order_relaxed), &l_x, &l_y);
+        *a_x = l_x;
+        *a_y = l_y;
+        p_Applied(p_Seconds(l_time));
+        return true;
+    }
+
+    // scrolling accumulated since the last call
+    bool TakeScroll(double* a_x, double* a_y)
+    {
+        const uint64_t l_time = m_scrollTime.exchange(0);
+        if (l_time == 0)
+            return false;
+        float l_x, l_y;
+        p_Unpack(m_scroll.exchange(p_Pack(0.0f, 0.0f)), &l_x, &l_y);
+        *a_x = l_x;
+        *a_y = l_y;
+        p_Applied(p_Seconds(l_time));
+        return true;
+    }
+
+    // true when a call above would return something
+    bool HasPending() const
+    {
+        return m_head.load(std::memory_order_relaxed) != m_tail.load(std::memory_order_acquire) ||
+               m_cursorTime.load(std::memory_order_relaxed) != 0 || m_scrollTime.load(std::memory_order_relaxed) != 0;
+    }
+
+    // after the swap of a frame that applied input, a_time from glfwGetTime()
+    void FramePresented(double a_time)
+    {
+        if (m_oldestApplied < 0.0)
+            return;
+        const double l_latency = a_time - m_oldestApplied;
+        m_latencySum += l_latency;
+        if (l_latency > m_latencyMax)
+            m_latencyMax = l_latency;
+        ++m_latencySamples;
+        m_oldestApplied = -1.0;
+    }
+
+    // over every frame that applied input, in seconds
+    double MeanLatency() const { return m_latencySamples ? m_latencySum / m_latencySamples : 0.0; }
+    double MaxLatency() const { return m_latencyMax; }
+    uint64_t LatencySamples() const { return m_latencySamples; }
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    SInputEvent m_events[CAPACITY];
+    // the consumer owns m_head, the producer m_tail; both only grow
+    std::atomic<size_t> m_head;
+    std::atomic<size_t> m_tail;
+    std::atomic<uint64_t> m_dropped;
+    // two floats, and the arrival of the oldest input not taken yet in
+    // microseconds (+1, 0 means nothing pending)
+    std::atomic<uint64_t> m_cursor;
+    std::atomic<uint64_t> m_cursorTime;
+    std::atomic<uint64_t> m_scroll;
+    std::atomic<uint64_t> m_scrollTime;
+    // consumer only
+    double m_oldestApplied;
+    double m_latencySum;
+    double m_latencyMax;
+    uint64_t m_latencySamples;
+
+    bool p_Push(const SInputEvent& a_event)
+    {
+        const size_t l_tail = m_tail.load(std::memory_order_relaxed);
+        if (l_tail - m_head.load(std::memory_order_acquire) >= CAPACITY)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_events[l_tail % CAPACITY] = a_event;
+        m_tail.store(l_tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    static uint64_t p_Pack(float a_x, float a_y)
+    {
+        uint32_t l_x, l_y;
+        memcpy(&l_x, &a_x, sizeof(l_x));
+        memcpy(&l_y, &a_y, sizeof(l_y));
+        return ((uint64_t)l_x << 32) | l_y;
+    }
+
+    static void p_Unpack(uint64_t a_packed, float* a_x, float* a_y)
+    {
+        const uint32_t l_x = (uint32_t)(a_packed >> 32);
+        const uint32_t l_y = (uint32_t)a_packed;
+        memcpy(a_x, &l_x, sizeof(l_x));
+        memcpy(a_y, &l_y, sizeof(l_y));
+    }
+
+    static double p_Seconds(uint64_t a_stamp) { return (a_stamp - 1) * 1e-6; }
+
+    // the first input after a take sets the time, later ones keep it
+    static void p_KeepOldest(std::atomic<uint64_t>& a_stamp, double a_time)
+    {
+        uint64_t l_empty = 0;
+        a_stamp.compare_exchange_strong(l_empty, (uint64_t)(a_time * 1e6) + 1);
+    }
+
+    void p_Applied(double a_time)
+    {
+        if (m_oldestApplied < 0.0 || a_time < m_oldestApplied)
+            m_oldestApplied = a_time;
+    }
+};
+
+#endif
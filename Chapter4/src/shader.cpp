@@ -1,26 +1,176 @@
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <algorithm>
 #include <vector>
+#include <map>
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 #include "common/shader.hpp"
 
-std::string ReadSourceFile(const char* a_path)
+// linked programs are kept in this directory across runs, one file per
+// program; empty disables the cache
+static std::string g_programCacheDirectory = "shader_cache";
+static const char PROGRAM_CACHE_MAGIC[4] = {'G', 'L', 'P', 'B'};
+// compiled shader objects by stage and preprocessed source, that is by file
+// and defines, kept for every program linked from the same variant
+static std::map<std::string, GLuint> g_shaderVariants;
+
+// splits a_path into its directory and file name
+static void SplitPath(const std::string& a_path, std::string* a_directory, std::string* a_name)
 {
-    std::string l_code;
-    std::ifstream l_fileStream(a_path, std::ios::in);
-    if (l_fileStream.is_open())
+    const size_t l_slash = a_path.find_last_of('/');
+    if (l_slash == std::string::npos)
     {
-        std::string l_line = "";
-        while(getline(l_fileStream, l_line))
-            l_code += "\n" + l_line;
-        l_fileStream.close();
-        return l_code;
+        *a_directory = ".";
+        *a_name = a_path;
     }
     else
     {
-        printf("Failed to open \"%s\".\n", a_path);
+        *a_directory = l_slash ? a_path.substr(0, l_slash) : "/";
+        *a_name = a_path.substr(l_slash + 1);
+    }
+}
+
+// GLSL before 3.30 numbers the line after "#line n" as n + 1
+static std::string LineDirective(int a_line, size_t a_file, int a_version)
+{
+    char l_directive[64];
+    snprintf(l_directive, sizeof(l_directive), "#line %d %d\n", a_version < 330 ? a_line - 1 : a_line, (int)a_file);
+    return l_directive;
+}
+
+// the argument of a "#<a_directive> ..." line, without surrounding blanks
+static bool ParseDirective(const std::string& a_line, const char* a_directive, std::string* a_argument)
+{
+    size_t l_position = a_line.find_first_not_of(" \t");
+    if (l_position == std::string::npos || a_line[l_position] != '#')
+    {
+        return false;
+    }
+    l_position = a_line.find_first_not_of(" \t", l_position + 1);
+    const size_t l_length = strlen(a_directive);
+    if (l_position == std::string::npos || a_line.compare(l_position, l_length, a_directive) != 0)
+    {
+        return false;
+    }
+    l_position = a_line.find_first_not_of(" \t", l_position + l_length);
+    const size_t l_end = a_line.find_last_not_of(" \t\r");
+    *a_argument = l_position == std::string::npos ? "" : a_line.substr(l_position, l_end - l_position + 1);
+    return true;
+}
+
+// "NAME value" per line of a_defines as #define lines
+static std::string DefineLines(const char* a_defines)
+{
+    std::string l_lines;
+    const std::string l_defines(a_defines);
+    size_t l_begin = 0;
+    while (l_begin < l_defines.size())
+    {
+        size_t l_end = l_defines.find('\n', l_begin);
+        if (l_end == std::string::npos)
+        {
+            l_end = l_defines.size();
+        }
+        if (l_end > l_begin)
+        {
+            l_lines += "#define " + l_defines.substr(l_begin, l_end - l_begin) + "\n";
+        }
+        l_begin = l_end + 1;
+    }
+    return l_lines;
+}
+
+// appends a_path to a_code, with every #include "file" replaced by the file
+// itself; a_files[a_first..] are the files of this shader so far, the
+// index of each is its source string number in #line and error messages
+static bool IncludeFile(const std::string& a_path, const char*& a_defines, std::vector<std::string>& a_files,
+                        size_t a_first, int& a_version, std::string& a_code)
+{
+    std::ifstream l_fileStream(a_path.c_str(), std::ios::in);
+    if (!l_fileStream.is_open())
+    {
+        printf("Failed to open \"%s\".\n", a_path.c_str());
+        return false;
+    }
+    const size_t l_fileIndex = a_files.size() - a_first;
+    a_files.push_back(a_path);
+    std::string l_directory, l_name;
+    SplitPath(a_path, &l_directory, &l_name);
+
+    std::string l_line = "";
+    std::string l_argument;
+    int l_lineNumber = 0;
+    while(getline(l_fileStream, l_line))
+    {
+        ++l_lineNumber;
+        if (ParseDirective(l_line, "include", &l_argument))
+        {
+            if (l_argument.size() < 2 || l_argument[0] != '"' || l_argument[l_argument.size() - 1] != '"')
+            {
+                printf("%s:%d: expected #include \"file\"\n", a_path.c_str(), l_lineNumber);
+                return false;
+            }
+            l_argument = l_argument.substr(1, l_argument.size() - 2);
+            const std::string l_includePath = l_argument[0] == '/' ? l_argument : l_directory + "/" + l_argument;
+            // once per shader, so included files need no guards
+            if (std::find(a_files.begin() + a_first, a_files.end(), l_includePath) == a_files.end())
+            {
+                const char* l_noDefines = NULL;
+                a_code += LineDirective(1, a_files.size() - a_first, a_version);
+                if (!IncludeFile(l_includePath, l_noDefines, a_files, a_first, a_version, a_code))
+                {
+                    return false;
+                }
+            }
+            a_code += LineDirective(l_lineNumber + 1, l_fileIndex, a_version);
+            continue;
+        }
+
+        a_code += l_line + "\n";
+        // nothing but comments may come before #version, so the defines
+        // follow it
+        if (ParseDirective(l_line, "version", &l_argument))
+        {
+            a_version = atoi(l_argument.c_str());
+            if (a_defines)
+            {
+                a_code += DefineLines(a_defines) + LineDirective(l_lineNumber + 1, l_fileIndex, a_version);
+                a_defines = NULL;
+            }
+        }
+    }
+    return true;
+}
+
+std::string ReadSourceFile(const char* a_path, const char* a_defines, std::vector<std::string>* a_files)
+{
+    std::vector<std::string> l_files;
+    std::vector<std::string>& l_fileList = a_files ? *a_files : l_files;
+    // GLSL 1.10 until a #version says otherwise
+    int l_version = 110;
+    const char* l_defines = a_defines && *a_defines ? a_defines : NULL;
+    std::string l_code;
+    if (!IncludeFile(a_path, l_defines, l_fileList, l_fileList.size(), l_version, l_code))
+    {
         return "";
     }
+    // without a #version the defines go first
+    if (l_defines)
+    {
+        l_code = DefineLines(l_defines) + LineDirective(1, 0, l_version) + l_code;
+    }
+    return l_code;
 }
 
 bool CompileShader(const std::string& a_programCode, const GLuint a_shaderId)
@@ -45,33 +195,207 @@ bool CompileShader(const std::string& a_programCode, const GLuint a_shaderId)
     return true;
 }
 
-GLuint LoadShaders(const char* a_vertexShaderPath, const char* a_fragmentShaderPath)
+static std::string ShaderVariantKey(GLenum a_type, const std::string& a_code)
+{
+    return (a_type == GL_VERTEX_SHADER ? "v" : "f") + a_code;
+}
+
+static GLuint FindShaderVariant(GLenum a_type, const std::string& a_code)
 {
-    GLuint l_vertexShaderId = glCreateShader(GL_VERTEX_SHADER);
-    GLuint l_fragmentShaderId = glCreateShader(GL_FRAGMENT_SHADER);
-    std::string l_vertexShaderCode = ReadSourceFile(a_vertexShaderPath);
+    std::map<std::string, GLuint>::const_iterator l_variant = g_shaderVariants.find(ShaderVariantKey(a_type, a_code));
+    return l_variant == g_shaderVariants.end() ? 0 : l_variant->second;
+}
+
+// compiles a variant the first time it is asked for; a shader that failed
+// to compile is not kept and has to be deleted by the caller
+static GLuint CompileShaderVariant(GLenum a_type, const std::string& a_code, const char* a_path)
+{
+    GLuint l_shaderId = FindShaderVariant(a_type, a_code);
+    if (l_shaderId)
+    {
+        return l_shaderId;
+    }
+    printf("Compiling %s shader %s\n", a_type == GL_VERTEX_SHADER ? "vertex" : "fragment", a_path);
+    l_shaderId = glCreateShader(a_type);
+    CompileShader(a_code, l_shaderId);
+    GLint l_result = GL_FALSE;
+    glGetShaderiv(l_shaderId, GL_COMPILE_STATUS, &l_result);
+    if (l_result == GL_TRUE)
+    {
+        g_shaderVariants[ShaderVariantKey(a_type, a_code)] = l_shaderId;
+    }
+    return l_shaderId;
+}
+
+void SetProgramCacheDirectory(const char* a_path)
+{
+    g_programCacheDirectory = a_path ? a_path : "";
+}
+
+static bool ProgramCacheEnabled()
+{
+    if (g_programCacheDirectory.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+    {
+        return false;
+    }
+    // drivers may support the calls without any binary format
+    GLint l_numFormats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &l_numFormats);
+    return l_numFormats > 0;
+}
+
+// everything a binary depends on: the driver and the sources
+static std::string ProgramCacheKey(const std::string& a_vertexShaderCode, const std::string& a_fragmentShaderCode)
+{
+    std::string l_key;
+    const GLenum l_names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION};
+    for (size_t i = 0; i < sizeof(l_names) / sizeof(l_names[0]); ++i)
+    {
+        const GLubyte* l_string = glGetString(l_names[i]);
+        if (l_string)
+        {
+            l_key += (const char*)l_string;
+        }
+        l_key += '\n';
+    }
+    l_key += a_vertexShaderCode;
+    l_key += '\0';
+    l_key += a_fragmentShaderCode;
+    return l_key;
+}
+
+// the file is named after a 64-bit FNV-1a hash of the key; the key itself is
+// stored in the file too, so a collision is a miss and never a wrong program
+static std::string ProgramCachePath(const std::string& a_key)
+{
+    uint64_t l_hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < a_key.size(); ++i)
+    {
+        l_hash = (l_hash ^ (unsigned char)a_key[i]) * 1099511628211ULL;
+    }
+    char l_name[32];
+    snprintf(l_name, sizeof(l_name), "/%016llx.bin", (unsigned long long)l_hash);
+    return g_programCacheDirectory + l_name;
+}
+
+// file layout: magic, key length, key, binary format, binary
+static GLuint LoadCachedProgram(const std::string& a_key, const std::string& a_path)
+{
+    std::ifstream l_file(a_path.c_str(), std::ios::in | std::ios::binary);
+    if (!l_file.is_open())
+    {
+        return 0;
+    }
+    std::vector<char> l_contents((std::istreambuf_iterator<char>(l_file)), std::istreambuf_iterator<char>());
+    const size_t l_keyOffset = sizeof(PROGRAM_CACHE_MAGIC) + sizeof(uint32_t);
+    if (l_contents.size() < l_keyOffset || memcmp(&l_contents[0], PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC)) != 0)
+    {
+        return 0;
+    }
+    uint32_t l_keyLength = 0;
+    memcpy(&l_keyLength, &l_contents[sizeof(PROGRAM_CACHE_MAGIC)], sizeof(l_keyLength));
+    const size_t l_binaryOffset = l_keyOffset + l_keyLength + sizeof(GLenum);
+    if (l_keyLength != a_key.size() || l_contents.size() <= l_binaryOffset ||
+        a_key.compare(0, a_key.size(), &l_contents[l_keyOffset], l_keyLength) != 0)
+    {
+        return 0;
+    }
+    GLenum l_format = 0;
+    memcpy(&l_format, &l_contents[l_keyOffset + l_keyLength], sizeof(l_format));
+
+    // a driver update or another GPU rejects the binary; compiling replaces it
+    GLuint l_programId = glCreateProgram();
+    glProgramBinary(l_programId, l_format, &l_contents[l_binaryOffset], (GLsizei)(l_contents.size() - l_binaryOffset));
+    GLint l_result = GL_FALSE;
+    glGetProgramiv(l_programId, GL_LINK_STATUS, &l_result);
+    if (l_result != GL_TRUE)
+    {
+        glDeleteProgram(l_programId);
+        // an unknown format is also GL_INVALID_ENUM, which must not be
+        // reported by the next glGetError() of the caller
+        while (glGetError() != GL_NO_ERROR)
+        {
+        }
+        return 0;
+    }
+    return l_programId;
+}
+
+static void StoreCachedProgram(GLuint a_programId, const std::string& a_key, const std::string& a_path)
+{
+    GLint l_length = 0;
+    glGetProgramiv(a_programId, GL_PROGRAM_BINARY_LENGTH, &l_length);
+    if (l_length <= 0)
+    {
+        return;
+    }
+    std::vector<char> l_binary(l_length);
+    GLenum l_format = 0;
+    glGetProgramBinary(a_programId, l_length, NULL, &l_format, &l_binary[0]);
+
+#ifdef _WIN32
+    if (_mkdir(g_programCacheDirectory.c_str()) != 0 && errno != EEXIST)
+#else
+    if (mkdir(g_programCacheDirectory.c_str(), 0755) != 0 && errno != EEXIST)
+#endif
+    {
+        return;
+    }
+    // written aside and renamed, so a crash never leaves half a binary
+    const std::string l_temporaryPath = a_path + ".tmp";
+    std::ofstream l_file(l_temporaryPath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    const uint32_t l_keyLength = (uint32_t)a_key.size();
+    l_file.write(PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+    l_file.write((const char*)&l_keyLength, sizeof(l_keyLength));
+    l_file.write(a_key.data(), a_key.size());
+    l_file.write((const char*)&l_format, sizeof(l_format));
+    l_file.write(&l_binary[0], l_binary.size());
+    l_file.close();
+    if (!l_file.good() || rename(l_temporaryPath.c_str(), a_path.c_str()) != 0)
+    {
+        remove(l_temporaryPath.c_str());
+    }
+}
+
+GLuint LoadShaders(const char* a_vertexShaderPath, const char* a_fragmentShaderPath, const char* a_defines)
+{
+    std::string l_vertexShaderCode = ReadSourceFile(a_vertexShaderPath, a_defines);
     if (l_vertexShaderCode.empty())
     {
         return 0;
     }
 
-    std::string l_fragmentShaderCode = ReadSourceFile(a_fragmentShaderPath);
+    std::string l_fragmentShaderCode = ReadSourceFile(a_fragmentShaderPath, a_defines);
     if (l_fragmentShaderCode.empty())
     {
         return 0;
     }
 
-    printf("Compiling vertex shader %s\n", a_vertexShaderPath);
-    CompileShader(l_vertexShaderCode, l_vertexShaderId);
+    // a program linked by an earlier run skips compiling and linking
+    std::string l_cacheKey, l_cachePath;
+    if (ProgramCacheEnabled())
+    {
+        l_cacheKey = ProgramCacheKey(l_vertexShaderCode, l_fragmentShaderCode);
+        l_cachePath = ProgramCachePath(l_cacheKey);
+        GLuint l_programId = LoadCachedProgram(l_cacheKey, l_cachePath);
+        if (l_programId)
+        {
+            return l_programId;
+        }
+    }
 
-    printf("Compiling fragment shader %s\n", a_fragmentShaderPath);
-    CompileShader(l_fragmentShaderCode, l_fragmentShaderId);
+    GLuint l_vertexShaderId = CompileShaderVariant(GL_VERTEX_SHADER, l_vertexShaderCode, a_vertexShaderPath);
+    GLuint l_fragmentShaderId = CompileShaderVariant(GL_FRAGMENT_SHADER, l_fragmentShaderCode, a_fragmentShaderPath);
 
     GLint l_result = GL_FALSE;
     int l_infologLength(0);
     printf("Linking program...\n");
 
     GLuint l_programId = glCreateProgram();
+    if (!l_cacheKey.empty())
+    {
+        glProgramParameteri(l_programId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glAttachShader(l_programId, l_vertexShaderId);
     glAttachShader(l_programId, l_fragmentShaderId);
     glLinkProgram(l_programId);
@@ -89,10 +413,378 @@ GLuint LoadShaders(const char* a_vertexShaderPath, const char* a_fragmentShaderP
     {
         printf("Linked successfully\n");
     }
+    if (l_result == GL_TRUE && !l_cacheKey.empty())
+    {
+        StoreCachedProgram(l_programId, l_cacheKey, l_cachePath);
+    }
 
-    // flag for delete, and will free all memories
-    // when the attached program is deleted
-    glDeleteShader(l_vertexShaderId);
-    glDeleteShader(l_fragmentShaderId);
+    // the variants stay compiled for the next program that uses them, only
+    // the ones that failed are flagged for delete, and will free all
+    // memories when the attached program is deleted
+    if (!FindShaderVariant(GL_VERTEX_SHADER, l_vertexShaderCode))
+    {
+        glDeleteShader(l_vertexShaderId);
+    }
+    if (!FindShaderVariant(GL_FRAGMENT_SHADER, l_fragmentShaderCode))
+    {
+        glDeleteShader(l_fragmentShaderId);
+    }
     return l_programId;
 }
+
+// all zero for a missing file
+CShaderManager::SFileStamp CShaderManager::p_Stamp(const std::string& a_path)
+{
+    SFileStamp l_stamp = {0, 0, 0};
+    struct stat l_status;
+    if (stat(a_path.c_str(), &l_status) != 0)
+    {
+        return l_stamp;
+    }
+    l_stamp.seconds = l_status.st_mtime;
+#if defined(__APPLE__)
+    l_stamp.nanoseconds = l_status.st_mtimespec.tv_nsec;
+#elif !defined(_WIN32)
+    l_stamp.nanoseconds = l_status.st_mtim.tv_nsec;
+#endif
+    l_stamp.size = l_status.st_size;
+    return l_stamp;
+}
+
+static void PrintShaderLog(GLuint a_shaderId, const std::string& a_path)
+{
+    if (!a_shaderId)
+    {
+        return;
+    }
+    GLint l_result = GL_FALSE;
+    int l_infologLength(0);
+    glGetShaderiv(a_shaderId, GL_COMPILE_STATUS, &l_result);
+    glGetShaderiv(a_shaderId, GL_INFO_LOG_LENGTH, &l_infologLength);
+    if (l_result != GL_TRUE && l_infologLength > 0)
+    {
+        std::vector<char> l_errMsg(l_infologLength+1);
+        glGetShaderInfoLog(a_shaderId, l_infologLength, NULL, &l_errMsg[0]);
+        printf("Error compiling shader %s error: `%s`\n", a_path.c_str(), &l_errMsg[0]);
+    }
+}
+
+CShaderManager::CShaderManager()
+{
+    m_initialized = false;
+    m_parallel = false;
+    m_swapped = false;
+    m_lastPoll = 0.0;
+#ifdef __linux__
+    m_notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+    m_notify = -1;
+#endif
+}
+
+CShaderManager::~CShaderManager()
+{
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        p_Abandon(m_entries[i]);
+        glDeleteProgram(m_entries[i].program);
+    }
+#ifdef __linux__
+    if (m_notify >= 0)
+    {
+        close(m_notify);
+    }
+#endif
+}
+
+size_t CShaderManager::Add(const char* a_vertexShaderPath, const char* a_fragmentShaderPath, const char* a_defines)
+{
+    // GLEW is only initialized once a context exists, possibly after the
+    // manager was constructed
+    if (!m_initialized)
+    {
+        m_initialized = true;
+        m_parallel = GLEW_KHR_parallel_shader_compile;
+        if (m_parallel)
+        {
+            // as many compiler threads as the implementation likes
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        }
+    }
+
+    SEntry l_entry;
+    l_entry.shaders[0] = a_vertexShaderPath;
+    l_entry.shaders[1] = a_fragmentShaderPath;
+    l_entry.defines = a_defines ? a_defines : "";
+    // watched before the first read, so a file that is missing now is
+    // compiled as soon as it appears
+    for (int i = 0; i < 2; ++i)
+    {
+        l_entry.files.push_back(l_entry.shaders[i]);
+        l_entry.modified.push_back(p_Stamp(l_entry.shaders[i]));
+        p_Watch(l_entry.shaders[i]);
+    }
+    l_entry.program = 0;
+    l_entry.pending = 0;
+    l_entry.pendingShaders[0] = l_entry.pendingShaders[1] = 0;
+    l_entry.startTime = 0.0;
+    l_entry.reload = false;
+    m_entries.push_back(l_entry);
+    p_Start(m_entries.back());
+    return m_entries.size() - 1;
+}
+
+bool CShaderManager::Update()
+{
+    p_CheckFiles();
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        SEntry& l_entry = m_entries[i];
+        if (l_entry.reload)
+        {
+            l_entry.reload = false;
+            printf("Reloading %s + %s\n", l_entry.shaders[0].c_str(), l_entry.shaders[1].c_str());
+            p_Start(l_entry);
+        }
+        else
+        {
+            p_Finish(l_entry);
+        }
+    }
+    const bool l_swapped = m_swapped;
+    m_swapped = false;
+    return l_swapped;
+}
+
+GLuint CShaderManager::Program(size_t a_handle) const
+{
+    return a_handle < m_entries.size() ? m_entries[a_handle].program : 0;
+}
+
+// issues the compile and link without asking for any result, which is what
+// lets the driver run them in the background; true when the program could be
+// swapped in right away from the binary cache
+bool CShaderManager::p_Start(SEntry& a_entry)
+{
+    p_Abandon(a_entry);
+    a_entry.startTime = glfwGetTime();
+
+    // an editor may still be writing the file; its next write reloads again
+    std::vector<std::string> l_files;
+    std::string l_vertexShaderCode = ReadSourceFile(a_entry.shaders[0].c_str(), a_entry.defines.c_str(), &l_files);
+    std::string l_fragmentShaderCode = ReadSourceFile(a_entry.shaders[1].c_str(), a_entry.defines.c_str(), &l_files);
+
+    // includes are watched too, from the first time they were read
+    for (size_t i = 0; i < l_files.size(); ++i)
+    {
+        if (std::find(a_entry.files.begin(), a_entry.files.end(), l_files[i]) == a_entry.files.end())
+        {
+            a_entry.files.push_back(l_files[i]);
+            a_entry.modified.push_back(p_Stamp(l_files[i]));
+            p_Watch(l_files[i]);
+        }
+    }
+    if (l_vertexShaderCode.empty() || l_fragmentShaderCode.empty())
+    {
+        return false;
+    }
+
+    a_entry.cacheKey.clear();
+    if (ProgramCacheEnabled())
+    {
+        a_entry.cacheKey = ProgramCacheKey(l_vertexShaderCode, l_fragmentShaderCode);
+        GLuint l_programId = LoadCachedProgram(a_entry.cacheKey, ProgramCachePath(a_entry.cacheKey));
+        if (l_programId)
+        {
+            p_Swap(a_entry, l_programId);
+            return true;
+        }
+    }
+
+    const std::string* l_codes[2] = {&l_vertexShaderCode, &l_fragmentShaderCode};
+    const GLenum l_types[2] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER};
+    a_entry.pending = glCreateProgram();
+    if (!a_entry.cacheKey.empty())
+    {
+        glProgramParameteri(a_entry.pending, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        // a variant LoadShaders already compiled is reused; reloads are
+        // not added to the variants, every edit would stay compiled
+        const GLuint l_variant = FindShaderVariant(l_types[i], *l_codes[i]);
+        if (l_variant)
+        {
+            glAttachShader(a_entry.pending, l_variant);
+            continue;
+        }
+        char const * l_programCodePtr = l_codes[i]->c_str();
+        a_entry.pendingShaders[i] = glCreateShader(l_types[i]);
+        glShaderSource(a_entry.pendingShaders[i], 1, &l_programCodePtr, NULL);
+        glCompileShader(a_entry.pendingShaders[i]);
+        glAttachShader(a_entry.pending, a_entry.pendingShaders[i]);
+    }
+    glLinkProgram(a_entry.pending);
+    return false;
+}
+
+// true when the compile in flight linked and replaced the program
+bool CShaderManager::p_Finish(SEntry& a_entry)
+{
+    if (!a_entry.pending)
+    {
+        return false;
+    }
+    // the only query that does not wait for the compiler
+    if (m_parallel)
+    {
+        GLint l_completed = GL_FALSE;
+        glGetProgramiv(a_entry.pending, GL_COMPLETION_STATUS_KHR, &l_completed);
+        if (l_completed != GL_TRUE)
+        {
+            return false;
+        }
+    }
+
+    GLint l_result = GL_FALSE;
+    glGetProgramiv(a_entry.pending, GL_LINK_STATUS, &l_result);
+    if (l_result != GL_TRUE)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            PrintShaderLog(a_entry.pendingShaders[i], a_entry.shaders[i]);
+        }
+        int l_infologLength(0);
+        glGetProgramiv(a_entry.pending, GL_INFO_LOG_LENGTH, &l_infologLength);
+        if (l_infologLength > 0)
+        {
+            std::vector<char> l_errMsg(l_infologLength+1);
+            glGetProgramInfoLog(a_entry.pending, l_infologLength, NULL, &l_errMsg[0]);
+            printf("Error linking shaders error: `%s`\n", &l_errMsg[0]);
+        }
+        printf("Keeping the previous program for %s + %s\n", a_entry.shaders[0].c_str(), a_entry.shaders[1].c_str());
+        p_Abandon(a_entry);
+        return false;
+    }
+
+    printf("Linked %s + %s in %.1f ms\n", a_entry.shaders[0].c_str(), a_entry.shaders[1].c_str(),
+           (glfwGetTime() - a_entry.startTime) * 1000.0);
+    if (!a_entry.cacheKey.empty())
+    {
+        StoreCachedProgram(a_entry.pending, a_entry.cacheKey, ProgramCachePath(a_entry.cacheKey));
+    }
+    const GLuint l_programId = a_entry.pending;
+    glDeleteShader(a_entry.pendingShaders[0]);
+    glDeleteShader(a_entry.pendingShaders[1]);
+    a_entry.pending = 0;
+    a_entry.pendingShaders[0] = a_entry.pendingShaders[1] = 0;
+    p_Swap(a_entry, l_programId);
+    return true;
+}
+
+void CShaderManager::p_Abandon(SEntry& a_entry)
+{
+    if (a_entry.pending)
+    {
+        glDeleteProgram(a_entry.pending);
+        glDeleteShader(a_entry.pendingShaders[0]);
+        glDeleteShader(a_entry.pendingShaders[1]);
+        a_entry.pending = 0;
+        a_entry.pendingShaders[0] = a_entry.pendingShaders[1] = 0;
+    }
+}
+
+void CShaderManager::p_Swap(SEntry& a_entry, GLuint a_programId)
+{
+    // still in use by the frame being drawn, GL frees it afterwards
+    glDeleteProgram(a_entry.program);
+    a_entry.program = a_programId;
+    m_swapped = true;
+}
+
+// editors save by writing a new file and renaming it over the old one, so
+// the directory is watched rather than the file
+void CShaderManager::p_Watch(const std::string& a_path)
+{
+#ifdef __linux__
+    if (m_notify < 0)
+    {
+        return;
+    }
+    std::string l_directory, l_name;
+    SplitPath(a_path, &l_directory, &l_name);
+    if (std::find(m_watchedDirectories.begin(), m_watchedDirectories.end(), l_directory) != m_watchedDirectories.end())
+    {
+        return;
+    }
+    const int l_watch = inotify_add_watch(m_notify, l_directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (l_watch >= 0)
+    {
+        m_watches.push_back(l_watch);
+        m_watchedDirectories.push_back(l_directory);
+    }
+#else
+    (void)a_path;
+#endif
+}
+
+void CShaderManager::p_CheckFiles()
+{
+#ifdef __linux__
+    if (m_notify >= 0)
+    {
+        char l_buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t l_length;
+        while ((l_length = read(m_notify, l_buffer, sizeof(l_buffer))) > 0)
+        {
+            for (char* l_event = l_buffer; l_event < l_buffer + l_length;
+                 l_event += sizeof(struct inotify_event) + ((struct inotify_event*)l_event)->len)
+            {
+                const struct inotify_event* l_notification = (const struct inotify_event*)l_event;
+                if (!l_notification->len)
+                {
+                    continue;
+                }
+                // two spellings of a directory ("a/../b" and "b") share one
+                // watch descriptor, so files are matched through it
+                for (size_t i = 0; i < m_entries.size(); ++i)
+                {
+                    for (size_t j = 0; j < m_entries[i].files.size(); ++j)
+                    {
+                        std::string l_directory, l_name;
+                        SplitPath(m_entries[i].files[j], &l_directory, &l_name);
+                        const size_t l_watch = std::find(m_watchedDirectories.begin(), m_watchedDirectories.end(),
+                                                         l_directory) - m_watchedDirectories.begin();
+                        if (l_name == l_notification->name && l_watch < m_watches.size() &&
+                            m_watches[l_watch] == l_notification->wd)
+                        {
+                            m_entries[i].reload = true;
+                        }
+                    }
+                }
+            }
+        }
+        return;
+    }
+#endif
+    const double l_currentTime = glfwGetTime();
+    if (l_currentTime - m_lastPoll < 0.5)
+    {
+        return;
+    }
+    m_lastPoll = l_currentTime;
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        for (size_t j = 0; j < m_entries[i].files.size(); ++j)
+        {
+            const SFileStamp l_modified = p_Stamp(m_entries[i].files[j]);
+            const SFileStamp& l_last = m_entries[i].modified[j];
+            if (l_modified.seconds != l_last.seconds || l_modified.nanoseconds != l_last.nanoseconds ||
+                l_modified.size != l_last.size)
+            {
+                m_entries[i].modified[j] = l_modified;
+                m_entries[i].reload = true;
+            }
+        }
+    }
+}
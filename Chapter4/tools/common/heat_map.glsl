@@ -0,0 +1,41 @@
+// heat map generator, included by the shaders that colour values by
+// magnitude: vmin is blue, then cyan, green, yellow, and vmax is red;
+// v is clamped to [vmin, vmax]
+vec3 heatMap(float v, float vmin, float vmax)
+{
+    float dv;
+    float r = 1.0f, g = 1.0f, b = 1.0f;
+    if (v < vmin)
+    {
+        v = vmin;
+    }
+
+    if (v > vmax)
+    {
+        v = vmax;
+    }
+
+    dv = vmax - vmin;
+
+    if (v < (vmin + 0.25f * dv))
+    {
+        r = 0.0f;
+        g = 4.0f * (v - vmin) / dv;
+    }
+    else if (v < (vmin + 0.5f * dv))
+    {
+        r = 0.0f;
+        b = 1.0f + 4.0f * (vmin + 0.25f * dv - v) / dv;
+    }
+    else if (v < (vmin + 0.75f * dv))
+    {
+        r = 4.0f * (v - vmin - 0.5f * dv) / dv;
+        b = 0.0f;
+    }
+    else
+    {
+        g = 1.0f + 4.0f * (vmin + 0.75f * dv - v) / dv;
+        b = 0.0f;
+    }
+    return vec3(r, g, b);
+}
@@ -0,0 +1,182 @@
+// Startup time of the shader programs of the tools with an empty (cold) and
+// a filled (warm) program cache.
+//
+//   cd build && ./shader_cache_bench [rounds]
+//
+// Every round is a fresh process, like launching a tool: it opens a hidden
+// window, loads the programs with LoadShaders() and waits for the driver
+// with glFinish(). Cold rounds delete the cached binaries first, warm rounds
+// reuse the ones the round before wrote. The driver's own shader disk cache
+// would make the cold rounds warm as well, so the Mesa and NVIDIA ones are
+// switched off. The mean, fastest and slowest startup of both are printed.
+#include "common/shader.hpp"
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define BENCH_CACHE_DIRECTORY "shader_cache_bench"
+
+// vertex shader, fragment shader and defines of every program
+static const char* const g_programs[][3] = {
+    {"../tools/simple/simple.vert", "../tools/simple/simple.frag", NULL},
+    {"../tools/texture_mapping/texture.vert", "../tools/texture_mapping/texture.frag", NULL},
+    {"../tools/texture_mapping/texture.vert", "../tools/video_processing/texture_sobel.frag",
+     "SOBEL_SIZE 3\nCOLOR_MAP GRAY_LEVEL\n"},
+    {"../tools/texture_mapping/texture.vert", "../tools/video_processing/texture_sobel.frag",
+     "SOBEL_SIZE 5\nCOLOR_MAP HEAT_MAP\n"},
+};
+
+static void ClearCache()
+{
+    DIR* l_directory = opendir(BENCH_CACHE_DIRECTORY);
+    if (!l_directory)
+    {
+        return;
+    }
+    while (struct dirent* l_entry = readdir(l_directory))
+    {
+        if (l_entry->d_name[0] != '.')
+        {
+            remove((std::string(BENCH_CACHE_DIRECTORY "/") + l_entry->d_name).c_str());
+        }
+    }
+    closedir(l_directory);
+}
+
+// what a tool does until its first frame could be drawn, in ms; -1 if the
+// context or a program failed
+static double Startup()
+{
+    const double l_startTime = glfwGetTime();
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    GLFWwindow* l_window = glfwCreateWindow(64, 64, "Chapter 4 - shader cache", NULL, NULL);
+    if (!l_window)
+    {
+        return -1.0;
+    }
+    glfwMakeContextCurrent(l_window);
+    glewExperimental = true; // Needed for core profile
+    if (glewInit() != GLEW_OK)
+    {
+        return -1.0;
+    }
+    const double l_contextTime = glfwGetTime();
+
+    SetProgramCacheDirectory(BENCH_CACHE_DIRECTORY);
+    for (size_t i = 0; i < sizeof(g_programs) / sizeof(g_programs[0]); ++i)
+    {
+        GLint l_result = GL_FALSE;
+        GLuint l_programId = LoadShaders(g_programs[i][0], g_programs[i][1], g_programs[i][2]);
+        glGetProgramiv(l_programId, GL_LINK_STATUS, &l_result);
+        if (l_result != GL_TRUE)
+        {
+            return -1.0;
+        }
+    }
+    glFinish();
+    const double l_endTime = glfwGetTime();
+    glfwDestroyWindow(l_window);
+    printf("  context %.1f ms, programs %.1f ms\n", (l_contextTime - l_startTime) * 1000.0,
+           (l_endTime - l_contextTime) * 1000.0);
+    return (l_endTime - l_contextTime) * 1000.0;
+}
+
+// runs Startup() in a child process, so nothing stays loaded between rounds
+static double StartupProcess()
+{
+    int l_pipe[2];
+    if (pipe(l_pipe) != 0)
+    {
+        return -1.0;
+    }
+    fflush(stdout);
+    const pid_t l_child = fork();
+    if (l_child == 0)
+    {
+        close(l_pipe[0]);
+        double l_milliseconds = -1.0;
+        if (glfwInit())
+        {
+            l_milliseconds = Startup();
+            glfwTerminate();
+        }
+        fflush(stdout);
+        const ssize_t l_written = write(l_pipe[1], &l_milliseconds, sizeof(l_milliseconds));
+        _exit(l_written == sizeof(l_milliseconds) ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    close(l_pipe[1]);
+    double l_milliseconds = -1.0;
+    if (l_child < 0 || read(l_pipe[0], &l_milliseconds, sizeof(l_milliseconds)) != sizeof(l_milliseconds))
+    {
+        l_milliseconds = -1.0;
+    }
+    close(l_pipe[0]);
+    if (l_child > 0)
+    {
+        waitpid(l_child, NULL, 0);
+    }
+    return l_milliseconds;
+}
+
+int main(int argc, char const *argv[])
+{
+    const int l_rounds = argc > 1 ? atoi(argv[1]) : 5;
+    if (l_rounds <= 0)
+    {
+        fprintf(stderr, "Usage: ./shader_cache_bench [rounds]\n");
+        exit(EXIT_FAILURE);
+    }
+    // the child processes inherit these before their driver is loaded
+    setenv("MESA_SHADER_CACHE_DISABLE", "true", 1);
+    setenv("__GL_SHADER_DISK_CACHE", "0", 1);
+
+    const char* l_modes[2] = {"cold", "warm"};
+    double l_mean[2] = {0.0, 0.0};
+    double l_min[2] = {0.0, 0.0};
+    double l_max[2] = {0.0, 0.0};
+    for (int l_mode = 0; l_mode < 2; ++l_mode)
+    {
+        // a warm round needs the binaries of a cold one before it
+        ClearCache();
+        if (l_mode == 1 && StartupProcess() < 0.0)
+        {
+            fprintf(stderr, "Failed to fill the program cache\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < l_rounds; ++i)
+        {
+            if (l_mode == 0)
+            {
+                ClearCache();
+            }
+            printf("%s round %d\n", l_modes[l_mode], i + 1);
+            const double l_milliseconds = StartupProcess();
+            if (l_milliseconds < 0.0)
+            {
+                fprintf(stderr, "Failed to create the context or to link a program\n");
+                exit(EXIT_FAILURE);
+            }
+            l_mean[l_mode] += l_milliseconds / l_rounds;
+            l_min[l_mode] = i == 0 || l_milliseconds < l_min[l_mode] ? l_milliseconds : l_min[l_mode];
+            l_max[l_mode] = i == 0 || l_milliseconds > l_max[l_mode] ? l_milliseconds : l_max[l_mode];
+        }
+    }
+    ClearCache();
+
+    printf("\n%zu programs, %d rounds each\n", sizeof(g_programs) / sizeof(g_programs[0]), l_rounds);
+    printf("%6s %10s %10s %10s\n", "cache", "mean ms", "min ms", "max ms");
+    for (int l_mode = 0; l_mode < 2; ++l_mode)
+    {
+        printf("%6s %10.1f %10.1f %10.1f\n", l_modes[l_mode], l_mean[l_mode], l_min[l_mode], l_max[l_mode]);
+    }
+    printf("warm startup is %.1fx faster\n", l_mean[1] > 0.0 ? l_mean[0] / l_mean[1] : 0.0);
+    return 0;
+}
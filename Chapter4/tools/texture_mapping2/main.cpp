@@ -54,8 +54,13 @@ static const GLfloat g_uvBufferObj2[] = {
     1.0f, 1.0f
 };
 
+// key events for the camera, applied once per frame
+CInputQueue g_input;
+
 static void KeyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_action, int a_mods)
 {
+    g_input.PushKey(a_key, a_scancode, a_action, a_mods, glfwGetTime());
+
     if (a_action != GLFW_PRESS && a_action != GLFW_REPEAT)
     {
         return;
@@ -286,6 +291,7 @@ int main(int argc, char const *argv[])
 
     // Create controls object to manage the view
     CControls l_controls;
+    l_controls.SetInputQueue(&g_input);
 
     // While the window is open
     while (!glfwWindowShouldClose(l_window) &&
@@ -330,9 +336,14 @@ int main(int argc, char const *argv[])
 
         // Swap the front and back buffers (GLFW uses double buffering) to update the screen and process all pending events:
         glfwSwapBuffers(l_window);
+        g_input.FramePresented(glfwGetTime());
         glfwPollEvents();
     }
 
+    printf("Input to present: %.1f ms mean, %.1f ms max over %llu frames\n",
+           g_input.MeanLatency() * 1000.0, g_input.MaxLatency() * 1000.0,
+           (unsigned long long)g_input.LatencySamples());
+
     // Release the memory and terminate the GLFW library.
     glDisableVertexAttribArray(l_attribVertex);
     glDisableVertexAttribArray(l_attribUV);
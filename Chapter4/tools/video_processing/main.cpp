@@ -36,8 +36,13 @@ static const GLfloat g_uvBufferData[] = {
     1.0f, 1.0f
 };
 
+// key events for the camera, applied once per frame
+CInputQueue g_input;
+
 static void KeyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_action, int a_mods)
 {
+    g_input.PushKey(a_key, a_scancode, a_action, a_mods, glfwGetTime());
+
     if (a_action != GLFW_PRESS && a_action != GLFW_REPEAT)
     {
         return;
@@ -71,9 +76,11 @@ static void KeyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_a
 
 int main(int argc, char const *argv[])
 {
-    if (argc < 2)
+    // the shader only has 3x3 and 5x5 kernels
+    const int l_sobelSize = argc > 2 ? atoi(argv[2]) : 3;
+    if (argc < 2 || (l_sobelSize != 3 && l_sobelSize != 5))
     {
-        fprintf(stderr, "Usage: ./texture_mapping <video.mov>\n");
+        fprintf(stderr, "Usage: ./video_processing <video.mov> [sobel size 3|5] [gray|heat]\n");
         exit(EXIT_FAILURE);
     }
 
@@ -121,11 +128,6 @@ int main(int argc, char const *argv[])
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
 
-    // Setup shader programs
-    // GLuint l_programId = LoadShaders("../tools/texture_mapping/texture.vert", "../tools/texture_mapping/texture.frag");
-    GLuint l_programId = LoadShaders("../tools/texture_mapping/texture.vert", "../tools/video_processing/texture_sobel.frag");
-
-
     std::string l_videoFilePath(argv[1]);
     cv::VideoCapture l_videoCapture(l_videoFilePath);
     cv::Mat l_frame;
@@ -154,7 +156,20 @@ int main(int argc, char const *argv[])
     // set aspect ratio to that of the image
     g_aspectRatio = (float)l_width/(float)l_height;
 
-    // Get the locations of the specific variables in the shader programs
+    // Setup shader programs, compiled in the background and reloaded
+    // whenever one of the files is saved while the video keeps playing.
+    // The video size, kernel and colour map are compiled into the filter.
+    char l_defines[256];
+    snprintf(l_defines, sizeof(l_defines), "TEXTURE_WIDTH %d\nTEXTURE_HEIGHT %d\nSOBEL_SIZE %d\nCOLOR_MAP %s\n",
+             l_width, l_height, l_sobelSize,
+             argc > 3 && std::string(argv[3]) == "heat" ? "HEAT_MAP" : "GRAY_LEVEL");
+    CShaderManager l_shaders;
+    // size_t l_shader = l_shaders.Add("../tools/texture_mapping/texture.vert", "../tools/texture_mapping/texture.frag");
+    size_t l_shader = l_shaders.Add("../tools/texture_mapping/texture.vert", "../tools/video_processing/texture_sobel.frag", l_defines);
+    GLuint l_programId = 0;
+
+    // The locations of the specific variables in the shader programs are
+    // looked up in the render loop, each time a program was (re)loaded
 
     // ** Uniform **
     // https://www.khronos.org/opengl/wiki/Type_Qualifier_(GLSL)#Storage_qualifier
@@ -163,15 +178,8 @@ int main(int argc, char const *argv[])
     // their value does not change between multiple executions of a
     // shader during the rendering of a primitive (ie: during a glDraw* call)
     // They are constant, but not compile-time constant (so not const).
-    GLuint l_matrixId = glGetUniformLocation(l_programId, "MVP"); // (this is in the vertex shader)
-
-    // Get a handler for our "textureSampler" uniform
-    GLuint l_textureSampleId = glGetUniformLocation(l_programId, "textureSampler"); // (this is in the fragment shader)
-
-    // Get the attribute ids for the variables for the vertex attributes (inputs to the vertex shader)
-    GLint l_attribVertex, l_attribUV;
-    l_attribVertex = glGetAttribLocation(l_programId, "vertexPosition_modelspace");
-    l_attribUV = glGetAttribLocation(l_programId, "vertexUV");
+    GLuint l_matrixId = 0;
+    GLint l_attribVertex = -1, l_attribUV = -1;
 
     // Define our Vertex Array Objects (VAO)
     GLuint l_vertexArrayId;
@@ -210,9 +218,6 @@ int main(int argc, char const *argv[])
     glBindBuffer(GL_ARRAY_BUFFER, l_uvBuffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(g_uvBufferData), g_uvBufferData, GL_STATIC_DRAW);
 
-    // Use the shader program
-    glUseProgram(l_programId);
-
     // Bind all texture units and attribute buffers
     // Read this for more info on texture binding....
     // http://bastiaanolij.blogspot.com/2016/01/glactivetexture.html
@@ -220,20 +225,10 @@ int main(int argc, char const *argv[])
     // binds our texture in Texture Unit 0
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, l_textureId);
-    glUniform1i(l_textureSampleId, 0);
-
-    // 1st attribute buffer: vertices for position
-    glEnableVertexAttribArray(l_attribVertex);
-    glBindBuffer(GL_ARRAY_BUFFER, l_vertexBuffer);
-    glVertexAttribPointer(l_attribVertex, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
-    // 2nd attribute buffer: UVs mapping
-    glEnableVertexAttribArray(l_attribUV);
-    glBindBuffer(GL_ARRAY_BUFFER, l_uvBuffer);
-    glVertexAttribPointer(l_attribUV, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
 
     // Create controls object to manage the view
     CControls l_controls;
+    l_controls.SetInputQueue(&g_input);
 
     // While the window is open
     while (!glfwWindowShouldClose(l_window) &&
@@ -253,6 +248,39 @@ int main(int argc, char const *argv[])
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
 
+        // switch to a program that finished compiling; locations can differ
+        // between two versions of the same shader
+        if (l_shaders.Update())
+        {
+            if (l_attribVertex >= 0)
+                glDisableVertexAttribArray(l_attribVertex);
+            if (l_attribUV >= 0)
+                glDisableVertexAttribArray(l_attribUV);
+
+            l_programId = l_shaders.Program(l_shader);
+            // Use the shader program
+            glUseProgram(l_programId);
+
+            // get the location for our "MVP" uniform variable (this is in the vertex shader)
+            l_matrixId = glGetUniformLocation(l_programId, "MVP");
+            // Get a handler for our "textureSampler" uniform (this is in the fragment shader)
+            glUniform1i(glGetUniformLocation(l_programId, "textureSampler"), 0);
+
+            // Get the attribute ids for the variables for the vertex attributes (inputs to the vertex shader)
+            l_attribVertex = glGetAttribLocation(l_programId, "vertexPosition_modelspace");
+            l_attribUV = glGetAttribLocation(l_programId, "vertexUV");
+
+            // 1st attribute buffer: vertices for position
+            glEnableVertexAttribArray(l_attribVertex);
+            glBindBuffer(GL_ARRAY_BUFFER, l_vertexBuffer);
+            glVertexAttribPointer(l_attribVertex, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+            // 2nd attribute buffer: UVs mapping
+            glEnableVertexAttribArray(l_attribUV);
+            glBindBuffer(GL_ARRAY_BUFFER, l_uvBuffer);
+            glVertexAttribPointer(l_attribUV, 2, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        }
+
         // Compute the transforms and store the information in the shader variables
         l_controls.ComputeMatricesFromWindow(l_window);
 
@@ -273,23 +301,31 @@ int main(int argc, char const *argv[])
         // send our transformation to the currently bound shader
         // in the "MVP" uniform variable
         // void glUniformMatrix4fv(	GLint location, GLsizei count, GLboolean transpose, const GLfloat *value);
-        glUniformMatrix4fv(l_matrixId, 1, GL_FALSE, &l_mvp[0][0]);
-
-        // Draw square
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        // Draw square, once the first program has linked
+        if (l_programId)
+        {
+            glUniformMatrix4fv(l_matrixId, 1, GL_FALSE, &l_mvp[0][0]);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        }
 
         // Swap the front and back buffers (GLFW uses double buffering) to update the screen and process all pending events:
         glfwSwapBuffers(l_window);
+        g_input.FramePresented(glfwGetTime());
         glfwPollEvents();
     }
 
+    printf("Input to present: %.1f ms mean, %.1f ms max over %llu frames\n",
+           g_input.MeanLatency() * 1000.0, g_input.MaxLatency() * 1000.0,
+           (unsigned long long)g_input.LatencySamples());
+
     // Release the memory and terminate the GLFW library.
-    glDisableVertexAttribArray(l_attribVertex);
-    glDisableVertexAttribArray(l_attribUV);
-    // Clean up VBO and shader program
+    if (l_attribVertex >= 0)
+        glDisableVertexAttribArray(l_attribVertex);
+    if (l_attribUV >= 0)
+        glDisableVertexAttribArray(l_attribUV);
+    // Clean up VBO, the shader programs are released with the context
     glDeleteBuffers(1, &l_vertexBuffer);
     glDeleteBuffers(1, &l_uvBuffer);
-    glDeleteProgram(l_programId);
     glDeleteTextures(1, &l_textureId);
     glDeleteVertexArrays(1, &l_vertexArrayId);
 
@@ -3,48 +3,41 @@ in vec2 UV;
 out vec4 color;
 uniform sampler2D textureSampler;
 
-vec4 heatMap(float v, float vmin, float vmax)
-{
-    float dv;
-    float r, g, b;
-    if (v < vmin)
-    {
-        v = vmin;
-    }
+#include "../common/heat_map.glsl"
 
-    if (v > vmax)
-    {
-        v = vmax;
-    }
+// Compile-time parameters, injected by LoadShaders / CShaderManager::Add;
+// every combination is its own variant without any runtime branch.
+// size of the video texture in pixels
+#ifndef TEXTURE_WIDTH
+#define TEXTURE_WIDTH 1280
+#endif
+#ifndef TEXTURE_HEIGHT
+#define TEXTURE_HEIGHT 720
+#endif
+// 3 or 5, the width of the Sobel kernel
+#ifndef SOBEL_SIZE
+#define SOBEL_SIZE 3
+#endif
+// GRAY_LEVEL or HEAT_MAP
+#define GRAY_LEVEL 0
+#define HEAT_MAP 1
+#ifndef COLOR_MAP
+#define COLOR_MAP GRAY_LEVEL
+#endif
 
-    dv = vmax - vmin;
-    if(v == 0)
-    {
-        return vec4(0.0, 0.0, 0.0, 1.0);
-    }
-
-    if (v < (vmin + 0.25f * dv))
-    {
-        r = 0.0f;
-        g = 4.0f * (v - vmin) / dv;
-    }
-    else if (v < (vmin + 0.5f * dv))
-    {
-        r = 0.0f;
-        b = 1.0f + 4.0f * (vmin + 0.25f * dv - v) / dv;
-    }
-    else if (v < (vmin + 0.75f * dv))
-    {
-        r = 4.0f * (v - vmin - 0.5f * dv) / dv;
-        b = 0.0f;
-    }
-    else
-    {
-        g = 1.0f + 4.0f * (vmin + 0.75f * dv - v) / dv;
-        b = 0.0f;
-    }
-    return vec4(r, g, b, 1.0);
-}
+// separable Sobel kernels: smoothing across, derivative along the gradient;
+// the 5x5 one is scaled to give the same response to a ramp as the 3x3 one
+#if SOBEL_SIZE == 5
+const int SOBEL_RADIUS = 2;
+const float SOBEL_SMOOTH[5] = float[5](1.0, 4.0, 6.0, 4.0, 1.0);
+const float SOBEL_DERIVATIVE[5] = float[5](1.0, 2.0, 0.0, -2.0, -1.0);
+const float SOBEL_SCALE = 1.0 / 16.0;
+#else
+const int SOBEL_RADIUS = 1;
+const float SOBEL_SMOOTH[3] = float[3](1.0, 2.0, 1.0);
+const float SOBEL_DERIVATIVE[3] = float[3](1.0, 0.0, -1.0);
+const float SOBEL_SCALE = 1.0;
+#endif
 
 float rgb2gray(vec3 color)
 {
@@ -58,19 +51,23 @@ float pixel_operator(float dx, float dy)
 
 float sobel_filter()
 {
-    float dx = 1.0 / float(1280);
-    float dy = 1.0 / float(720);
+    float dx = 1.0 / float(TEXTURE_WIDTH);
+    float dy = 1.0 / float(TEXTURE_HEIGHT);
 
-    float s00 = pixel_operator(-dx, dy);
-    float s10 = pixel_operator(-dx, 0);
-    float s20 = pixel_operator(-dx,-dy);
-    float s01 = pixel_operator(0.0,dy);
-    float s21 = pixel_operator(0.0, -dy);
-    float s02 = pixel_operator(dx, dy);
-    float s12 = pixel_operator(dx, 0.0);
-    float s22 = pixel_operator(dx, -dy);
-    float sx = s00 + 2 * s10 + s20 - (s02 + 2 * s12 + s22);
-    float sy = s00 + 2 * s01 + s02 - (s20 + 2 * s21 + s22);
+    // constant bounds, unrolled by the compiler
+    float sx = 0.0;
+    float sy = 0.0;
+    for (int i = -SOBEL_RADIUS; i <= SOBEL_RADIUS; ++i)
+    {
+        for (int j = -SOBEL_RADIUS; j <= SOBEL_RADIUS; ++j)
+        {
+            float s = pixel_operator(float(i) * dx, float(-j) * dy);
+            sx += SOBEL_DERIVATIVE[i + SOBEL_RADIUS] * SOBEL_SMOOTH[j + SOBEL_RADIUS] * s;
+            sy += SOBEL_SMOOTH[i + SOBEL_RADIUS] * SOBEL_DERIVATIVE[j + SOBEL_RADIUS] * s;
+        }
+    }
+    sx *= SOBEL_SCALE;
+    sy *= SOBEL_SCALE;
     float dist = sx * sx + sy * sy;
     return dist;
 }
@@ -78,6 +75,17 @@ float sobel_filter()
 void main()
 {
     float grayLevel = sobel_filter();
+#if COLOR_MAP == HEAT_MAP
+    // black where the magnitude clamped to the map range is 0
+    if (clamp(grayLevel, 0.1, 3.0) == 0.0)
+    {
+        color = vec4(0.0, 0.0, 0.0, 1.0);
+    }
+    else
+    {
+        color = vec4(heatMap(grayLevel, 0.1, 3.0), 1.0);
+    }
+#else
     color = vec4(grayLevel, grayLevel, grayLevel, 1.0);
-    // color = heatMap(grayLevel, 0.1, 3.0);
+#endif
 }
@@ -2,5 +2,96 @@
 #pragma once
 
 #include "common.h"
+#include <time.h>
+#include <vector>
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
+// Shader sources go through a small preprocessor: #include "file" is
+// replaced by the file, relative to the including one and once per shader,
+// and a_defines ("NAME value" per line) are injected as #define right after
+// #version. #line keeps error messages pointing into the right file, by its
+// index in a_files, which receives every file read. Includes are expanded
+// regardless of any #if around them.
+std::string ReadSourceFile(const char* a_path, const char* a_defines = NULL, std::vector<std::string>* a_files = NULL);
+// each distinct variant, a shader with its defines, is compiled once and
+// shared by every program linked from it
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path, const char* a_defines = NULL);
+// linked programs are cached as driver binaries in a_path ("shader_cache" by
+// default) and reused while the sources and the driver stay the same;
+// NULL or "" compiles every program from source
+void SetProgramCacheDirectory(const char* a_path);
+
+// Compiles and links programs without stalling the render loop, and reloads
+// them when their files change on disk. Add() and a file change only start
+// a compile; with KHR_parallel_shader_compile the driver runs it on its own
+// threads and Update() swaps the program in once the driver reports it
+// complete. Until then Program() keeps returning the last program that
+// linked, and a reload that fails keeps it for good, so editing a shader
+// while the tool runs never interrupts drawing. Without the extension a
+// compile is picked up one frame after it was started, which still blocks
+// on drivers that compile in the calling thread.
+//
+// Files are watched with inotify on Linux and by polling their modification
+// time and size twice a second elsewhere. The manager owns its programs;
+// destroy it while the context is still current.
+class CShaderManager
+{
+public:
+    CShaderManager();
+    ~CShaderManager();
+
+    // starts compiling a program, returns the handle for Program(); the
+    // files it includes are watched as well
+    size_t Add(const char* a_vertexShaderPath, const char* a_fragmentShaderPath, const char* a_defines = NULL);
+    // once per frame with the context current; true when a program changed
+    // since the last call, so its uniform and attribute locations have to be
+    // looked up again
+    bool Update();
+    // 0 until the first compile of a_handle has linked
+    GLuint Program(size_t a_handle) const;
+
+private:
+    // what polling compares; the size catches a save within the same second
+    // where the file system keeps no nanoseconds
+    struct SFileStamp
+    {
+        time_t seconds;
+        long nanoseconds;
+        long long size;
+    };
+    struct SEntry
+    {
+        // vertex and fragment shader
+        std::string shaders[2];
+        std::string defines;
+        // the shaders and everything they included
+        std::vector<std::string> files;
+        std::vector<SFileStamp> modified;
+        GLuint program;
+        // the compile in flight, 0 if none
+        GLuint pending;
+        GLuint pendingShaders[2];
+        std::string cacheKey;
+        double startTime;
+        bool reload;
+    };
+    std::vector<SEntry> m_entries;
+    bool m_initialized;
+    bool m_parallel;
+    bool m_swapped;
+    // inotify descriptor and one watch per directory, -1 when polling
+    int m_notify;
+    std::vector<int> m_watches;
+    std::vector<std::string> m_watchedDirectories;
+    double m_lastPoll;
+
+    CShaderManager(const CShaderManager&);
+    CShaderManager& operator=(const CShaderManager&);
+
+    bool p_Start(SEntry& a_entry);
+    bool p_Finish(SEntry& a_entry);
+    void p_Abandon(SEntry& a_entry);
+    void p_Swap(SEntry& a_entry, GLuint a_programId);
+    void p_Watch(const std::string& a_path);
+    void p_CheckFiles();
+    static SFileStamp p_Stamp(const std::string& a_path);
+};
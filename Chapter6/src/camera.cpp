@@ -1,6 +1,7 @@
 
 #include "camera.h"
 #include "glm/gtx/string_cast.hpp"
+#include <algorithm>
 #include <iostream>
 
 CCamera::CCamera()
@@ -9,6 +10,18 @@ CCamera::CCamera()
     m_speed = 3.0f; // 3 units / second
     m_initialFov = glm::pi<float>()*0.4f;
     m_lastTime = glfwGetTime();
+    m_input = NULL;
+    for (int i = 0; i <= GLFW_KEY_LAST; ++i)
+    {
+        m_keyDown[i] = false;
+        m_keyDownSince[i] = 0.0;
+        m_keyHeld[i] = 0.0;
+    }
+}
+
+void CCamera::SetInputQueue(CInputQueue* a_input)
+{
+    m_input = a_input;
 }
 
 glm::mat4 CCamera::GetViewMatrix()
@@ -25,7 +38,7 @@ void CCamera::ComputeMatricesFromWindow(GLFWwindow* a_window)
 {
     // compute time difference between last frame and this one
     double l_currentTime = glfwGetTime();
-    float l_deltaTime = float(l_currentTime - m_lastTime);
+    double l_frameStart = m_lastTime;
     m_lastTime = l_currentTime;
 
     // Window size
@@ -36,21 +49,27 @@ void CCamera::ComputeMatricesFromWindow(GLFWwindow* a_window)
     glm::vec3 l_direction(0, 0, -1);
     // up vector
     glm::vec3 l_up(0, -1, 0);
-    if (GLFW_PRESS == glfwGetKey(a_window, GLFW_KEY_UP))
+    // how long each key was down during this frame
+    p_ApplyInput(l_frameStart);
+    float l_upTime = p_HeldTime(a_window, GLFW_KEY_UP, l_frameStart, l_currentTime);
+    float l_downTime = p_HeldTime(a_window, GLFW_KEY_DOWN, l_frameStart, l_currentTime);
+    float l_rightTime = p_HeldTime(a_window, GLFW_KEY_RIGHT, l_frameStart, l_currentTime);
+    float l_leftTime = p_HeldTime(a_window, GLFW_KEY_LEFT, l_frameStart, l_currentTime);
+    if (l_upTime > 0.0f)
     {
-        m_position += l_direction * l_deltaTime * m_speed;
+        m_position += l_direction * l_upTime * m_speed;
     }
-    else if (GLFW_PRESS == glfwGetKey(a_window, GLFW_KEY_DOWN))
+    else if (l_downTime > 0.0f)
     {
-        m_position -= l_direction * l_deltaTime * m_speed;
+        m_position -= l_direction * l_downTime * m_speed;
     }
-    else if (GLFW_PRESS == glfwGetKey(a_window, GLFW_KEY_RIGHT))
+    else if (l_rightTime > 0.0f)
     {
-        m_initialFov -= 0.1 * l_deltaTime * m_speed;
+        m_initialFov -= 0.1 * l_rightTime * m_speed;
     }
-    else if (GLFW_PRESS == glfwGetKey(a_window, GLFW_KEY_LEFT))
+    else if (l_leftTime > 0.0f)
     {
-        m_initialFov += 0.1 * l_deltaTime * m_speed;
+        m_initialFov += 0.1 * l_leftTime * m_speed;
     }
 
     // update projection matrix: Field of View, aspect ratio, display range : 0.1 unit <-> 100 units
@@ -68,6 +87,9 @@ void CCamera::ComputeMatricesFromWindow(GLFWwindow* a_window)
 void CCamera::ComputeStereoMatricesFromWindow(
     GLFWwindow* a_window, float a_IOD, float a_zDepth, bool a_isLeftEye)
 {
+    // the stereo view does not move, but the queue must not fill up
+    p_ApplyInput(m_lastTime);
+
     int l_width, l_height;
     glfwGetWindowSize(a_window, &l_width, &l_height);
 
@@ -97,3 +119,48 @@ void CCamera::ComputeStereoMatricesFromWindow(
         l_up // up direction
     );
 }
+
+// replays the queued key events since the last frame, which started at
+// a_frameStart; m_keyHeld gets how long the keys released in it were down
+void CCamera::p_ApplyInput(double a_frameStart)
+{
+    // taps of the previous frame are used up, or were not asked for
+    std::fill(m_keyHeld, m_keyHeld + GLFW_KEY_LAST + 1, 0.0);
+    SInputEvent l_event;
+    while (m_input && m_input->Pop(&l_event))
+    {
+        if (l_event.type != INPUT_KEY || l_event.code < 0 || l_event.code > GLFW_KEY_LAST ||
+            l_event.action == GLFW_REPEAT)
+        {
+            continue;
+        }
+        const int l_key = l_event.code;
+        if (l_event.action == GLFW_PRESS && !m_keyDown[l_key])
+        {
+            m_keyDown[l_key] = true;
+            m_keyDownSince[l_key] = l_event.time;
+        }
+        else if (l_event.action == GLFW_RELEASE && m_keyDown[l_key])
+        {
+            // a tap shorter than a frame still counts
+            m_keyDown[l_key] = false;
+            m_keyHeld[l_key] += l_event.time - std::max(m_keyDownSince[l_key], a_frameStart);
+        }
+    }
+}
+
+// seconds a_key was down from a_frameStart to a_frameEnd; a whole frame for
+// a polled key that is down now
+float CCamera::p_HeldTime(GLFWwindow* a_window, int a_key, double a_frameStart, double a_frameEnd)
+{
+    if (!m_input)
+    {
+        return GLFW_PRESS == glfwGetKey(a_window, a_key) ? float(a_frameEnd - a_frameStart) : 0.0f;
+    }
+    double l_held = m_keyHeld[a_key];
+    if (m_keyDown[a_key])
+    {
+        l_held += a_frameEnd - std::max(m_keyDownSince[a_key], a_frameStart);
+    }
+    return float(std::max(l_held, 0.0));
+}
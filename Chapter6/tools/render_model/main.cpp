@@ -8,8 +8,13 @@ float g_rotateX = 0.0f;
 float g_rotateY = 0.0f;
 float g_zDepth = 5.0f;
 
+// key events for the camera, applied once per frame
+CInputQueue g_input;
+
 static void KeyCallback(GLFWwindow* a_window, int a_key, int a_scancode, int a_action, int a_mods)
 {
+    g_input.PushKey(a_key, a_scancode, a_action, a_mods, glfwGetTime());
+
     if (a_action != GLFW_PRESS && a_action != GLFW_REPEAT)
     {
         return;
@@ -112,25 +117,23 @@ int main(int argc, char const *argv[])
         exit(EXIT_FAILURE);
     }
 
-    GLuint l_programId = LoadShaders("../tools/render_model/pointcloud.vert", "../tools/render_model/pointcloud.frag");
+    // compiled in the background and reloaded whenever a file is saved
+    CShaderManager l_shaders;
+    size_t l_shader = l_shaders.Add("../tools/render_model/pointcloud.vert", "../tools/render_model/pointcloud.frag");
+    GLuint l_programId = 0;
 
     glDisable(GL_DEPTH_TEST);
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    // get the location for our "Model View Projection" uniform variable
-	GLuint l_mvpMatrixId = glGetUniformLocation(l_programId, "MVP");
-
-    // use our shader
-    glUseProgram(l_programId);
+    // the uniform and attribute locations of the current program
+    GLuint l_mvpMatrixId = 0;
+    GLint l_attributeVertexLoc = -1;
 
     // use a large buffer to store the entire scene
     GLfloat	*l_vertexBufferData = (GLfloat*) malloc(l_loader.GetNumVertices()*sizeof(GLfloat));
     l_loader.LoadVertices(l_vertexBufferData);
 
-    // Get the location of the attribute variables
-    GLint l_attributeVertexLoc = glGetAttribLocation(l_programId, "vertexPosition_modelspace");
-
     // Generate the vertex array object VAO (dependency GLEW)
     GLuint l_vertexArrayId;
     glGenVertexArrays(1, &l_vertexArrayId);
@@ -143,16 +146,12 @@ int main(int argc, char const *argv[])
     // Load data
     glBufferData(GL_ARRAY_BUFFER, l_loader.GetNumVertices()*sizeof(GLfloat), l_vertexBufferData, GL_STATIC_DRAW);
 
-    // 1st attribute buffer : vertices for position
-    glEnableVertexAttribArray(l_attributeVertexLoc);
-    glBindBuffer(GL_ARRAY_BUFFER, l_vertexBuffer);
-    glVertexAttribPointer(l_attributeVertexLoc, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
-
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glPointSize(3.0f);
 
     bool l_stereo = true;
     CCamera l_camera;
+    l_camera.SetInputQueue(&g_input);
 
     const float l_IPD = 0.65f;
     while (!glfwWindowShouldClose(l_window))
@@ -161,6 +160,31 @@ int main(int argc, char const *argv[])
         glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);
 
+        // switch to a program that finished compiling; locations can differ
+        // between two versions of the same shader
+        if (l_shaders.Update())
+        {
+            if (l_attributeVertexLoc >= 0)
+            {
+                glDisableVertexAttribArray(l_attributeVertexLoc);
+            }
+            l_programId = l_shaders.Program(l_shader);
+
+            // use our shader
+            glUseProgram(l_programId);
+
+            // get the location for our "Model View Projection" uniform variable
+            l_mvpMatrixId = glGetUniformLocation(l_programId, "MVP");
+
+            // Get the location of the attribute variables
+            l_attributeVertexLoc = glGetAttribLocation(l_programId, "vertexPosition_modelspace");
+
+            // 1st attribute buffer : vertices for position
+            glEnableVertexAttribArray(l_attributeVertexLoc);
+            glBindBuffer(GL_ARRAY_BUFFER, l_vertexBuffer);
+            glVertexAttribPointer(l_attributeVertexLoc, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+        }
+
         int l_width, l_height;
         /*
          * You are passing the window size, which is in screen coordinates,
@@ -171,7 +195,8 @@ int main(int argc, char const *argv[])
          */
          glfwGetFramebufferSize(l_window, &l_width, &l_height);
 
-         if (l_stereo)
+         // nothing to draw with until the first program has linked
+         if (l_programId && l_stereo)
          {
              // left eye, left half of screen
              bool l_isLeftEye = true;
@@ -251,7 +276,7 @@ int main(int argc, char const *argv[])
                  l_loader.Draw(GL_TRIANGLES);
              }
          }
-         else
+         else if (l_programId)
          {
              // Not stereo
              glViewport(0, 0, l_width, l_height);
@@ -293,9 +318,14 @@ int main(int argc, char const *argv[])
 
         // Swap the front and back buffers (GLFW uses double buffering) to update the screen and process all pending events:
         glfwSwapBuffers(l_window);
+        g_input.FramePresented(glfwGetTime());
         glfwPollEvents();
     }
 
+    printf("Input to present: %.1f ms mean, %.1f ms max over %llu frames\n",
+           g_input.MeanLatency() * 1000.0, g_input.MaxLatency() * 1000.0,
+           (unsigned long long)g_input.LatencySamples());
+
     // Release the memory and terminate the GLFW library.
     glfwDestroyWindow(l_window);
     glfwTerminate();